@@ -0,0 +1,260 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "PayloadC.h"
+
+#include "miro/LogWriter.h"
+#include "miro/LogReader.h"
+#include "miro/Parameters.h"
+#include "miro/StructuredPushSupplier.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <tao/ORB.h>
+
+#include <ace/Get_Opt.h>
+#include <ace/High_Res_Timer.h>
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_stdlib.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+// Benchmark of the block compressed log file format.
+//
+// For each payload, the same events are written into an uncompressed
+// and into a compressed log file. Reported are the compression ratio
+// and the throughput of writing and of reading back the events.
+
+enum PayloadID {
+  OCTET_STREAM_1K, OCTET_STREAM_100K,
+  INT_ARRAY_1K, INT_ARRAY_10K,
+  RANGE_SCAN
+};
+
+const unsigned int NUM_PAYLOADS = 5;
+char const * const payloadName[NUM_PAYLOADS] = {
+  "OctetStream1K",
+  "OctetStream100K",
+  "IntArray1K",
+  "IntArray10K",
+  "RangeScan"
+};
+
+bool verbose = false;
+int iterations = 10000;
+std::string fileName = "CompressionPerformance.mlog";
+unsigned long blockSize = 256 * 1024;
+int level = 1;
+
+void
+producePayload(PayloadID _payload, unsigned int _n, CosNotification::StructuredEvent& _event)
+{
+  switch(_payload) {
+  case OCTET_STREAM_1K:
+  case OCTET_STREAM_100K:
+    {
+      OctStr_var load = new OctStr;
+      load->length((_payload == OCTET_STREAM_1K)? 1024 : 1024 * 100);
+      for (unsigned int i = 0; i < load->length(); ++i)
+        load[i] = (CORBA::Octet) (i + _n);
+      _event.remainder_of_body <<= load._retn();
+      break;
+    }
+  case INT_ARRAY_1K:
+    {
+      I1K * load = new I1K();
+      for (unsigned int i = 0; i < 256; ++i)
+        load->array[i] = i + _n;
+      _event.remainder_of_body <<= load;
+      break;
+    }
+  case INT_ARRAY_10K:
+    {
+      I10K * load = new I10K();
+      for (unsigned int i = 0; i < 2560; ++i)
+        load->array[i] = i + _n;
+      _event.remainder_of_body <<= load;
+      break;
+    }
+  case RANGE_SCAN:
+    {
+      // smooth contour with sensor noise, in mm
+      I1K * load = new I1K();
+      for (unsigned int i = 0; i < 256; ++i)
+        load->array[i] = (CORBA::Long)(3000. + 1000. * std::sin((i + _n) * 0.05)) +
+          ACE_OS::rand() % 20;
+      _event.remainder_of_body <<= load;
+      break;
+    }
+  }
+}
+
+double
+seconds(ACE_hrtime_t _start, ACE_hrtime_t _end)
+{
+  ACE_UINT32 gsf = ACE_High_Res_Timer::global_scale_factor();
+  return (double)(_end - _start) / (double)gsf / 1000000.;
+}
+
+size_t
+fileSize(std::string const& _name)
+{
+  ACE_stat st;
+  if (ACE_OS::stat(_name.c_str(), &st) == -1)
+    throw Miro::CException(errno, "Stat of " + _name);
+  return st.st_size;
+}
+
+void
+measure(PayloadID _payload, bool _compress, size_t& _rawSize)
+{
+  Miro::LogNotifyParameters parameters;
+  parameters.compress = _compress;
+  parameters.blockSize = blockSize;
+  parameters.compressionLevel = level;
+  parameters.maxFileSize = 0xffffffffUL;
+
+  // prepare the events, so payload construction is not measured
+  std::vector<CosNotification::StructuredEvent> events(iterations);
+  for (int i = 0; i < iterations; ++i) {
+    Miro::StructuredPushSupplier::initStructuredEvent(events[i], "Miro", payloadName[_payload]);
+    producePayload(_payload, i, events[i]);
+  }
+
+  ACE_hrtime_t start = ACE_OS::gethrtime();
+  {
+    Miro::LogWriter writer(fileName, parameters);
+    for (int i = 0; i < iterations; ++i) {
+      if (!writer.logEvent(ACE_Time_Value(i / 1000, (i % 1000) * 1000), events[i]))
+        throw Miro::Exception("Log file full.");
+    }
+  }
+  ACE_hrtime_t written = ACE_OS::gethrtime();
+
+  size_t const size = fileSize(fileName);
+  if (!_compress)
+    _rawSize = size;
+
+  ACE_hrtime_t readStart = ACE_OS::gethrtime();
+  {
+    Miro::LogReader reader(fileName);
+    CosNotification::StructuredEvent event;
+    for (ACE_UINT32 i = 0; i < reader.indexSize(); ++i) {
+      reader.seekEvent(i);
+      if (!reader.parseEventHeader(event.header.fixed_header) ||
+          !reader.parseEventBody(event))
+        throw Miro::Exception("Error reading back event.");
+    }
+  }
+  ACE_hrtime_t readEnd = ACE_OS::gethrtime();
+
+  double const mb = (double)_rawSize / (1024. * 1024.);
+  std::cout << payloadName[_payload] << "\t"
+            << ((_compress)? "compressed" : "raw") << "\t"
+            << size << "\t"
+            << (double)_rawSize / (double)size << "\t"
+            << mb / seconds(start, written) << "\t"
+            << mb / seconds(readStart, readEnd) << std::endl;
+
+  ACE_OS::unlink(fileName.c_str());
+}
+
+int
+parseArgs(int& argc, char* argv[])
+{
+  ACE_Get_Opt get_opts (argc, argv, "b:f:l:n:v?");
+
+  int rc = 0;
+  int c;
+
+  while ((c = get_opts()) != -1) {
+    switch (c) {
+    case 'b':
+      blockSize = atoi(get_opts.optarg);
+      break;
+    case 'f':
+      fileName = get_opts.optarg;
+      break;
+    case 'l':
+      level = atoi(get_opts.optarg);
+      break;
+    case 'n':
+      iterations = atoi(get_opts.optarg);
+      break;
+    case 'v':
+      verbose = true;
+      break;
+    case '?':
+    default:
+      std::cerr << "usage: " << argv[0] << "[-bflnv?]" << std::endl
+                << "  -b <bytes> block size of the compressed log" << std::endl
+                << "  -f <file name> log file name" << std::endl
+                << "  -l <level> compression level" << std::endl
+                << "  -n <iterations> number of events per payload" << std::endl
+                << "  -v verbose mode" << std::endl
+                << "  -? help: emit this text and stop" << std::endl;
+      rc = -1;
+    }
+  }
+
+  if (verbose) {
+    std::cout << "iterations: " << iterations << std::endl
+              << "block size: " << blockSize << std::endl
+              << "compression level: " << level << std::endl;
+  }
+  return rc;
+}
+
+int
+main(int argc, char * argv[])
+{
+  int rc = 1;
+
+  try {
+    Miro::Log::init(argc, argv);
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    if (parseArgs(argc, argv) != 0)
+      return 1;
+
+    std::cout << "payload\tformat\tbytes\tratio\twrite [MB/s]\tread [MB/s]" << std::endl;
+
+    for (unsigned int i = 0; i < NUM_PAYLOADS; ++i) {
+      size_t rawSize = 0;
+      measure((PayloadID)i, false, rawSize);
+      measure((PayloadID)i, true, rawSize);
+    }
+
+    orb->destroy();
+    rc = 0;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncought CORBA exception:\n" << e << std::endl;
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Uncought Miro exception:\n" << e << std::endl;
+  }
+  return rc;
+}
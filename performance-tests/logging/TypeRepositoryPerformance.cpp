@@ -0,0 +1,194 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogTypeRepository.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <tao/ORB.h>
+#include <tao/TypeCodeFactory/TypeCodeFactory_Loader.h>
+#include <tao/IFR_Client/IFR_BasicC.h>
+
+#include <ace/Get_Opt.h>
+#include <ace/High_Res_Timer.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// Micro-benchmark of the type id lookup of the log type repository.
+//
+// For a growing number of known types, the per-event lookup cost is
+// measured for type code instances already seen (static type codes of
+// the IDL stubs) and for freshly demarshalled instances (as delivered
+// by the notification channel within a TAO::Unknown_IDL_Type).
+
+typedef std::vector<CORBA::TypeCode_ptr> TCVector;
+
+bool verbose = false;
+int iterations = 100000;
+unsigned int maxTypes = 400;
+
+CORBA::TypeCode_ptr
+createType(CORBA::ORB_ptr _orb, unsigned int _n)
+{
+  std::ostringstream id;
+  std::ostringstream name;
+  id << "IDL:Miro/Benchmark/Type" << _n << ":1.0";
+  name << "Type" << _n;
+
+  CORBA::StructMemberSeq members;
+  members.length(3);
+  members[0].name = CORBA::string_dup("time");
+  members[0].type = CORBA::TypeCode::_duplicate(CORBA::_tc_ulonglong);
+  members[1].name = CORBA::string_dup("value");
+  members[1].type = CORBA::TypeCode::_duplicate(CORBA::_tc_double);
+  members[2].name = CORBA::string_dup("data");
+  members[2].type = _orb->create_sequence_tc(0, CORBA::_tc_octet);
+
+  return _orb->create_struct_tc(id.str().c_str(), name.str().c_str(), members);
+}
+
+CORBA::TypeCode_ptr
+demarshal(CORBA::TypeCode_ptr _tc)
+{
+  TAO_OutputCDR ostr;
+  ostr << _tc;
+  TAO_InputCDR istr(ostr);
+  CORBA::TypeCode_ptr tc;
+  if (!(istr >> tc))
+    throw Miro::Exception("Failed to demarshal type code.");
+  return tc;
+}
+
+double
+measure(Miro::LogTypeRepository& _repository, TCVector const& _types)
+{
+  ACE_hrtime_t start = ACE_OS::gethrtime();
+  for (int i = 0; i < iterations; ++i) {
+    _repository.typeID(_types[i % _types.size()]);
+  }
+  ACE_hrtime_t end = ACE_OS::gethrtime();
+
+  ACE_UINT32 gsf = ACE_High_Res_Timer::global_scale_factor();
+  return (double)(end - start) / (double)gsf * 1000. / (double)iterations;
+}
+
+int
+parseArgs(int& argc, char* argv[])
+{
+  ACE_Get_Opt get_opts (argc, argv, "n:t:v?");
+
+  int rc = 0;
+  int c;
+
+  while ((c = get_opts()) != -1) {
+    switch (c) {
+    case 'n':
+      iterations = atoi(get_opts.optarg);
+      break;
+    case 't':
+      maxTypes = atoi(get_opts.optarg);
+      break;
+    case 'v':
+      verbose = true;
+      break;
+    case '?':
+    default:
+      std::cerr << "usage: " << argv[0] << "[-ntv?]" << std::endl
+                << "  -n <iterations> number of lookups per measurement" << std::endl
+                << "  -t <types> maximum number of types in the repository" << std::endl
+                << "  -v verbose mode" << std::endl
+                << "  -? help: emit this text and stop" << std::endl;
+      rc = -1;
+    }
+  }
+
+  if (verbose) {
+    std::cout << "iterations: " << iterations << std::endl
+              << "max types: " << maxTypes << std::endl;
+  }
+  return rc;
+}
+
+int
+main(int argc, char * argv[])
+{
+  int rc = 1;
+
+  try {
+    Miro::Log::init(argc, argv);
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    if (parseArgs(argc, argv) != 0)
+      return 1;
+
+    std::cout << "types\tstatic [ns/event]\tdemarshalled [ns/event]" << std::endl;
+
+    for (unsigned int numTypes = 1; numTypes <= maxTypes; numTypes *= 2) {
+      TCVector types;
+      TCVector copies;
+      for (unsigned int i = 0; i < numTypes; ++i) {
+        types.push_back(createType(orb.in(), i));
+        copies.push_back(demarshal(types.back()));
+      }
+
+      TAO_OutputCDR ostr(16 * 1024 * 1024);
+      Miro::LogTypeRepository repository(&ostr, 16 * 1024 * 1024);
+
+      // register all types, the last one is the worst case for a linear search
+      for (unsigned int i = 0; i < numTypes; ++i) {
+        repository.typeID(types[i]);
+      }
+
+      TCVector lastStatic(1, types.back());
+      TCVector lastCopy(1, copies.back());
+
+      double staticCost = measure(repository, lastStatic);
+      double copyCost = measure(repository, lastCopy);
+
+      // demarshalled instances are new for every event in practice
+      double freshCost = 0.;
+      if (copies.size() > 1) {
+        freshCost = measure(repository, copies);
+      }
+
+      std::cout << numTypes << "\t"
+                << staticCost << "\t"
+                << copyCost << " (" << freshCost << " round robin)" << std::endl;
+
+      for (unsigned int i = 0; i < numTypes; ++i) {
+        CORBA::release(types[i]);
+        CORBA::release(copies[i]);
+      }
+    }
+
+    orb->destroy();
+    rc = 0;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncought CORBA exception:\n" << e << std::endl;
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Uncought Miro exception:\n" << e << std::endl;
+  }
+  return rc;
+}
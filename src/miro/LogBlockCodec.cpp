@@ -0,0 +1,104 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogBlockCodec.h"
+#include "MiroConfig.h"
+
+#if MIRO_HAS_ZLIB
+#  include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+
+namespace Miro
+{
+  bool
+  LogBlockCodec::available() throw()
+  {
+#if MIRO_HAS_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  size_t
+  LogBlockCodec::bound(size_t _length) throw()
+  {
+#if MIRO_HAS_ZLIB
+    return std::max(static_cast<size_t>(compressBound(_length)), _length);
+#else
+    return _length;
+#endif
+  }
+
+  ACE_UINT32
+  LogBlockCodec::compress(int _level,
+                          char const * _src, size_t _length,
+                          char * _dest, size_t& _destLength) throw()
+  {
+#if MIRO_HAS_ZLIB
+    uLongf length = bound(_length);
+    if (compress2(reinterpret_cast<Bytef *>(_dest), &length,
+                  reinterpret_cast<Bytef const *>(_src), _length,
+                  _level) == Z_OK &&
+        length < _length) {
+      _destLength = length;
+      return CODEC_ZLIB;
+    }
+#else
+    ACE_UNUSED_ARG(_level);
+#endif
+    memcpy(_dest, _src, _length);
+    _destLength = _length;
+    return CODEC_NONE;
+  }
+
+  void
+  LogBlockCodec::decompress(ACE_UINT32 _codec,
+                            char const * _src, size_t _length,
+                            char * _dest, size_t _rawLength) throw(Exception)
+  {
+    if (_codec == CODEC_NONE) {
+      if (_length != _rawLength)
+        throw Exception("Stored log block length mismatch.");
+      memcpy(_dest, _src, _length);
+      return;
+    }
+#if MIRO_HAS_ZLIB
+    if (_codec == CODEC_ZLIB) {
+      uLongf length = _rawLength;
+      int rc = uncompress(reinterpret_cast<Bytef *>(_dest), &length,
+                          reinterpret_cast<Bytef const *>(_src), _length);
+      if (rc != Z_OK || length != _rawLength) {
+        std::ostringstream o;
+        o << "Error inflating log block: " << rc;
+        throw Exception(o.str());
+      }
+      return;
+    }
+#endif
+    std::ostringstream o;
+    o << "Unsupported log block codec: " << _codec;
+    throw Exception(o.str());
+  }
+}
@@ -0,0 +1,76 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogBlockCodec_h
+#define miro_LogBlockCodec_h
+
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <ace/Basic_Types.h>
+
+#include <cstddef>
+
+namespace Miro
+{
+  //! Compression of the event blocks of compressed log files.
+  /**
+   * The codec used is noted in the header of each block, so a reader
+   * can decompress all blocks, while the writer is free to fall back
+   * to storing a block uncompressed.
+   */
+  class miro_Export LogBlockCodec
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    //! The block is stored uncompressed.
+    static ACE_UINT32 const CODEC_NONE = 0;
+    //! The block is deflated by zlib.
+    static ACE_UINT32 const CODEC_ZLIB = 1;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Flag indicating compression support of this build.
+    static bool available() throw();
+    //! Maximum size of a compressed block of @ref _length bytes.
+    static size_t bound(size_t _length) throw();
+    //! Compress a block.
+    /**
+     * @param _level Compression level, 1 (fast) to 9 (best).
+     * @param _dest Has to hold at least bound(_length) bytes.
+     * @param _destLength Set to the length of the compressed block.
+     * Returns the codec used. Blocks that do not shrink are stored.
+     */
+    static ACE_UINT32 compress(int _level,
+                               char const * _src, size_t _length,
+                               char * _dest, size_t& _destLength) throw();
+    //! Decompress a block of exactly @ref _rawLength bytes.
+    static void decompress(ACE_UINT32 _codec,
+                           char const * _src, size_t _length,
+                           char * _dest, size_t _rawLength) throw(Exception);
+  };
+}
+#endif // miro_LogBlockCodec_h
@@ -0,0 +1,432 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogColumnExporter.h"
+#include "LogReader.h"
+#include "LogCursor.h"
+#include "Log.h"
+
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_sys_stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+
+namespace Miro
+{
+  namespace
+  {
+    //! Size of the buffered values, that triggers a flush.
+    size_t const FLUSH_SIZE = 4 * 1024 * 1024;
+    //! Lower bound of the flush size per type.
+    size_t const MIN_FLUSH_SIZE = 64 * 1024;
+    //! Number of events between checks of the buffered size.
+    unsigned int const FLUSH_CHECK = 256;
+
+    char const * const kindName[] = { "value", "offsets", "string", "chars" };
+
+    //! Quoted and escaped JSON string.
+    std::string
+    jsonString(std::string const& _string)
+    {
+      std::ostringstream ostr;
+      ostr << '"';
+      std::string::const_iterator first, last = _string.end();
+      for (first = _string.begin(); first != last; ++first) {
+        unsigned char const c = static_cast<unsigned char>(*first);
+        if (c == '"' || c == '\\')
+          ostr << '\\' << *first;
+        else if (c < 0x20)
+          ostr << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+               << static_cast<unsigned int>(c) << std::dec;
+        else
+          ostr << *first;
+      }
+      ostr << '"';
+      return ostr.str();
+    }
+
+    //! Create a directory, unless it exists.
+    void
+    makeDirectory(std::string const& _directory) throw(Exception)
+    {
+      if (ACE_OS::mkdir(_directory.c_str()) == -1 && errno != EEXIST)
+        throw CException(errno, "Creating " + _directory + ": " + strerror(errno));
+    }
+  }
+
+  LogColumnExporter::LogColumnExporter(std::string const& _fileName) throw(Exception) :
+    fileName_(_fileName),
+    workers_(0),
+    next_(0),
+    events_(0)
+  {
+    MIRO_LOG_CTOR("Miro::LogColumnExporter");
+
+    // the plans are compiled once per type id
+    LogReader reader(fileName_);
+    CORBA::TypeCode_ptr tc;
+    for (ACE_INT32 id = 0; (tc = reader.typeCode(id)) != CORBA::_tc_null; ++id) {
+      LogColumnPlan * plan = NULL;
+      try {
+        plan = new LogColumnPlan(tc);
+      }
+      catch (Exception const& e) {
+        MIRO_LOG_OSTR(LL_WARNING,
+                      "LogColumnExporter - Type id " << id << " not exported: " << e);
+      }
+      plans_.push_back(plan);
+    }
+  }
+
+  LogColumnExporter::~LogColumnExporter()
+  {
+    MIRO_LOG_DTOR("Miro::LogColumnExporter");
+
+    PlanVector::const_iterator first, last = plans_.end();
+    for (first = plans_.begin(); first != last; ++first)
+      delete *first;
+  }
+
+  void
+  LogColumnExporter::select(std::string const& _typeName)
+  {
+    selected_.push_back(_typeName);
+  }
+
+  bool
+  LogColumnExporter::selected(ACE_INT32 _typeId) const
+  {
+    if (selected_.empty())
+      return true;
+
+    std::string name;
+    std::string id;
+    try {
+      name = plans_[_typeId]->type()->name();
+      id = plans_[_typeId]->type()->id();
+    }
+    catch (CORBA::Exception const&) {
+      // anonymous types, like sequences
+    }
+    return
+      std::find(selected_.begin(), selected_.end(), name) != selected_.end() ||
+      std::find(selected_.begin(), selected_.end(), id) != selected_.end();
+  }
+
+  std::string
+  LogColumnExporter::typeDirectory(ACE_INT32 _typeId) const
+  {
+    std::string name;
+    try {
+      if (plan(_typeId) != NULL)
+        name = plans_[_typeId]->type()->name();
+    }
+    catch (CORBA::Exception const&) {
+    }
+    if (name.empty())
+      name = "type";
+
+    std::ostringstream ostr;
+    std::string::const_iterator first, last = name.end();
+    for (first = name.begin(); first != last; ++first)
+      ostr << ((isalnum(static_cast<unsigned char>(*first)) || *first == '_')? *first : '_');
+    ostr << "-" << _typeId;
+    return ostr.str();
+  }
+
+  std::string
+  LogColumnExporter::columnFile(unsigned int _column)
+  {
+    std::ostringstream ostr;
+    ostr << "c" << std::setw(4) << std::setfill('0') << _column << ".bin";
+    return ostr.str();
+  }
+
+  ACE_UINT64
+  LogColumnExporter::exportTypes(std::string const& _directory, int _threads) throw(Exception)
+  {
+    makeDirectory(_directory);
+
+    directory_ = _directory;
+    pending_.clear();
+    for (ACE_INT32 id = 0; id < types(); ++id) {
+      if (plans_[id] != NULL && selected(id))
+        pending_.push_back(id);
+    }
+    next_ = 0;
+    events_ = 0;
+    error_.clear();
+
+    if (_threads <= 0)
+      _threads = ACE_OS::num_processors_online();
+    if (_threads <= 0)
+      _threads = 1;
+    if (static_cast<size_t>(_threads) > pending_.size())
+      _threads = pending_.size();
+    workers_ = _threads;
+
+    if (_threads != 0) {
+      if (activate(THR_NEW_LWP | THR_JOINABLE, _threads) == -1)
+        throw CException(errno, "LogColumnExporter - Failed to spawn worker threads.");
+      wait();
+    }
+
+    if (!error_.empty())
+      throw Exception(error_);
+    return events_;
+  }
+
+  int
+  LogColumnExporter::svc()
+  {
+    unsigned int worker;
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      worker = next_++;
+    }
+
+    // the types are dealt round robin to the workers
+    ExportVector exports;
+    for (unsigned int i = worker; i < pending_.size(); i += workers_) {
+      exports.push_back(TypeExport());
+      TypeExport& type = exports.back();
+      type.typeId = pending_[i];
+      type.directory = directory_ + "/" + typeDirectory(type.typeId);
+      type.events = 0;
+      type.failed = 0;
+      plans_[type.typeId]->init(type.buffers);
+    }
+
+    try {
+      ExportVector::const_iterator first, last = exports.end();
+      for (first = exports.begin(); first != last; ++first)
+        createFiles(*first);
+
+      LogReader reader(fileName_);
+      reader.access(LogReader::SEQUENTIAL);
+      exportPass(reader, exports);
+
+      ACE_UINT64 events = 0;
+      for (first = exports.begin(); first != last; ++first) {
+        if (first->failed != 0) {
+          MIRO_LOG_OSTR(LL_WARNING,
+                        "LogColumnExporter - " << first->failed << " events of " <<
+                        first->directory << " failed to decode.");
+        }
+        writeSchema(first->directory, first->typeId, first->buffers, first->events);
+        events += first->events;
+      }
+
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      events_ += events;
+    }
+    catch (Exception const& e) {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      if (error_.empty())
+        error_ = e.what();
+    }
+
+    return 0;
+  }
+
+  void
+  LogColumnExporter::createFiles(TypeExport const& _export) const throw(Exception)
+  {
+    makeDirectory(_export.directory);
+
+    // the files are reopened per flush, as many types would exhaust the handles
+    for (unsigned int i = 0; i < _export.buffers.data.size(); ++i) {
+      std::string const name = _export.directory + "/" + columnFile(i);
+      ACE_HANDLE const handle =
+        ACE_OS::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, ACE_DEFAULT_FILE_PERMS);
+      if (handle == ACE_INVALID_HANDLE)
+        throw CException(errno, "Opening " + name + ": " + strerror(errno));
+      ACE_OS::close(handle);
+    }
+  }
+
+  void
+  LogColumnExporter::exportPass(LogReader& _reader, ExportVector& _exports) throw(Exception)
+  {
+    // index into the exports by type id, -1 for the types of other workers
+    std::vector<int> route(plans_.size(), -1);
+    for (unsigned int i = 0; i < _exports.size(); ++i)
+      route[_exports[i].typeId] = i;
+
+    // the flush size is shared by the types of the worker
+    size_t const flushSize = std::max(FLUSH_SIZE / std::max(_exports.size(), size_t(1)),
+                                      MIN_FLUSH_SIZE);
+    unsigned int decoded = 0;
+
+    LogCursor cursor(_reader);
+    while (cursor.next()) {
+      LogRecord const& record = cursor.record();
+      if (record.typeId < 0 ||
+          record.typeId >= static_cast<ACE_INT32>(route.size()) ||
+          route[record.typeId] < 0)
+        continue;
+
+      TypeExport& type = _exports[route[record.typeId]];
+
+      // the CDR stream of the reader aligns relative to the log file,
+      // as the body was marshalled
+      _reader.rdPtr(record.body);
+      ACE_INT64 const stamp =
+        static_cast<ACE_INT64>(record.stamp.sec()) * 1000000 + record.stamp.usec();
+      if (!plans_[type.typeId]->decode(stamp, cursor.number(), *_reader.istr(), type.buffers)) {
+        ++type.failed;
+        continue;
+      }
+      ++type.events;
+
+      if (++decoded % FLUSH_CHECK == 0) {
+        {
+          // another worker failed
+          ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+          if (!error_.empty())
+            return;
+        }
+
+        ExportVector::iterator first, last = _exports.end();
+        for (first = _exports.begin(); first != last; ++first) {
+          size_t size = 0;
+          for (unsigned int i = 0; i < first->buffers.data.size(); ++i)
+            size += first->buffers.data[i].size();
+          if (size >= flushSize)
+            flush(*first);
+        }
+      }
+    }
+
+    ExportVector::iterator first, last = _exports.end();
+    for (first = _exports.begin(); first != last; ++first)
+      flush(*first);
+  }
+
+  void
+  LogColumnExporter::flush(TypeExport& _export) throw(Exception)
+  {
+    LogColumnPlan::Buffers& buffers = _export.buffers;
+    for (unsigned int i = 0; i < buffers.data.size(); ++i) {
+      std::vector<char>& data = buffers.data[i];
+      if (data.empty())
+        continue;
+
+      std::string const name = _export.directory + "/" + columnFile(i);
+      ACE_HANDLE const handle = ACE_OS::open(name.c_str(), O_WRONLY | O_APPEND);
+      if (handle == ACE_INVALID_HANDLE)
+        throw CException(errno, "Opening " + name + ": " + strerror(errno));
+
+      ssize_t const written = ACE_OS::write(handle, &data[0], data.size());
+      int const error = errno;
+      ACE_OS::close(handle);
+      if (written != static_cast<ssize_t>(data.size()))
+        throw CException(error, "Writing " + name + ": " + strerror(error));
+
+      // the capacity is kept for the next chunk
+      buffers.flushed[i] += data.size();
+      data.clear();
+    }
+  }
+
+  void
+  LogColumnExporter::writeSchema(std::string const& _directory, ACE_INT32 _typeId,
+                                 LogColumnPlan::Buffers const& _buffers,
+                                 ACE_UINT64 _events) const throw(Exception)
+  {
+    LogColumnPlan const& plan = *plans_[_typeId];
+    LogColumnPlan::TableVector const& tables = plan.tables();
+    LogColumnPlan::ColumnVector const& columns = plan.columns();
+    std::vector<std::string> const& skipped = plan.skipped();
+
+    std::string name;
+    std::string id;
+    try {
+      name = plan.type()->name();
+      id = plan.type()->id();
+    }
+    catch (CORBA::Exception const&) {
+    }
+
+    std::ostringstream ostr;
+    ostr << "{" << std::endl
+         << "  \"log\": " << jsonString(fileName_) << "," << std::endl
+         << "  \"typeId\": " << _typeId << "," << std::endl
+         << "  \"name\": " << jsonString(name) << "," << std::endl
+         << "  \"repositoryId\": " << jsonString(id) << "," << std::endl
+         << "  \"byteOrder\": " << jsonString((ACE_CDR_BYTE_ORDER)? "little" : "big") << "," << std::endl
+         << "  \"events\": " << _events << "," << std::endl;
+
+    ostr << "  \"tables\": [" << std::endl;
+    for (unsigned int i = 0; i < tables.size(); ++i) {
+      ostr << "    {\"name\": " << jsonString(tables[i].name)
+           << ", \"rows\": " << _buffers.rows[i];
+      if (i != 0) {
+        ostr << ", \"parent\": " << tables[i].parent
+             << ", \"offsets\": " << tables[i].offsets;
+      }
+      ostr << "}" << ((i + 1 < tables.size())? "," : "") << std::endl;
+    }
+    ostr << "  ]," << std::endl;
+
+    ostr << "  \"columns\": [" << std::endl;
+    for (unsigned int i = 0; i < columns.size(); ++i) {
+      LogColumnPlan::Column const& column = columns[i];
+      ostr << "    {\"name\": " << jsonString(column.name)
+           << ", \"table\": " << column.table
+           << ", \"kind\": " << jsonString(kindName[column.kind])
+           << ", \"dtype\": " << jsonString(LogColumnPlan::dtype(column))
+           << ", \"file\": " << jsonString(columnFile(i))
+           << ", \"length\": " << _buffers.flushed[i] / column.size;
+      if (column.kind == LogColumnPlan::OFFSETS)
+        ostr << ", \"child\": " << column.child;
+      else if (column.kind == LogColumnPlan::STRING)
+        ostr << ", \"chars\": " << column.child;
+      if (!column.enumerators.empty()) {
+        ostr << ", \"enumerators\": [";
+        for (unsigned int j = 0; j < column.enumerators.size(); ++j)
+          ostr << ((j != 0)? ", " : "") << jsonString(column.enumerators[j]);
+        ostr << "]";
+      }
+      ostr << "}" << ((i + 1 < columns.size())? "," : "") << std::endl;
+    }
+    ostr << "  ]," << std::endl;
+
+    ostr << "  \"skipped\": [";
+    for (unsigned int i = 0; i < skipped.size(); ++i)
+      ostr << ((i != 0)? ", " : "") << jsonString(skipped[i]);
+    ostr << "]" << std::endl
+         << "}" << std::endl;
+
+    std::string const fileName = _directory + "/schema.json";
+    std::ofstream file(fileName.c_str());
+    file << ostr.str();
+    file.close();
+    if (file.fail())
+      throw Exception("Writing " + fileName + " failed.");
+  }
+}
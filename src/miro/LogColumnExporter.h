@@ -0,0 +1,172 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogColumnExporter_h
+#define miro_LogColumnExporter_h
+
+#include "LogColumnPlan.h"
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <ace/Task.h>
+#include <ace/Synch.h>
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  // forward declarations
+  class LogReader;
+
+  //! Exports the event bodies of a log file into column files.
+  /**
+   * The type codes of the log file are compiled into flattening plans
+   * (see @ref LogColumnPlan) once, cached by type id. Each exported
+   * type gets a directory <name>-<type id>, holding a raw file per
+   * column (cNNNN.bin) in host byte order, that can be memory mapped
+   * as is, and a JSON schema (schema.json) describing the tables and
+   * columns.
+   *
+   * The selected types are dealt round robin to a pool of worker
+   * threads, each with a reader of its own. A worker walks the event
+   * records once, by their length prefixes, routes each record by its
+   * type id to the buffers of its type, skipping the events of the
+   * types of other workers, and decodes the bodies straight from the
+   * log file. With a single worker, the log file is read once for all
+   * types. The columns are streamed to their files in chunks.
+   */
+  class miro_Export LogColumnExporter : public ACE_Task_Base
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor, compiles the plans of the log file.
+    LogColumnExporter(std::string const& _fileName) throw(Exception);
+    //! Cleaning up.
+    virtual ~LogColumnExporter();
+
+    //! Export the type of the name or repository id only.
+    /** Can be called several times. By default, all types are exported. */
+    void select(std::string const& _typeName);
+    //! Export the selected types into the directory.
+    /**
+     * Uses @ref _threads workers, 0 for one per cpu.
+     * Returns the number of events exported.
+     */
+    ACE_UINT64 exportTypes(std::string const& _directory, int _threads = 0) throw(Exception);
+
+    //! Number of type ids of the log file.
+    ACE_INT32 types() const throw();
+    //! The plan of the type id, NULL if the type can't be exported.
+    LogColumnPlan const * plan(ACE_INT32 _typeId) const throw();
+    //! Directory name of the columns of the type id.
+    std::string typeDirectory(ACE_INT32 _typeId) const;
+    //! File name of a column within the type directory.
+    static std::string columnFile(unsigned int _column);
+
+    //! Inherited method: the worker loop.
+    virtual int svc();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    typedef std::vector<LogColumnPlan *> PlanVector;
+
+    //! The export state of a type within a worker.
+    struct TypeExport
+    {
+      //! The type id.
+      ACE_INT32 typeId;
+      //! The directory of its columns.
+      std::string directory;
+      //! The values, since the last flush.
+      LogColumnPlan::Buffers buffers;
+      //! Number of events exported.
+      ACE_UINT64 events;
+      //! Number of events, that failed to decode.
+      ACE_UINT64 failed;
+    };
+    typedef std::vector<TypeExport> ExportVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Flag indicating the type id is to be exported.
+    bool selected(ACE_INT32 _typeId) const;
+    //! Create the directory and the empty column files of a type.
+    void createFiles(TypeExport const& _export) const throw(Exception);
+    //! Export the events of the types in one pass over the log file.
+    void exportPass(LogReader& _reader, ExportVector& _exports) throw(Exception);
+    //! Append the buffered values to the column files.
+    void flush(TypeExport& _export) throw(Exception);
+    //! Write the schema of the exported type.
+    void writeSchema(std::string const& _directory, ACE_INT32 _typeId,
+                     LogColumnPlan::Buffers const& _buffers,
+                     ACE_UINT64 _events) const throw(Exception);
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The log file.
+    std::string const fileName_;
+    //! The plans, indexed by type id.
+    PlanVector plans_;
+    //! Names of the types to export, empty for all.
+    std::vector<std::string> selected_;
+    //! The output directory of the running export.
+    std::string directory_;
+
+    //! Lock for the export state.
+    ACE_Thread_Mutex mutex_;
+    //! The type ids to export.
+    std::vector<ACE_INT32> pending_;
+    //! Number of workers.
+    unsigned int workers_;
+    //! Number of the next worker to start.
+    unsigned int next_;
+    //! Number of events exported.
+    ACE_UINT64 events_;
+    //! Error message of the first failed worker.
+    std::string error_;
+  };
+
+  inline
+  ACE_INT32
+  LogColumnExporter::types() const throw()
+  {
+    return static_cast<ACE_INT32>(plans_.size());
+  }
+
+  inline
+  LogColumnPlan const *
+  LogColumnExporter::plan(ACE_INT32 _typeId) const throw()
+  {
+    return (0 <= _typeId && _typeId < types())? plans_[_typeId] : NULL;
+  }
+}
+#endif // miro_LogColumnExporter_h
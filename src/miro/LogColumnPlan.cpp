@@ -0,0 +1,400 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogColumnPlan.h"
+
+#include <tao/Version.h>
+#if (TAO_MAJOR_VERSION > 1) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
+#  include <tao/AnyTypeCode/Marshal.h>
+#else
+#  include <tao/Marshal.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace Miro
+{
+  namespace
+  {
+    //! Nesting depth of the members, that are flattened.
+    unsigned int const MAX_DEPTH = 32;
+
+    //! Append a value in host byte order.
+    template<class T>
+    void
+    appendValue(std::vector<char>& _buffer, T const& _value)
+    {
+      size_t const offset = _buffer.size();
+      _buffer.resize(offset + sizeof(T));
+      memcpy(&_buffer[offset], &_value, sizeof(T));
+    }
+
+    //! Read @ref _n primitive values of @ref _size bytes into the buffer.
+    /**
+     * Floating point values are read as unsigned integers of the same
+     * size, which swaps their byte order just as well.
+     */
+    bool
+    readValues(TAO_InputCDR& _istr, size_t _size, ACE_CDR::ULong _n,
+               std::vector<char>& _buffer)
+    {
+      if (_n == 0)
+        return true;
+      if (_n > _istr.length() / _size)
+        return false;
+
+      // the column holds values of that size only, so they stay aligned
+      size_t const offset = _buffer.size();
+      _buffer.resize(offset + _n * _size);
+      char * const values = &_buffer[offset];
+
+      switch (_size) {
+      case 1:
+        return _istr.read_octet_array(reinterpret_cast<ACE_CDR::Octet *>(values), _n);
+      case 2:
+        return _istr.read_ushort_array(reinterpret_cast<ACE_CDR::UShort *>(values), _n);
+      case 4:
+        return _istr.read_ulong_array(reinterpret_cast<ACE_CDR::ULong *>(values), _n);
+      case 8:
+        return _istr.read_ulonglong_array(reinterpret_cast<ACE_CDR::ULongLong *>(values), _n);
+      }
+      return false;
+    }
+
+    //! Skip a value of the type.
+    bool
+    skipValue(CORBA::TypeCode_ptr _type, TAO_InputCDR& _istr)
+    {
+      try {
+#if (TAO_MAJOR_VERSION > 1) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
+        return TAO_Marshal_Object::perform_skip(_type, &_istr) == TAO::TRAVERSE_CONTINUE;
+#else
+        return TAO_Marshal_Object::perform_skip(_type, &_istr ACE_ENV_ARG_PARAMETER) ==
+          CORBA::TypeCode::TRAVERSE_CONTINUE;
+#endif
+      }
+      catch (CORBA::Exception const&) {
+        return false;
+      }
+    }
+
+    //! Size of a primitive value, 0 for other types.
+    size_t
+    primitiveSize(CORBA::TCKind _kind)
+    {
+      switch (_kind) {
+      case CORBA::tk_boolean:
+      case CORBA::tk_char:
+      case CORBA::tk_octet:
+        return 1;
+      case CORBA::tk_short:
+      case CORBA::tk_ushort:
+        return 2;
+      case CORBA::tk_long:
+      case CORBA::tk_ulong:
+      case CORBA::tk_float:
+      case CORBA::tk_enum:
+        return 4;
+      case CORBA::tk_longlong:
+      case CORBA::tk_ulonglong:
+      case CORBA::tk_double:
+        return 8;
+      default:
+        return 0;
+      }
+    }
+  }
+
+  LogColumnPlan::LogColumnPlan(CORBA::TypeCode_ptr _type) throw(Exception) :
+    type_(CORBA::TypeCode::_duplicate(_type))
+  {
+    Table const root = { "", 0, 0 };
+    tables_.push_back(root);
+    addColumn("_stamp", 0, VALUE, CORBA::tk_longlong, sizeof(ACE_INT64));
+    addColumn("_event", 0, VALUE, CORBA::tk_ulong, sizeof(ACE_UINT32));
+
+    try {
+      compile(_type, "", 0, ops_, 0);
+    }
+    catch (CORBA::Exception const& e) {
+      throw Exception(std::string("LogColumnPlan - Failed to compile type code: ") + e._name());
+    }
+  }
+
+  void
+  LogColumnPlan::compile(CORBA::TypeCode_ptr _type, std::string const& _path,
+                         unsigned int _table, OpVector& _ops, unsigned int _depth)
+  {
+    CORBA::TCKind const kind = _type->kind();
+    std::string const name = (_path.empty())? "value" : _path;
+
+    if (_depth > MAX_DEPTH) {
+      addSkip(_type, name, _ops);
+      return;
+    }
+
+    Op op;
+
+    switch (kind) {
+    case CORBA::tk_alias:
+      {
+        CORBA::TypeCode_var content = _type->content_type();
+        compile(content.in(), _path, _table, _ops, _depth);
+        return;
+      }
+    case CORBA::tk_struct:
+      {
+        // a recursive reference to a struct, that is being compiled
+        std::string const id = _type->id();
+        if (!id.empty() &&
+            std::find(compiling_.begin(), compiling_.end(), id) != compiling_.end()) {
+          addSkip(_type, name, _ops);
+          return;
+        }
+
+        compiling_.push_back(id);
+        for (CORBA::ULong i = 0; i < _type->member_count(); ++i) {
+          CORBA::TypeCode_var member = _type->member_type(i);
+          std::string const memberName = _type->member_name(i);
+          compile(member.in(), (_path.empty())? memberName : _path + "." + memberName,
+                  _table, _ops, _depth + 1);
+        }
+        compiling_.pop_back();
+        return;
+      }
+    case CORBA::tk_string:
+      {
+        op.kind = STRING_OP;
+        op.column = addColumn(name, _table, STRING, kind, sizeof(ACE_UINT64));
+        unsigned int const chars = addColumn(name, _table, CHARS, CORBA::tk_char, 1);
+        columns_[op.column].child = chars;
+        _ops.push_back(op);
+        return;
+      }
+    case CORBA::tk_sequence:
+    case CORBA::tk_array:
+      {
+        op.kind = SEQUENCE;
+        op.length = (kind == CORBA::tk_array)? _type->length() : 0;
+        op.column = addColumn(name, _table, OFFSETS, CORBA::tk_ulonglong, sizeof(ACE_UINT64));
+        op.table = tables_.size();
+        Table const table = { name + "[]", _table, op.column };
+        tables_.push_back(table);
+        columns_[op.column].child = op.table;
+
+        CORBA::TypeCode_var element = _type->content_type();
+        compile(element.in(), table.name, op.table, op.ops, _depth + 1);
+        _ops.push_back(op);
+        return;
+      }
+    default:
+      break;
+    }
+
+    op.size = primitiveSize(kind);
+    if (op.size == 0) {
+      // unions, anys, wide strings, ...
+      addSkip(_type, name, _ops);
+      return;
+    }
+
+    op.kind = PRIMITIVE;
+    op.column = addColumn(name, _table, VALUE, kind, op.size);
+    if (kind == CORBA::tk_enum) {
+      for (CORBA::ULong i = 0; i < _type->member_count(); ++i)
+        columns_[op.column].enumerators.push_back(_type->member_name(i));
+    }
+    _ops.push_back(op);
+  }
+
+  void
+  LogColumnPlan::addSkip(CORBA::TypeCode_ptr _type, std::string const& _name, OpVector& _ops)
+  {
+    Op op;
+    op.kind = SKIP;
+    op.type = CORBA::TypeCode::_duplicate(_type);
+    skipped_.push_back(_name);
+    _ops.push_back(op);
+  }
+
+  unsigned int
+  LogColumnPlan::addColumn(std::string const& _name, unsigned int _table,
+                           ColumnKind _kind, CORBA::TCKind _type, size_t _size)
+  {
+    Column column;
+    column.name = _name;
+    column.table = _table;
+    column.kind = _kind;
+    column.type = _type;
+    column.size = _size;
+    column.child = 0;
+    columns_.push_back(column);
+    return columns_.size() - 1;
+  }
+
+  void
+  LogColumnPlan::init(Buffers& _buffers) const
+  {
+    _buffers.data.assign(columns_.size(), std::vector<char>());
+    _buffers.flushed.assign(columns_.size(), 0);
+    _buffers.rows.assign(tables_.size(), 0);
+    _buffers.mark.assign(columns_.size(), 0);
+    _buffers.rowMark.assign(tables_.size(), 0);
+  }
+
+  bool
+  LogColumnPlan::decode(ACE_INT64 _stamp, ACE_UINT32 _event,
+                        TAO_InputCDR& _istr, Buffers& _buffers) const
+  {
+    // remember the columns, to drop a partially decoded event
+    for (unsigned int i = 0; i < columns_.size(); ++i)
+      _buffers.mark[i] = _buffers.data[i].size();
+    _buffers.rowMark = _buffers.rows;
+
+    appendValue(_buffers.data[STAMP_COLUMN], _stamp);
+    appendValue(_buffers.data[EVENT_COLUMN], _event);
+    if (decode(ops_, _istr, _buffers)) {
+      ++_buffers.rows[0];
+      return true;
+    }
+
+    for (unsigned int i = 0; i < columns_.size(); ++i)
+      _buffers.data[i].resize(_buffers.mark[i]);
+    _buffers.rows = _buffers.rowMark;
+    return false;
+  }
+
+  bool
+  LogColumnPlan::decode(OpVector const& _ops, TAO_InputCDR& _istr, Buffers& _buffers) const
+  {
+    OpVector::const_iterator first, last = _ops.end();
+    for (first = _ops.begin(); first != last; ++first) {
+      Op const& op = *first;
+
+      switch (op.kind) {
+      case PRIMITIVE:
+        if (!readValues(_istr, op.size, 1, _buffers.data[op.column]))
+          return false;
+        break;
+      case STRING_OP:
+        {
+          // the length includes the terminating NUL
+          ACE_CDR::ULong length;
+          if (!_istr.read_ulong(length) || length == 0 || length > _istr.length())
+            return false;
+
+          unsigned int const chars = columns_[op.column].child;
+          std::vector<char>& buffer = _buffers.data[chars];
+          buffer.insert(buffer.end(), _istr.rd_ptr(), _istr.rd_ptr() + length - 1);
+          _istr.skip_bytes(length);
+          appendValue(_buffers.data[op.column],
+                      static_cast<ACE_UINT64>(_buffers.flushed[chars] + buffer.size()));
+          break;
+        }
+      case SEQUENCE:
+        {
+          // arrays are never empty, sequences carry their length
+          ACE_CDR::ULong length = op.length;
+          if ((length == 0 && !_istr.read_ulong(length)) || length > _istr.length())
+            return false;
+
+          _buffers.rows[op.table] += length;
+          appendValue(_buffers.data[op.column], _buffers.rows[op.table]);
+
+          // sequences of primitives are read in one go
+          if (op.ops.size() == 1 && op.ops[0].kind == PRIMITIVE) {
+            if (!readValues(_istr, op.ops[0].size, length, _buffers.data[op.ops[0].column]))
+              return false;
+            break;
+          }
+          for (ACE_CDR::ULong i = 0; i < length; ++i) {
+            if (!decode(op.ops, _istr, _buffers))
+              return false;
+          }
+          break;
+        }
+      case SKIP:
+        if (!skipValue(op.type.in(), _istr))
+          return false;
+        break;
+      }
+    }
+    return true;
+  }
+
+  std::string
+  LogColumnPlan::dtype(Column const& _column)
+  {
+    char const order = (ACE_CDR_BYTE_ORDER)? '<' : '>';
+    std::string type;
+
+    switch (_column.kind) {
+    case OFFSETS:
+    case STRING:
+      type = "u8";
+      break;
+    case CHARS:
+      return "|u1";
+    case VALUE:
+      switch (_column.type) {
+      case CORBA::tk_boolean:
+        return "|b1";
+      case CORBA::tk_char:
+        return "|S1";
+      case CORBA::tk_octet:
+        return "|u1";
+      case CORBA::tk_short:
+        type = "i2";
+        break;
+      case CORBA::tk_ushort:
+        type = "u2";
+        break;
+      case CORBA::tk_long:
+        type = "i4";
+        break;
+      case CORBA::tk_ulong:
+      case CORBA::tk_enum:
+        type = "u4";
+        break;
+      case CORBA::tk_longlong:
+        type = "i8";
+        break;
+      case CORBA::tk_ulonglong:
+        type = "u8";
+        break;
+      case CORBA::tk_float:
+        type = "f4";
+        break;
+      case CORBA::tk_double:
+        type = "f8";
+        break;
+      default:
+        break;
+      }
+      break;
+    }
+    return order + type;
+  }
+}
@@ -0,0 +1,266 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogColumnPlan_h
+#define miro_LogColumnPlan_h
+
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <tao/Version.h>
+#if (TAO_MAJOR_VERSION > 1) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
+#  include <tao/AnyTypeCode/TypeCode.h>
+#elif ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 4) )
+#  include <tao/TypeCode.h>
+#else
+#  include <tao/Typecode.h>
+#endif
+
+#include <tao/CDR.h>
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  //! Flattening plan of an IDL type into columns.
+  /**
+   * The plan is compiled from the type code of the event bodies. The
+   * members of structs become columns of primitive values, named by
+   * their dotted path. Strings become a column of offsets into a
+   * column of characters. Sequences and arrays become a column of
+   * offsets into a child table, holding the columns of their elements
+   * (named <path>[]). The offsets are the exclusive end of the
+   * elements of each row, so row i spans [offset[i - 1], offset[i]).
+   *
+   * Members that can't be flattened (unions, anys, wide strings, ...)
+   * are skipped while decoding, see @ref skipped(). So are recursive
+   * references to a struct, at their first occurrence.
+   *
+   * The root table holds a row per event. Its first two columns are
+   * the time stamp of the event (microseconds since the epoch) and
+   * its number in the log file.
+   */
+  class miro_Export LogColumnPlan
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! Kind of a column.
+    enum ColumnKind {
+      //! Primitive values.
+      VALUE,
+      //! End offsets of the rows of a child table.
+      OFFSETS,
+      //! End offsets of the strings in a character column.
+      STRING,
+      //! The characters of a string column.
+      CHARS
+    };
+
+    //! Description of a column.
+    struct Column
+    {
+      //! Dotted path of the member.
+      std::string name;
+      //! The table of the column.
+      unsigned int table;
+      //! Kind of the column.
+      ColumnKind kind;
+      //! Type of the values.
+      CORBA::TCKind type;
+      //! Size of a value in bytes.
+      size_t size;
+      //! OFFSETS: the child table, STRING: the character column.
+      unsigned int child;
+      //! Names of the enumerators of an enum column.
+      std::vector<std::string> enumerators;
+    };
+    typedef std::vector<Column> ColumnVector;
+
+    //! Description of a table.
+    struct Table
+    {
+      //! Path of the sequence, empty for the root table.
+      std::string name;
+      //! The parent table.
+      unsigned int parent;
+      //! The offsets column in the parent table.
+      unsigned int offsets;
+    };
+    typedef std::vector<Table> TableVector;
+
+    //! Decoded values, in host byte order.
+    /** One instance per decoding thread, see @ref init(). */
+    struct Buffers
+    {
+      //! The values of each column, since the last flush.
+      std::vector<std::vector<char> > data;
+      //! Bytes of each column already flushed.
+      std::vector<ACE_UINT64> flushed;
+      //! Number of rows of each table.
+      std::vector<ACE_UINT64> rows;
+      //! Sizes of the columns before the current event.
+      std::vector<size_t> mark;
+      //! Rows of the tables before the current event.
+      std::vector<ACE_UINT64> rowMark;
+    };
+
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    //! Column of the time stamps.
+    static unsigned int const STAMP_COLUMN = 0;
+    //! Column of the event numbers.
+    static unsigned int const EVENT_COLUMN = 1;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Compile the plan of the type.
+    LogColumnPlan(CORBA::TypeCode_ptr _type) throw(Exception);
+
+    //! The type of the plan.
+    CORBA::TypeCode_ptr type() const throw();
+    //! The columns.
+    ColumnVector const& columns() const throw();
+    //! The tables.
+    TableVector const& tables() const throw();
+    //! Paths of the members, that are skipped.
+    std::vector<std::string> const& skipped() const throw();
+
+    //! Prepare the buffers for decoding.
+    void init(Buffers& _buffers) const;
+    //! Decode an event body as row of the root table.
+    /**
+     * The stream has to be positioned at the start of the body. On
+     * failure, the values of the partially decoded event are dropped.
+     */
+    bool decode(ACE_INT64 _stamp, ACE_UINT32 _event,
+                TAO_InputCDR& _istr, Buffers& _buffers) const;
+
+    //! Type of the values of a column, in the notation of numpy.
+    /** Like "<f8" for doubles on little endian hosts. */
+    static std::string dtype(Column const& _column);
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Kind of a decoding step.
+    enum OpKind { PRIMITIVE, STRING_OP, SEQUENCE, SKIP };
+
+    //! Decoding step.
+    struct Op
+    {
+      //! Default constructor.
+      Op() : kind(SKIP), size(0), column(0), length(0), table(0) {}
+
+      //! Kind of the step.
+      OpKind kind;
+      //! Size of a primitive value.
+      size_t size;
+      //! The column written.
+      unsigned int column;
+      //! Length of an array, 0 for sequences.
+      ACE_UINT32 length;
+      //! The child table of a sequence.
+      unsigned int table;
+      //! The steps of the elements of a sequence.
+      std::vector<Op> ops;
+      //! The type to skip.
+      CORBA::TypeCode_var type;
+    };
+    typedef std::vector<Op> OpVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Compile the steps of a member.
+    /**
+     * Recursive references to the structs being compiled and members
+     * nested deeper than the maximum depth are skipped.
+     */
+    void compile(CORBA::TypeCode_ptr _type, std::string const& _path,
+                 unsigned int _table, OpVector& _ops, unsigned int _depth);
+    //! Add a step skipping a member.
+    void addSkip(CORBA::TypeCode_ptr _type, std::string const& _name, OpVector& _ops);
+    //! Add a column.
+    unsigned int addColumn(std::string const& _name, unsigned int _table,
+                           ColumnKind _kind, CORBA::TCKind _type, size_t _size);
+    //! Execute decoding steps.
+    bool decode(OpVector const& _ops, TAO_InputCDR& _istr, Buffers& _buffers) const;
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The type of the plan.
+    CORBA::TypeCode_var type_;
+    //! The columns.
+    ColumnVector columns_;
+    //! The tables.
+    TableVector tables_;
+    //! The decoding steps of the root table.
+    OpVector ops_;
+    //! Paths of the skipped members.
+    std::vector<std::string> skipped_;
+    //! Repository ids of the structs being compiled.
+    std::vector<std::string> compiling_;
+  };
+
+  inline
+  CORBA::TypeCode_ptr
+  LogColumnPlan::type() const throw()
+  {
+    return type_.in();
+  }
+
+  inline
+  LogColumnPlan::ColumnVector const&
+  LogColumnPlan::columns() const throw()
+  {
+    return columns_;
+  }
+
+  inline
+  LogColumnPlan::TableVector const&
+  LogColumnPlan::tables() const throw()
+  {
+    return tables_;
+  }
+
+  inline
+  std::vector<std::string> const&
+  LogColumnPlan::skipped() const throw()
+  {
+    return skipped_;
+  }
+}
+#endif // miro_LogColumnPlan_h
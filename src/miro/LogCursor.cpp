@@ -0,0 +1,216 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogCursor.h"
+#include "LogReader.h"
+
+#include <orbsvcs/Time_Utilities.h>
+
+#include <ace/OS_NS_string.h>
+
+namespace Miro
+{
+  LogCursor::LogCursor(LogReader& _reader) throw() :
+    reader_(_reader),
+    swap_(_reader.byteOrder() != ACE_CDR_BYTE_ORDER),
+    pos_(NULL),
+    next_(0)
+  {
+    record_.data = NULL;
+    record_.length = 0;
+    record_.domainName.data = "";
+    record_.domainName.length = 0;
+    record_.typeName = record_.domainName;
+    record_.eventName = record_.domainName;
+    record_.typeId = -1;
+    record_.body = NULL;
+    record_.bodyLength = 0;
+
+    if (!reader_.compressed())
+      pos_ = reader_.filePointer(reader_.firstEvent_);
+    else if (reader_.loadBlock(0))
+      pos_ = reader_.block_->rd_ptr();
+  }
+
+  bool
+  LogCursor::next() throw()
+  {
+    if (pos_ == NULL)
+      return false;
+    // the number of events is known since version 3
+    if (reader_.version() >= 3 && next_ >= reader_.events())
+      return false;
+
+    pos_ = ACE_ptr_align_binary(pos_, ACE_CDR::LONGLONG_SIZE);
+
+    // continue with the next block
+    if (reader_.compressed() && pos_ >= end()) {
+      pos_ = (reader_.loadBlock(reader_.blockNum_ + 1))? reader_.block_->rd_ptr() : NULL;
+    }
+
+    if (pos_ == NULL || !parse()) {
+      pos_ = NULL;
+      return false;
+    }
+    reader_.readAhead(pos_);
+
+    pos_ = record_.data + record_.length;
+    ++next_;
+    return true;
+  }
+
+  bool
+  LogCursor::seek(ACE_UINT32 _index) throw()
+  {
+    if (!reader_.hasIndex() || _index >= reader_.indexSize())
+      return false;
+
+    reader_.seekEvent(_index);
+    if (reader_.eof()) {
+      pos_ = NULL;
+      return false;
+    }
+    pos_ = reader_.rdPtr() - sizeof(TimeBase::TimeT);
+    next_ = _index;
+    return true;
+  }
+
+  bool
+  LogCursor::decode(CosNotification::StructuredEvent& _event) throw()
+  {
+    if (record_.data == NULL)
+      return false;
+
+    reader_.rdPtr(record_.data + sizeof(TimeBase::TimeT));
+    return
+      reader_.parseEventHeader(_event.header.fixed_header) &&
+      reader_.parseEventBody(_event);
+  }
+
+  bool
+  LogCursor::parse() throw()
+  {
+    char const * const end = this->end();
+    char const * pos = pos_;
+
+    // time stamp and length of the record
+    if (pos + sizeof(TimeBase::TimeT) + sizeof(ACE_UINT32) > end)
+      return false;
+
+    TimeBase::TimeT t;
+    if (swap_)
+      ACE_CDR::swap_8(pos, reinterpret_cast<char *>(&t));
+    else
+      ACE_OS::memcpy(&t, pos, sizeof(t));
+    // a zero time stamp marks the end of the log
+    if (t == 0)
+      return false;
+    if (reader_.version() >= 4)
+      ORBSVCS_Time::Absolute_TimeT_to_Time_Value(record_.stamp, t);
+    else
+      ORBSVCS_Time::TimeT_to_Time_Value(record_.stamp, t);
+    pos += sizeof(TimeBase::TimeT);
+
+    // the length is counted from the length slot
+    ACE_UINT32 const length = readULong(pos);
+    if (length < sizeof(ACE_UINT32) || length > static_cast<size_t>(end - pos))
+      return false;
+    char const * const recordEnd = pos + length;
+    pos += sizeof(ACE_UINT32);
+
+    record_.data = pos_;
+    record_.length = sizeof(TimeBase::TimeT) + length;
+
+    // fixed header
+    if (!readString(pos, recordEnd, record_.domainName) ||
+        !readString(pos, recordEnd, record_.typeName) ||
+        !readString(pos, recordEnd, record_.eventName))
+      return false;
+
+    // variable header and filterable data, mostly empty
+    pos = ACE_ptr_align_binary(pos, ACE_CDR::LONG_SIZE);
+    if (pos + 2 * sizeof(ACE_UINT32) > recordEnd)
+      return false;
+    if (readULong(pos) == 0 && readULong(pos + sizeof(ACE_UINT32)) == 0) {
+      pos += 2 * sizeof(ACE_UINT32);
+      if (filterableData_.length() != 0)
+        filterableData_.length(0);
+    }
+    else {
+      TAO_InputCDR istr(pos, recordEnd - pos, reader_.byteOrder());
+      if (!(istr >> variableHeader_) ||
+          !(istr >> filterableData_))
+        return false;
+      pos = istr.rd_ptr();
+    }
+
+    // type id and body
+    pos = ACE_ptr_align_binary(pos, ACE_CDR::LONG_SIZE);
+    if (pos + sizeof(ACE_INT32) > recordEnd)
+      return false;
+    record_.typeId = static_cast<ACE_INT32>(readULong(pos));
+    pos += sizeof(ACE_INT32);
+
+    record_.body = pos;
+    record_.bodyLength = recordEnd - pos;
+    return true;
+  }
+
+  bool
+  LogCursor::readString(char const *& _pos, char const * _end,
+                        LogRecord::String& _string) const throw()
+  {
+    _pos = ACE_ptr_align_binary(_pos, ACE_CDR::LONG_SIZE);
+    if (_pos + sizeof(ACE_UINT32) > _end)
+      return false;
+
+    ACE_UINT32 const length = readULong(_pos);
+    _pos += sizeof(ACE_UINT32);
+    if (length > static_cast<size_t>(_end - _pos))
+      return false;
+
+    // the length includes the terminating NUL
+    _string.data = (length != 0)? _pos : "";
+    _string.length = (length != 0)? length - 1 : 0;
+    _pos += length;
+    return true;
+  }
+
+  ACE_UINT32
+  LogCursor::readULong(char const * _pos) const throw()
+  {
+    ACE_UINT32 v;
+    if (swap_)
+      ACE_CDR::swap_4(_pos, reinterpret_cast<char *>(&v));
+    else
+      ACE_OS::memcpy(&v, _pos, sizeof(v));
+    return v;
+  }
+
+  char const *
+  LogCursor::end() const throw()
+  {
+    if (reader_.compressed())
+      return reader_.istr_->start()->wr_ptr();
+    if (reader_.live_ != NULL)
+      return reader_.liveEnd_;
+    return reader_.filePointer(reader_.memMap_.size());
+  }
+}
@@ -0,0 +1,170 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogCursor_h
+#define miro_LogCursor_h
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+#include <ace/Time_Value.h>
+
+namespace Miro
+{
+  // forward declarations
+  class LogReader;
+
+  //! View of an event record of a log file.
+  /**
+   * The members point into the mapped log file, or the event block of
+   * a compressed log file. They are valid until the cursor moves on.
+   */
+  struct LogRecord
+  {
+    //! View of a marshalled string.
+    struct String
+    {
+      //! The characters, NUL terminated.
+      char const * data;
+      //! Number of characters, without the NUL.
+      ACE_UINT32 length;
+    };
+
+    //! Time stamp of the event.
+    ACE_Time_Value stamp;
+    //! Start of the record, its time stamp.
+    char const * data;
+    //! Length of the record, including the alignment padding.
+    size_t length;
+    //! Domain name of the event type.
+    String domainName;
+    //! Type name of the event type.
+    String typeName;
+    //! Name of the event.
+    String eventName;
+    //! Id of the type code of the body in the type code repository, -1 for none.
+    ACE_INT32 typeId;
+    //! The marshalled body of the event, up to the end of the record.
+    char const * body;
+    //! Length of the marshalled body.
+    size_t bodyLength;
+  };
+
+  //! Streaming iterator over the event records of a log file.
+  /**
+   * The cursor walks the length prefixes of the event records in the
+   * mapped log file and parses only the fixed header of each event
+   * into a @ref LogRecord view. Scanning the events this way allocates
+   * no memory, unless the events carry variable header fields or
+   * filterable data, which are skipped by demarshalling them.
+   * An event is fully demarshalled on demand only, see @ref decode().
+   *
+   * The cursor shares the position state of the @ref LogReader. Using
+   * the reader otherwise, as well as @ref LogReader::update() of a live
+   * log file, invalidates the cursor.
+   */
+  class miro_Export LogCursor
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /** The cursor is positioned before the first event of the log file. */
+    LogCursor(LogReader& _reader) throw();
+
+    //! Advance to the next event.
+    /** Returns false at the end of the log file. */
+    bool next() throw();
+    //! Position the cursor before the indexed event.
+    /** The following @ref next() yields the event. Requires an event index. */
+    bool seek(ACE_UINT32 _index) throw();
+
+    //! The current event.
+    LogRecord const& record() const throw();
+    //! Number of the current event in the log file.
+    ACE_UINT32 number() const throw();
+    //! Filterable data of the current event.
+    /** Demarshalled while parsing the record, empty for most events. */
+    CosNotification::FilterableEventBody const& filterableData() const throw();
+    //! Demarshal the current event.
+    /**
+     * The event is reused from call to call, its members are
+     * reallocated only as necessary.
+     */
+    bool decode(CosNotification::StructuredEvent& _event) throw();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Parse the header of the record at @ref pos_.
+    bool parse() throw();
+    //! Read a CDR string view, @ref _pos is moved behind it.
+    bool readString(char const *& _pos, char const * _end, LogRecord::String& _string) const throw();
+    //! Read an unsigned long in the byte order of the log file.
+    ACE_UINT32 readULong(char const * _pos) const throw();
+    //! End of the events available to the cursor.
+    char const * end() const throw();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The reader of the log file.
+    LogReader& reader_;
+    //! Flag indicating the byte order of the log file differs from the host.
+    bool const swap_;
+    //! Position of the next event record.
+    char const * pos_;
+    //! Number of the next event.
+    ACE_UINT32 next_;
+    //! The current event.
+    LogRecord record_;
+    //! Variable header fields of events carrying them.
+    CosNotification::OptionalHeaderFields variableHeader_;
+    //! Filterable data of events carrying them.
+    CosNotification::FilterableEventBody filterableData_;
+  };
+
+  inline
+  LogRecord const&
+  LogCursor::record() const throw()
+  {
+    return record_;
+  }
+
+  inline
+  ACE_UINT32
+  LogCursor::number() const throw()
+  {
+    return next_ - 1;
+  }
+
+  inline
+  CosNotification::FilterableEventBody const&
+  LogCursor::filterableData() const throw()
+  {
+    return filterableData_;
+  }
+}
+#endif // miro_LogCursor_h
@@ -0,0 +1,216 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogEventMarshaller.h"
+
+#include <tao/Version.h>
+#if (TAO_MAJOR_VERSION > 1) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
+#  include <tao/AnyTypeCode/Any_Impl.h>
+#  include <tao/AnyTypeCode/Any_Unknown_IDL_Type.h>
+#  include <tao/AnyTypeCode/TypeCode.h>
+#elif ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) )
+#  include <tao/Any_Impl.h>
+#  include <tao/Any_Unknown_IDL_Type.h>
+#else
+#include <tao/Marshal.h>
+#endif
+
+#include <algorithm>
+
+namespace Miro
+{
+  namespace
+  {
+    //! Nesting depth, beyond which a type is taken as recursive.
+    unsigned int const MAX_DEPTH = 32;
+
+    //! Maximum alignment required by the CDR encoding of a type code.
+    /**
+     * Recursive types, nested deeper than MAX_DEPTH, get the maximum
+     * alignment, which disables the block copy of their values.
+     */
+    unsigned int
+    cdrAlignment(CORBA::TypeCode_ptr _tc, unsigned int _depth = 0)
+    {
+      if (_depth > MAX_DEPTH)
+        return ACE_CDR::MAX_ALIGNMENT;
+
+      switch (_tc->kind()) {
+      case CORBA::tk_null:
+      case CORBA::tk_void:
+      case CORBA::tk_octet:
+      case CORBA::tk_char:
+      case CORBA::tk_boolean:
+        return ACE_CDR::OCTET_ALIGN;
+      case CORBA::tk_short:
+      case CORBA::tk_ushort:
+        return ACE_CDR::SHORT_ALIGN;
+      case CORBA::tk_long:
+      case CORBA::tk_ulong:
+      case CORBA::tk_float:
+      case CORBA::tk_enum:
+      case CORBA::tk_string:
+      case CORBA::tk_wstring:
+      case CORBA::tk_wchar:
+      case CORBA::tk_objref:
+        return ACE_CDR::LONG_ALIGN;
+      case CORBA::tk_alias:
+      case CORBA::tk_array:
+        {
+          CORBA::TypeCode_var content = _tc->content_type();
+          return cdrAlignment(content.in(), _depth + 1);
+        }
+      case CORBA::tk_sequence:
+        {
+          // the sequence length is an ulong
+          CORBA::TypeCode_var content = _tc->content_type();
+          return std::max(cdrAlignment(content.in(), _depth + 1),
+                          static_cast<unsigned int>(ACE_CDR::LONG_ALIGN));
+        }
+      case CORBA::tk_struct:
+      case CORBA::tk_except:
+      case CORBA::tk_union:
+        {
+          unsigned int alignment = ACE_CDR::OCTET_ALIGN;
+          if (_tc->kind() == CORBA::tk_union) {
+            CORBA::TypeCode_var discriminator = _tc->discriminator_type();
+            alignment = cdrAlignment(discriminator.in(), _depth + 1);
+          }
+          CORBA::ULong const count = _tc->member_count();
+          for (CORBA::ULong i = 0;
+               i < count && alignment < ACE_CDR::MAX_ALIGNMENT; ++i) {
+            CORBA::TypeCode_var member = _tc->member_type(i);
+            alignment = std::max(alignment, cdrAlignment(member.in(), _depth + 1));
+          }
+          return alignment;
+        }
+      default:
+        // 64 bit types, anys and anything we do not know better
+        return ACE_CDR::MAX_ALIGNMENT;
+      }
+    }
+  }
+
+  char *
+  LogEventMarshaller::marshal(TAO_OutputCDR& _ostr,
+                              TimeBase::TimeT _stamp,
+                              CosNotification::StructuredEvent const& _event,
+                              CORBA::Long _typeId)
+  {
+    ACE_Message_Block const * const block = _ostr.current();
+
+    if (_ostr.write_ulonglong(_stamp)) { // write time stamp
+
+      /*Slot to write the length of the serialized structured event.
+       * This is used for skipped parsing of the file. */
+      char * lengthSlot =
+        // The alignement is okay as we wrote an ulonglong before
+        _ostr.current()->wr_ptr();
+
+      // write the length slot
+      if (_ostr.write_ulong(0) &&
+          // write the header
+          _ostr << _event.header &&
+          // write the filterable data
+          _ostr << _event.filterable_data) { // and now the data
+
+#if (TAO_MAJOR_VERSION > 1) || \
+  ((TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION >= 4)) || \
+  ((TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 3 && TAO_BETA_VERSION >= 5))
+
+        //----------------------------------------------------------------
+        // we have Any_Impl
+        //----------------------------------------------------------------
+
+        // write type code id
+        if (_ostr.write_long(_typeId) &&
+            // write any value if existent
+            marshalValue(_ostr, _event.remainder_of_body, _typeId) &&
+            // the CDR stream did not overflow the message block
+            _ostr.current() == block) {
+
+          // calculate length
+          char * here = ACE_ptr_align_binary(_ostr.current()->wr_ptr(), ACE_CDR::LONGLONG_SIZE);
+          CORBA::ULong length = here - lengthSlot;
+
+          // write the length of the event
+          // direct writing is allowed,
+          // as the alignement is correct and we write in host byte order
+          *reinterpret_cast<ACE_INT32 *>(lengthSlot) = length;
+
+          return here;
+        }
+#else
+#error Only TAO >= Version 1.3.5 is supported
+#endif
+      }
+    }
+    return NULL;
+  }
+
+  bool
+  LogEventMarshaller::marshalValue(TAO_OutputCDR& _ostr, CORBA::Any const& _any, CORBA::Long _typeId)
+  {
+    TAO::Any_Impl * const impl = _any.impl();
+    if (impl == NULL)
+      return true;
+
+    if (_typeId >= 0 && impl->encoded()) {
+      TAO::Unknown_IDL_Type * const unknown =
+        dynamic_cast<TAO::Unknown_IDL_Type *>(impl);
+
+      if (unknown != NULL) {
+        TAO_InputCDR& body = unknown->_tao_get_cdr();
+        char const * const src = body.rd_ptr();
+        char const * const dest = _ostr.current()->wr_ptr();
+        ptrdiff_t const alignment = typeAlignment(_typeId, impl->_tao_get_typecode());
+
+        // the encoding stays valid, if the value keeps its position
+        // relative to the alignment boundaries it relies on
+        if (body.byte_order() == _ostr.byte_order() &&
+            (reinterpret_cast<ptrdiff_t>(src) - reinterpret_cast<ptrdiff_t>(dest)) % alignment == 0) {
+          return _ostr.write_octet_array(reinterpret_cast<ACE_CDR::Octet const *>(src),
+                                          body.length());
+        }
+      }
+    }
+    return impl->marshal_value(_ostr);
+  }
+
+  unsigned int
+  LogEventMarshaller::typeAlignment(CORBA::Long _typeId, CORBA::TypeCode_ptr _tc)
+  {
+    if (static_cast<size_t>(_typeId) >= typeAlignment_.size())
+      typeAlignment_.resize(_typeId + 1, 0);
+
+    unsigned char& alignment = typeAlignment_[_typeId];
+    if (alignment == 0) {
+      try {
+        alignment = cdrAlignment(_tc);
+      }
+      catch (CORBA::Exception const&) {
+        alignment = ACE_CDR::MAX_ALIGNMENT;
+      }
+    }
+    return alignment;
+  }
+}
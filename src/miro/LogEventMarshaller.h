@@ -0,0 +1,89 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogEventMarshaller_h
+#define miro_LogEventMarshaller_h
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+#include <tao/CDR.h>
+
+#include <vector>
+
+namespace Miro
+{
+  //! Marshals structured events in the event format of the log file.
+  /**
+   * An event is written as time stamp, length slot, event header,
+   * filterable data, type id and the value of the event body. Used by
+   * the @ref LogWriter and the @ref LogFlightRecorder.
+   *
+   * Values delivered by the notification channel are already CDR
+   * encoded (TAO::Unknown_IDL_Type). If byte order and alignment of
+   * the encoding match the stream, they are block copied instead of
+   * walking the type code.
+   */
+  class miro_Export LogEventMarshaller
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Marshal the event into the current message block of the stream.
+    /**
+     * @param _typeId Id of the type of the event body in the type code
+     * repository of the log, -1 for events without body.
+     *
+     * Returns the 8 byte aligned end of the event, NULL if the event
+     * did not fit into the current message block of the stream.
+     */
+    char * marshal(TAO_OutputCDR& _ostr,
+                   TimeBase::TimeT _stamp,
+                   CosNotification::StructuredEvent const& _event,
+                   CORBA::Long _typeId);
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Alignment of the CDR encoding of a type, indexed by type id.
+    typedef std::vector<unsigned char> AlignmentVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Marshal the value of the event body.
+    bool marshalValue(TAO_OutputCDR& _ostr, CORBA::Any const& _any, CORBA::Long _typeId);
+    //! Maximum alignment required by the CDR encoding of the type.
+    unsigned int typeAlignment(CORBA::Long _typeId, CORBA::TypeCode_ptr _tc);
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Cached alignments of the logged types, 0 if not yet known.
+    AlignmentVector typeAlignment_;
+  };
+}
+#endif // miro_LogEventMarshaller_h
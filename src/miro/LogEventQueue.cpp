@@ -0,0 +1,104 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogEventQueue.h"
+#include "Log.h"
+
+namespace Miro
+{
+  LogEventQueue::LogEventQueue(unsigned int _depth, bool _drop) :
+      mutex_(),
+      notEmpty_(mutex_),
+      notFull_(mutex_),
+      depth_((_depth > 0)? _depth : 1),
+      drop_(_drop),
+      front_(depth_),
+      size_(0),
+      closed_(false),
+      highWaterMark_(0),
+      dropped_(0)
+  {
+    MIRO_LOG_CTOR("Miro::LogEventQueue");
+  }
+
+  bool
+  LogEventQueue::push(ACE_Time_Value const& _stamp,
+                      CosNotification::StructuredEvent const& _event)
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+
+    while (!closed_ && size_ == depth_) {
+      if (drop_) {
+        ++dropped_;
+        return false;
+      }
+      notFull_.wait();
+    }
+
+    if (closed_) {
+      ++dropped_;
+      return false;
+    }
+
+    Entry& entry = front_[size_];
+    entry.stamp = _stamp;
+    entry.event = _event;
+
+    if (++size_ > highWaterMark_)
+      highWaterMark_ = size_;
+
+    // the writer only waits on an empty queue
+    if (size_ == 1)
+      notEmpty_.signal();
+
+    return true;
+  }
+
+  unsigned int
+  LogEventQueue::pop(Buffer& _batch)
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+
+    while (!closed_ && size_ == 0) {
+      notEmpty_.wait();
+    }
+
+    unsigned int const size = size_;
+    if (size > 0) {
+      // recycle the drained buffer of the caller as new front buffer
+      if (_batch.size() != depth_)
+        _batch.resize(depth_);
+      front_.swap(_batch);
+      size_ = 0;
+
+      notFull_.broadcast();
+    }
+    return size;
+  }
+
+  void
+  LogEventQueue::close()
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    closed_ = true;
+    notEmpty_.broadcast();
+    notFull_.broadcast();
+  }
+}
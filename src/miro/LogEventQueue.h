@@ -0,0 +1,141 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogEventQueue_h
+#define miro_LogEventQueue_h
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+
+#include <ace/Synch.h>
+#include <ace/Time_Value.h>
+
+#include <vector>
+
+namespace Miro
+{
+  //! Bounded, double buffered event queue for asynchronous logging.
+  /**
+   * The producers (the ORB dispatching threads) append to the front
+   * buffer. The consumer (the log writer thread) swaps the front
+   * buffer against its own, already drained buffer and marshals the
+   * batch outside of the lock. So the critical section of the push
+   * path is the copy of one structured event, which for events
+   * delivered by the notification channel is a reference count
+   * increment on the CDR encoded payload.
+   */
+  class miro_Export LogEventQueue
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! One queued log event.
+    struct Entry
+    {
+      //! Time the event was received by the logging consumer.
+      ACE_Time_Value stamp;
+      //! The event itself.
+      CosNotification::StructuredEvent event;
+    };
+    //! A batch of queued events.
+    typedef std::vector<Entry> Buffer;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /**
+     * @param _depth Maximum number of queued events.
+     * @param _drop If true, events that do not fit into the queue are
+     * dropped. Otherwise the producer blocks until the writer catches up.
+     */
+    LogEventQueue(unsigned int _depth, bool _drop);
+
+    //! Enqueue an event.
+    /** Returns false, if the event was dropped. */
+    bool push(ACE_Time_Value const& _stamp,
+              CosNotification::StructuredEvent const& _event);
+    //! Dequeue all pending events.
+    /**
+     * Blocks until events are available or the queue is closed. The
+     * pending events are swapped into @ref _batch, the number of valid
+     * entries is returned. Returns 0 only if the queue is closed and
+     * drained.
+     */
+    unsigned int pop(Buffer& _batch);
+    //! Close the queue.
+    /** Wakes up all waiting threads. Events pushed afterwards are dropped. */
+    void close();
+
+    //! Maximum number of events queued at once.
+    unsigned int highWaterMark() const;
+    //! Number of events dropped due to queue overflow.
+    unsigned long dropped() const;
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Lock protecting the front buffer and the counters.
+    mutable ACE_Thread_Mutex mutex_;
+    //! Signaled on the arrival of new events.
+    ACE_Condition_Thread_Mutex notEmpty_;
+    //! Signaled when the writer swapped out the front buffer.
+    ACE_Condition_Thread_Mutex notFull_;
+
+    //! Maximum number of queued events.
+    unsigned int const depth_;
+    //! Overflow policy.
+    bool const drop_;
+    //! The buffer the producers append to.
+    Buffer front_;
+    //! Number of valid entries in the front buffer.
+    unsigned int size_;
+    //! Flag indicating, that the queue was closed.
+    bool closed_;
+
+    //! Queue length high water mark.
+    unsigned int highWaterMark_;
+    //! Number of dropped events.
+    unsigned long dropped_;
+  };
+
+  inline
+  unsigned int
+  LogEventQueue::highWaterMark() const
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    return highWaterMark_;
+  }
+
+  inline
+  unsigned long
+  LogEventQueue::dropped() const
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    return dropped_;
+  }
+}
+#endif // miro_LogEventQueue_h
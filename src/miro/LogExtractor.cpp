@@ -0,0 +1,269 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogExtractor.h"
+#include "LogReader.h"
+#include "LogWriter.h"
+#include "Log.h"
+
+#include <tao/Version.h>
+#if (TAO_MAJOR_VERSION > 1) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
+#  include <tao/AnyTypeCode/Marshal.h>
+#else
+#  include <tao/Marshal.h>
+#endif
+
+#include <ace/OS_NS_string.h>
+
+namespace Miro
+{
+  namespace
+  {
+    //! Skip an any, without demarshalling its value.
+    bool
+    skipAny(TAO_InputCDR& _istr)
+    {
+      try {
+#if (TAO_MAJOR_VERSION > 1) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
+  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
+        return TAO_Marshal_Object::perform_skip(CORBA::_tc_any, &_istr) == TAO::TRAVERSE_CONTINUE;
+#else
+        return TAO_Marshal_Object::perform_skip(CORBA::_tc_any, &_istr ACE_ENV_ARG_PARAMETER) ==
+          CORBA::TypeCode::TRAVERSE_CONTINUE;
+#endif
+      }
+      catch (CORBA::Exception const&) {
+        return false;
+      }
+    }
+
+    //! Skip a sequence of properties, mostly empty, without allocating.
+    bool
+    skipProperties(TAO_InputCDR& _istr)
+    {
+      ACE_CDR::ULong count;
+      if (!_istr.read_ulong(count))
+        return false;
+      for (; count != 0; --count) {
+        if (!_istr.skip_string() ||
+            !skipAny(_istr))
+          return false;
+      }
+      return true;
+    }
+  }
+
+  LogExtractor::LogExtractor(LogReader& _reader, LogWriter& _writer) throw(Exception) :
+    reader_(_reader),
+    writer_(_writer),
+    raw_(_reader.version() >= 4 &&
+         _reader.byteOrder() == ACE_CDR_BYTE_ORDER &&
+         !_reader.live() &&
+         !_writer.compressed()),
+    identity_(true)
+  {
+    MIRO_LOG_CTOR("Miro::LogExtractor");
+
+    // reproduce the type code repository of the reader
+    CORBA::TypeCode_ptr tc;
+    for (CORBA::Long id = 0; (tc = reader_.typeCode(id)) != CORBA::_tc_null; ++id) {
+      CORBA::Long const writerID = writer_.typeID(tc);
+      if (writerID == -2)
+        throw Exception("LogExtractor - Type code repository of the log file is full.");
+      typeIDs_.push_back(writerID);
+      identity_ = identity_ && (writerID == id);
+    }
+  }
+
+  void
+  LogExtractor::exclude(std::string const& _domain, std::string const& _type)
+  {
+    excludes_.push_back(std::make_pair(_domain, _type));
+  }
+
+  void
+  LogExtractor::include(std::string const& _domain, std::string const& _type)
+  {
+    includes_.push_back(std::make_pair(_domain, _type));
+  }
+
+  bool
+  LogExtractor::matches(FilterVector const& _filters,
+                        CosNotification::EventType const& _type)
+  {
+    FilterVector::const_iterator first, last = _filters.end();
+    for (first = _filters.begin(); first != last; ++first) {
+      if (first->first == _type.domain_name.in() &&
+          (first->second.empty() || first->second == _type.type_name.in()))
+        return true;
+    }
+    return false;
+  }
+
+  bool
+  LogExtractor::selected(CosNotification::EventType const& _type) const
+  {
+    return
+      (includes_.empty() || matches(includes_, _type)) &&
+      !matches(excludes_, _type);
+  }
+
+  ACE_UINT32
+  LogExtractor::extract(ACE_Time_Value const& _first,
+                        ACE_Time_Value const& _last) throw(Exception)
+  {
+    ACE_UINT32 events = 0;
+
+    // select the events on the event index
+    if (reader_.hasIndex()) {
+      CosNotification::EventTypeSeq const& types = reader_.indexEventTypes();
+      std::vector<bool> selectedType(types.length());
+      for (CORBA::ULong i = 0; i < types.length(); ++i)
+        selectedType[i] = selected(types[i]);
+
+      ACE_UINT32 const size = reader_.indexSize();
+      for (ACE_UINT32 i = reader_.lowerBound(_first);
+           i < size && reader_.indexTime(i) <= _last; ++i) {
+        if (!selectedType[reader_.indexType(i)])
+          continue;
+        if (!copyEvent(i))
+          throw Exception("LogExtractor - Log file full.");
+        ++events;
+      }
+      return events;
+    }
+
+    // scan log files without index
+    ACE_Time_Value stamp;
+    CosNotification::FixedEventHeader& header = event_.header.fixed_header;
+    while (reader_.parseTimeStamp(stamp)) {
+      char const * const record = reader_.rdPtr() - sizeof(TimeBase::TimeT);
+
+      if (stamp < _first || stamp > _last) {
+        reader_.skipEvent();
+        continue;
+      }
+      if (!reader_.parseEventHeader(header))
+        break;
+      if (!selected(header.event_type)) {
+        reader_.skipEventBody();
+        continue;
+      }
+
+      if (!copyParsed(record, stamp))
+        throw Exception("LogExtractor - Log file full.");
+      ++events;
+    }
+    return events;
+  }
+
+  bool
+  LogExtractor::copyEvent(ACE_UINT32 _index) throw(Exception)
+  {
+    char const * const record = raw_? reader_.indexEvent(_index) : NULL;
+    if (record != NULL)
+      return copyRecord(record, reader_.indexEventTypes()[reader_.indexType(_index)]);
+
+    // compressed log files are read through the event block
+    reader_.seekEvent(_index);
+    if (reader_.eof())
+      throw Exception("LogExtractor - Failed to seek indexed event.");
+    return copyCurrent(reader_.indexTime(_index));
+  }
+
+  bool
+  LogExtractor::copyCurrent(ACE_Time_Value const& _stamp) throw(Exception)
+  {
+    char const * const record = reader_.rdPtr() - sizeof(TimeBase::TimeT);
+    if (!reader_.parseEventHeader(event_.header.fixed_header))
+      throw Exception("LogExtractor - Corrupted event header.");
+    return copyParsed(record, _stamp);
+  }
+
+  bool
+  LogExtractor::copyParsed(char const * _record, ACE_Time_Value const& _stamp) throw(Exception)
+  {
+    if (!raw_)
+      return logEvent(_stamp);
+
+    bool const logged = copyRecord(_record, event_.header.fixed_header.event_type);
+    reader_.skipEventBody();
+    return logged;
+  }
+
+  bool
+  LogExtractor::copyRecord(char const * _record,
+                           CosNotification::EventType const& _type) throw(Exception)
+  {
+    MIRO_ASSERT(raw_);
+
+    // the record length is counted from the length slot behind the time stamp
+    TimeBase::TimeT stamp;
+    ACE_UINT32 length;
+    ACE_OS::memcpy(&stamp, _record, sizeof(stamp));
+    ACE_OS::memcpy(&length, _record + sizeof(stamp), sizeof(length));
+    size_t const recordLength = sizeof(stamp) + length;
+
+    if (identity_)
+      return writer_.logRecord(stamp, _type, _record, recordLength);
+
+    // translate the type id in a copy of the record
+    size_t const offset = typeIDOffset(_record, recordLength);
+    ACE_INT32 id;
+    ACE_OS::memcpy(&id, _record + offset, sizeof(id));
+    if (id >= 0)
+      id = (static_cast<size_t>(id) < typeIDs_.size())? typeIDs_[id] : -1;
+
+    buffer_.assign(_record, _record + recordLength);
+    ACE_OS::memcpy(&buffer_[offset], &id, sizeof(id));
+
+    return writer_.logRecord(stamp, _type, &buffer_[0], recordLength);
+  }
+
+  size_t
+  LogExtractor::typeIDOffset(char const * _record, size_t _length) const throw(Exception)
+  {
+    // the record is 8 byte aligned, as is the CDR stream it was marshalled into,
+    // the header and the filterable data are skipped like the cursor does
+    TAO_InputCDR istr(_record, _length, ACE_CDR_BYTE_ORDER);
+
+    if (!istr.skip_ulonglong() ||
+        !istr.skip_ulong() ||
+        !istr.skip_string() ||
+        !istr.skip_string() ||
+        !istr.skip_string() ||
+        !skipProperties(istr) ||
+        !skipProperties(istr))
+      throw Exception("LogExtractor - Corrupted event record.");
+
+    return ACE_ptr_align_binary(istr.rd_ptr(), ACE_CDR::LONG_SIZE) - _record;
+  }
+
+  bool
+  LogExtractor::logEvent(ACE_Time_Value const& _stamp) throw(Exception)
+  {
+    if (!reader_.parseEventBody(event_))
+      throw Exception("LogExtractor - Corrupted event body.");
+    return writer_.logEvent(_stamp, event_);
+  }
+}
@@ -0,0 +1,177 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogExtractor_h
+#define miro_LogExtractor_h
+
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+#include <ace/Time_Value.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Miro
+{
+  // forward declarations
+  class LogReader;
+  class LogWriter;
+
+  //! Copies the events of a log file into another one.
+  /**
+   * The events are copied as marshalled records, without demarshalling
+   * them. The type code repository of the source log file is
+   * reproduced in the one of the writer up front. Only if the writer
+   * assigns different type ids (as it already holds other types), the
+   * type id of a record is rewritten in a copy of the record.
+   *
+   * Events are selected by time stamp and event type. For indexed log
+   * files, the selection is made on the event index, without touching
+   * the records of the events, that are left out.
+   *
+   * Log files prior to version 4, in foreign byte order or still being
+   * written as well as compressed output are not suitable for record
+   * copies. Their events are demarshalled and logged again.
+   */
+  class miro_Export LogExtractor
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /** Adds the type codes of the reader to the writer. */
+    LogExtractor(LogReader& _reader, LogWriter& _writer) throw(Exception);
+
+    //! Leave out an event type.
+    /** An empty type name matches all types of the domain. */
+    void exclude(std::string const& _domain, std::string const& _type);
+    //! Restrict the extraction to an event type.
+    /**
+     * If event types are included, all other types are left out.
+     * An empty type name matches all types of the domain.
+     */
+    void include(std::string const& _domain, std::string const& _type);
+    //! Flag indicating that the event type is selected.
+    bool selected(CosNotification::EventType const& _type) const;
+
+    //! Copy the selected events within the time interval.
+    /**
+     * Returns the number of events copied. Throws, if the writer is
+     * full or an event is corrupted.
+     */
+    ACE_UINT32 extract(ACE_Time_Value const& _first = ACE_Time_Value::zero,
+                       ACE_Time_Value const& _last = ACE_Time_Value::max_time) throw(Exception);
+
+    //! Copy the indexed event of the reader.
+    /** Returns false, if the writer is full. */
+    bool copyEvent(ACE_UINT32 _index) throw(Exception);
+    //! Copy the event at the position of the reader.
+    /**
+     * The reader is positioned behind the time stamp @ref _stamp of
+     * the event, as after @ref LogReader::parseTimeStamp(). Returns
+     * false, if the writer is full.
+     */
+    bool copyCurrent(ACE_Time_Value const& _stamp) throw(Exception);
+    //! Copy the event record of the reader.
+    /**
+     * @ref _record points to the time stamp of the event within the
+     * reader. Requires @ref raw(). Returns false, if the writer is full.
+     */
+    bool copyRecord(char const * _record,
+                    CosNotification::EventType const& _type) throw(Exception);
+
+    //! Flag indicating that events are copied as marshalled records.
+    bool raw() const throw();
+    //! Flag indicating that the records keep their type ids.
+    bool identity() const throw();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Domain and type name of an event type filter.
+    typedef std::pair<std::string, std::string> TypeFilter;
+    //! Vector of event type filters.
+    typedef std::vector<TypeFilter> FilterVector;
+    //! Type ids of the writer, indexed by the type ids of the reader.
+    typedef std::vector<CORBA::Long> TypeIDVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Flag indicating that the event type matches one of the filters.
+    static bool matches(FilterVector const& _filters,
+                        CosNotification::EventType const& _type);
+    //! Offset of the type id within the event record.
+    size_t typeIDOffset(char const * _record, size_t _length) const throw(Exception);
+    //! Copy the event, whose header was parsed by the reader.
+    /** Returns false, if the writer is full. */
+    bool copyParsed(char const * _record, ACE_Time_Value const& _stamp) throw(Exception);
+    //! Demarshal the event at the reader position and log it again.
+    /** Returns false, if the writer is full. */
+    bool logEvent(ACE_Time_Value const& _stamp) throw(Exception);
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The log file to copy from.
+    LogReader& reader_;
+    //! The log file to copy to.
+    LogWriter& writer_;
+    //! Translation of the type ids.
+    TypeIDVector typeIDs_;
+    //! Flag indicating that the records are copied.
+    bool raw_;
+    //! Flag indicating that the translation of the type ids is the identity.
+    bool identity_;
+    //! Event types to leave out.
+    FilterVector excludes_;
+    //! Event types to restrict the extraction to.
+    FilterVector includes_;
+    //! Copy of a record with rewritten type id.
+    std::vector<char> buffer_;
+    //! Event for the fallback of demarshalling the events.
+    CosNotification::StructuredEvent event_;
+  };
+
+  inline
+  bool
+  LogExtractor::raw() const throw()
+  {
+    return raw_;
+  }
+
+  inline
+  bool
+  LogExtractor::identity() const throw()
+  {
+    return identity_;
+  }
+}
+#endif // miro_LogExtractor_h
@@ -0,0 +1,325 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogFieldIndex.h"
+#include "Log.h"
+
+#include <tao/CDR.h>
+
+#include <ace/ACE.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Miro
+{
+  namespace
+  {
+    template<class T>
+    LogFieldIndex::Kind
+    numberKey(CORBA::Any const& _value, double& _number)
+    {
+      T n;
+      if (!(_value >>= n))
+        return LogFieldIndex::NONE;
+      _number = static_cast<double>(n);
+      return LogFieldIndex::NUMBER;
+    }
+  }
+
+  LogFieldIndex::LogFieldIndex(std::vector<std::string> const& _fields,
+                               ACE_UINT32 _chunkSize) :
+      chunkSize_(std::max(_chunkSize, ACE_UINT32(1))),
+      spilled_(0),
+      spillFile_(ACE_INVALID_HANDLE),
+      inMemory_(false)
+  {
+    std::vector<std::string>::const_iterator first, last = _fields.end();
+    for (first = _fields.begin(); first != last; ++first) {
+      fields_.push_back(Field());
+      fields_.back().name = *first;
+    }
+  }
+
+  LogFieldIndex::~LogFieldIndex()
+  {
+    if (spillFile_ != ACE_INVALID_HANDLE)
+      ACE_OS::close(spillFile_);
+  }
+
+  void
+  LogFieldIndex::add(ACE_UINT32 _event, CosNotification::PropertySeq const& _data)
+  {
+    for (CORBA::ULong i = 0; i < _data.length(); ++i) {
+      char const * const name = _data[i].name.in();
+
+      // only a handful of fields are indexed
+      FieldVector::iterator field = fields_.begin();
+      while (field != fields_.end() && field->name != name)
+        ++field;
+      if (field == fields_.end())
+        continue;
+
+      // a new value gets the next value id
+      ACE_UINT32 const next = values_.size();
+      ACE_UINT32 value = next;
+      double number;
+      switch (key(_data[i].value, string_, number)) {
+      case STRING:
+        value = field->strings.insert(std::make_pair(string_, next)).first->second;
+        break;
+      case NUMBER:
+        value = field->numbers.insert(std::make_pair(range(number), next)).first->second;
+        break;
+      default:
+        continue;
+      }
+      if (value == next) {
+        Value const fresh = { 0, NO_EVENT };
+        values_.push_back(fresh);
+      }
+
+      // the same value given twice within an event
+      Value& v = values_[value];
+      if (v.last == _event)
+        continue;
+      v.last = _event;
+      ++v.count;
+
+      Posting const posting = { value, _event };
+      postings_.push_back(posting);
+      if (postings_.size() >= chunkSize_ && !inMemory_)
+        spill();
+    }
+  }
+
+  bool
+  LogFieldIndex::addRecord(ACE_UINT32 _event, char const * _record, size_t _length,
+                           int _byteOrder)
+  {
+    TAO_InputCDR istr(_record, _length, _byteOrder);
+
+    // time stamp, length and fixed header
+    if (!istr.skip_ulonglong() ||
+        !istr.skip_ulong() ||
+        !istr.skip_string() ||
+        !istr.skip_string() ||
+        !istr.skip_string())
+      return false;
+
+    // variable header and filterable data, mostly empty
+    ACE_CDR::ULong variableFields;
+    ACE_CDR::ULong filterableFields;
+    char const * const pos = istr.rd_ptr();
+    if (!istr.read_ulong(variableFields) ||
+        !istr.read_ulong(filterableFields))
+      return false;
+    if (variableFields == 0 && filterableFields == 0)
+      return true;
+
+    TAO_InputCDR data(pos, _record + _length - pos, _byteOrder);
+    if (!(data >> variableHeader_) ||
+        !(data >> filterableData_))
+      return false;
+
+    add(_event, filterableData_);
+    return true;
+  }
+
+  void
+  LogFieldIndex::truncate(ACE_UINT32 _events)
+  {
+    while (true) {
+      while (!postings_.empty() && postings_.back().event >= _events) {
+        Value& v = values_[postings_.back().value];
+        --v.count;
+        v.last = NO_EVENT;
+        postings_.pop_back();
+      }
+      if (!postings_.empty() || spilled_ == 0)
+        break;
+
+      // the dropped events reach into the spilled postings,
+      // which are overwritten by the next chunk
+      ACE_UINT32 const count = std::min(chunkSize_, spilled_);
+      PostingVector chunk(count);
+      if (!read(spilled_ - count, count, &chunk[0])) {
+        MIRO_LOG_OSTR(LL_ERROR,
+                      "LogFieldIndex - Could not read back the spilled postings: " <<
+                      strerror(errno));
+        break;
+      }
+      spilled_ -= count;
+      postings_.swap(chunk);
+    }
+  }
+
+  bool
+  LogFieldIndex::read(ACE_UINT32 _first, ACE_UINT32 _count, Posting * _dest) const
+  {
+    // the spilled postings
+    if (_first < spilled_) {
+      ACE_UINT32 const count = std::min(_count, spilled_ - _first);
+      size_t const length = count * sizeof(Posting);
+      if (ACE_OS::pread(spillFile_, _dest, length,
+                        static_cast<ACE_OFF_T>(_first) * sizeof(Posting)) !=
+          static_cast<ssize_t>(length))
+        return false;
+      _first += count;
+      _count -= count;
+      _dest += count;
+    }
+
+    // the postings in memory
+    if (_count != 0)
+      memcpy(_dest, &postings_[_first - spilled_], _count * sizeof(Posting));
+    return true;
+  }
+
+  void
+  LogFieldIndex::spill()
+  {
+    if (spillFile_ == ACE_INVALID_HANDLE) {
+      char name[MAXPATHLEN];
+      if (ACE::get_temp_dir(name, MAXPATHLEN - 16) != -1) {
+        ACE_OS::strcat(name, "miroFieldsXXXXXX");
+        spillFile_ = ACE_OS::mkstemp(name);
+      }
+      // the file is removed along with its handle
+      if (spillFile_ != ACE_INVALID_HANDLE)
+        ACE_OS::unlink(name);
+    }
+
+    size_t const length = postings_.size() * sizeof(Posting);
+    if (spillFile_ == ACE_INVALID_HANDLE ||
+        ACE_OS::pwrite(spillFile_, &postings_[0], length,
+                       static_cast<ACE_OFF_T>(spilled_) * sizeof(Posting)) !=
+        static_cast<ssize_t>(length)) {
+      MIRO_LOG_OSTR(LL_WARNING,
+                    "LogFieldIndex - Could not spill the field index, keeping it in memory: " <<
+                    strerror(errno));
+      inMemory_ = true;
+      return;
+    }
+
+    spilled_ += postings_.size();
+    postings_.clear();
+  }
+
+  double
+  LogFieldIndex::range(double _number)
+  {
+    // zero and the infinities are ranges of their own
+    if (_number == 0. || _number - _number != 0.)
+      return _number;
+
+    int exponent;
+    double const mantissa = std::frexp(_number, &exponent);
+    return std::ldexp(std::floor(std::ldexp(mantissa, RANGE_BITS)), exponent - RANGE_BITS);
+  }
+
+  LogFieldIndex::Kind
+  LogFieldIndex::key(CORBA::Any const& _value, std::string& _string, double& _number)
+  {
+    Kind kind = NONE;
+    try {
+      CORBA::TypeCode_var tc = _value.type();
+      while (tc->kind() == CORBA::tk_alias)
+        tc = tc->content_type();
+
+      switch (tc->kind()) {
+      case CORBA::tk_string:
+        {
+          char const * s;
+          if (_value >>= s) {
+            _string = s;
+            kind = STRING;
+          }
+          break;
+        }
+      case CORBA::tk_short:
+        kind = numberKey<CORBA::Short>(_value, _number);
+        break;
+      case CORBA::tk_ushort:
+        kind = numberKey<CORBA::UShort>(_value, _number);
+        break;
+      case CORBA::tk_long:
+        kind = numberKey<CORBA::Long>(_value, _number);
+        break;
+      case CORBA::tk_ulong:
+        kind = numberKey<CORBA::ULong>(_value, _number);
+        break;
+      case CORBA::tk_longlong:
+        kind = numberKey<CORBA::LongLong>(_value, _number);
+        break;
+      case CORBA::tk_ulonglong:
+        kind = numberKey<CORBA::ULongLong>(_value, _number);
+        break;
+      case CORBA::tk_float:
+        kind = numberKey<CORBA::Float>(_value, _number);
+        break;
+      case CORBA::tk_double:
+        kind = numberKey<CORBA::Double>(_value, _number);
+        break;
+      case CORBA::tk_boolean:
+        {
+          CORBA::Boolean b;
+          if (_value >>= CORBA::Any::to_boolean(b)) {
+            _number = (b)? 1. : 0.;
+            kind = NUMBER;
+          }
+          break;
+        }
+      case CORBA::tk_char:
+        {
+          CORBA::Char c;
+          if (_value >>= CORBA::Any::to_char(c)) {
+            _number = static_cast<unsigned char>(c);
+            kind = NUMBER;
+          }
+          break;
+        }
+      case CORBA::tk_octet:
+        {
+          CORBA::Octet o;
+          if (_value >>= CORBA::Any::to_octet(o)) {
+            _number = o;
+            kind = NUMBER;
+          }
+          break;
+        }
+      default:
+        break;
+      }
+    }
+    catch (CORBA::Exception const&) {
+      kind = NONE;
+    }
+
+    // NaN has no place in the ordered keys
+    if (kind == NUMBER && _number != _number)
+      kind = NONE;
+    return kind;
+  }
+}
@@ -0,0 +1,255 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogFieldIndex_h
+#define miro_LogFieldIndex_h
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Miro
+{
+  //! In memory index of filterable data fields of a log file.
+  /**
+   * Collects the numbers of the events carrying a configured field in
+   * their filterable data, grouped by the value of the field. String
+   * values are grouped by the string, numeric values (integers,
+   * floating point numbers, booleans and characters) by ranges of
+   * their value as double, see @ref range(). Values of other types are
+   * not indexed.
+   *
+   * Each distinct value gets a value id. The events are collected as
+   * postings of value id and event number. Only the most recent chunk
+   * of postings is kept in memory, like the entries of the @ref
+   * LogIndex. Full chunks are spilled to an anonymous temporary file.
+   * If no temporary file can be written, the postings stay in memory.
+   *
+   * Used by the @ref LogWriter at write time and by the offline
+   * indexer of @ref LogFieldIndexFile, which stores the index as
+   * sidecar of the log file.
+   */
+  class miro_Export LogFieldIndex
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! Ascending event numbers.
+    typedef std::vector<ACE_UINT32> EventVector;
+    //! Value ids by string value.
+    typedef std::map<std::string, ACE_UINT32> StringValues;
+    //! Value ids by the lower bound of the range of numeric values.
+    typedef std::map<double, ACE_UINT32> NumberValues;
+
+    //! The values of one indexed field.
+    struct Field
+    {
+      //! Name of the field.
+      std::string name;
+      //! Value ids by string value.
+      StringValues strings;
+      //! Value ids by range of numeric values.
+      NumberValues numbers;
+    };
+    //! The indexed fields.
+    typedef std::vector<Field> FieldVector;
+
+    //! An event carrying a value.
+    struct Posting
+    {
+      ACE_UINT32 value;
+      ACE_UINT32 event;
+    };
+    //! Postings in the order of the events.
+    typedef std::vector<Posting> PostingVector;
+
+    //! Kind of an indexed value.
+    enum Kind { NONE, STRING, NUMBER };
+
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    //! Default number of postings kept in memory.
+    static ACE_UINT32 const CHUNK_SIZE = 64 * 1024;
+    //! Significant bits of the lower bound of a range of numeric values.
+    static int const RANGE_BITS = 8;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /**
+     * @param _fields Names of the filterable data fields to index.
+     * @param _chunkSize Maximum number of postings kept in memory.
+     */
+    LogFieldIndex(std::vector<std::string> const& _fields,
+                  ACE_UINT32 _chunkSize = CHUNK_SIZE);
+    //! Cleaning up.
+    ~LogFieldIndex();
+
+    //! Add the filterable data of an event.
+    /** The events have to be added in ascending order. */
+    void add(ACE_UINT32 _event, CosNotification::PropertySeq const& _data);
+    //! Add the filterable data of a marshalled event record.
+    /**
+     * @ref _record holds the event in the format of the log file,
+     * starting with the time stamp. It has to be 8 byte aligned.
+     * The header is skipped like the @ref LogCursor does, only the
+     * filterable data of events carrying any are demarshalled.
+     * Returns false, if the record could not be parsed.
+     */
+    bool addRecord(ACE_UINT32 _event, char const * _record, size_t _length,
+                   int _byteOrder);
+    //! Drop the events from @ref _events on.
+    void truncate(ACE_UINT32 _events);
+
+    //! The indexed fields.
+    FieldVector const& fields() const;
+    //! Number of value ids.
+    ACE_UINT32 values() const;
+    //! Number of events carrying the value.
+    ACE_UINT32 count(ACE_UINT32 _value) const;
+    //! Number of postings.
+    ACE_UINT32 size() const;
+    //! Number of postings spilled to the temporary file.
+    ACE_UINT32 spilled() const;
+    //! Read @ref _count postings starting at @ref _first.
+    /**
+     * Single reads are limited in size, so read one chunk at a time.
+     * Returns false on error, errno tells the cause.
+     */
+    bool read(ACE_UINT32 _first, ACE_UINT32 _count, Posting * _dest) const;
+
+    //! Key of a filterable data value.
+    /** Returns the kind of the value, NONE if it can't be indexed. */
+    static Kind key(CORBA::Any const& _value, std::string& _string, double& _number);
+    //! Lower bound of the range of numeric values @ref _number falls into.
+    /**
+     * The lower bound keeps the leading @ref RANGE_BITS bits of the
+     * mantissa, so a range spans at most 1/128 of its values and
+     * integers up to 256 are ranges of their own.
+     */
+    static double range(double _number);
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Postings of a value id.
+    struct Value
+    {
+      //! Number of events carrying the value.
+      ACE_UINT32 count;
+      //! Last event carrying the value.
+      ACE_UINT32 last;
+    };
+    typedef std::vector<Value> ValueVector;
+
+    //--------------------------------------------------------------------------
+    // protected constants
+    //--------------------------------------------------------------------------
+
+    //! No event carried the value yet.
+    static ACE_UINT32 const NO_EVENT = 0xffffffff;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Move the postings in memory to the temporary file.
+    void spill();
+
+    //--------------------------------------------------------------------------
+    // hidden methods
+    //--------------------------------------------------------------------------
+    LogFieldIndex(LogFieldIndex const&);
+    LogFieldIndex& operator= (LogFieldIndex const&);
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The indexed fields.
+    FieldVector fields_;
+    //! The postings of the value ids.
+    ValueVector values_;
+    //! Maximum number of postings kept in memory.
+    ACE_UINT32 const chunkSize_;
+    //! The postings, that are not spilled.
+    PostingVector postings_;
+    //! Number of postings in the temporary file.
+    ACE_UINT32 spilled_;
+    //! Unlinked temporary file, holding the spilled postings.
+    ACE_HANDLE spillFile_;
+    //! Flag indicating that spilling failed, the postings stay in memory.
+    bool inMemory_;
+    //! Scratch key of string values.
+    std::string string_;
+    //! Scratch variable header of event records.
+    CosNotification::OptionalHeaderFields variableHeader_;
+    //! Scratch filterable data of event records.
+    CosNotification::FilterableEventBody filterableData_;
+  };
+
+  inline
+  LogFieldIndex::FieldVector const&
+  LogFieldIndex::fields() const
+  {
+    return fields_;
+  }
+
+  inline
+  ACE_UINT32
+  LogFieldIndex::values() const
+  {
+    return values_.size();
+  }
+
+  inline
+  ACE_UINT32
+  LogFieldIndex::count(ACE_UINT32 _value) const
+  {
+    return values_[_value].count;
+  }
+
+  inline
+  ACE_UINT32
+  LogFieldIndex::size() const
+  {
+    return spilled_ + postings_.size();
+  }
+
+  inline
+  ACE_UINT32
+  LogFieldIndex::spilled() const
+  {
+    return spilled_;
+  }
+}
+#endif // miro_LogFieldIndex_h
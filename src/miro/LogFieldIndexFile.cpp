@@ -0,0 +1,430 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogFieldIndexFile.h"
+#include "LogIndexFile.h"
+#include "LogReader.h"
+#include "LogCursor.h"
+#include "Log.h"
+
+#include <tao/CDR.h>
+
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_fcntl.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Miro
+{
+  namespace
+  {
+    //! Append a table to the data area, keeping it 8 byte aligned.
+    /** Returns the offset of the table in the data area. */
+    ACE_UINT64
+    appendData(std::vector<char>& _data, void const * _table, size_t _length)
+    {
+      size_t const offset = _data.size();
+      _data.resize(ACE_align_binary(offset + _length, ACE_CDR::LONGLONG_SIZE), 0);
+      if (_length != 0)
+        memcpy(&_data[offset], _table, _length);
+      return offset;
+    }
+
+    //! Order of the string value table.
+    struct StringLess
+    {
+      StringLess(char const * _data, size_t _length) :
+        data_(_data), length_(_length)
+      {}
+
+      bool operator() (LogFieldIndexFile::StringEntry const& _lhs,
+                       std::string const& _rhs) const {
+        // corrupted entries compare as empty string
+        size_t length = _lhs.length;
+        if (_lhs.value + length > length_)
+          length = 0;
+        int const rc = memcmp(data_ + _lhs.value, _rhs.data(), std::min(length, _rhs.length()));
+        return rc < 0 || (rc == 0 && length < _rhs.length());
+      }
+
+      char const * data_;
+      size_t length_;
+    };
+
+    //! Order of the numeric value table.
+    struct NumberLess
+    {
+      bool operator() (LogFieldIndexFile::NumberEntry const& _lhs, double _rhs) const {
+        return _lhs.value < _rhs;
+      }
+    };
+  }
+
+  char const * const LogFieldIndexFile::SUFFIX = ".fdx";
+
+  LogFieldIndexFile::LogFieldIndexFile(std::string const& _logFile, ACE_UINT32 _numEvents) :
+      data_(NULL),
+      dataLength_(0)
+  {
+    std::string const name = fileName(_logFile);
+
+    if (ACE_OS::access(name.c_str(), R_OK) == 0 &&
+        memMap_.map(name.c_str(), static_cast<size_t>(-1), O_RDONLY,
+                    ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_PRIVATE) == 0 &&
+        !parse(_logFile, _numEvents)) {
+      MIRO_LOG_OSTR(LL_NOTICE, "LogFieldIndexFile - Ignoring stale field index " << name);
+      data_ = NULL;
+      dataLength_ = 0;
+      fields_.clear();
+    }
+  }
+
+  LogFieldIndexFile::~LogFieldIndexFile()
+  {
+    memMap_.close();
+  }
+
+  bool
+  LogFieldIndexFile::parse(std::string const& _logFile, ACE_UINT32 _numEvents) throw()
+  {
+    if (memMap_.size() < sizeof(Header))
+      return false;
+
+    Header const * header = static_cast<Header const *>(memMap_.addr());
+    if (header->id != PROTOCOL_ID ||
+        header->version != PROTOCOL_VERSION ||
+        header->byteOrder != ACE_CDR_BYTE_ORDER)
+      return false;
+
+    ACE_stat st;
+    if (ACE_OS::stat(_logFile.c_str(), &st) == -1)
+      return false;
+
+    TAO_InputCDR istr(static_cast<char *>(memMap_.addr()) + sizeof(Header),
+                      memMap_.size() - sizeof(Header));
+
+    ACE_UINT64 logSize;
+    ACE_UINT64 logMTime;
+    ACE_UINT32 numEvents;
+    ACE_UINT32 numFields;
+    if (!istr.read_ulonglong(logSize) ||
+        !istr.read_ulonglong(logMTime) ||
+        !istr.read_ulong(numEvents) ||
+        !istr.read_ulong(numFields))
+      return false;
+
+    // validate against the log file
+    if (logSize != static_cast<ACE_UINT64>(st.st_size) ||
+        logMTime != static_cast<ACE_UINT64>(st.st_mtime) ||
+        numEvents != _numEvents)
+      return false;
+
+    // the field directory
+    std::vector<ACE_UINT64> strings;
+    std::vector<ACE_UINT64> numbers;
+    for (ACE_UINT32 i = 0; i < numFields; ++i) {
+      Field field;
+      CORBA::String_var name;
+      ACE_UINT64 stringsOffset;
+      ACE_UINT64 numbersOffset;
+      if (!(istr >> name.out()) ||
+          !istr.read_ulong(field.numStrings) ||
+          !istr.read_ulong(field.numNumbers) ||
+          !istr.read_ulonglong(stringsOffset) ||
+          !istr.read_ulonglong(numbersOffset))
+        return false;
+      field.name = name.in();
+      fields_.push_back(field);
+      strings.push_back(stringsOffset);
+      numbers.push_back(numbersOffset);
+    }
+
+    istr.align_read_ptr(ACE_CDR::LONGLONG_SIZE);
+    data_ = istr.rd_ptr();
+    dataLength_ = istr.length();
+
+    // the value tables have to lie within the data area
+    for (ACE_UINT32 i = 0; i < numFields; ++i) {
+      Field& field = fields_[i];
+      if (strings[i] % ACE_CDR::LONGLONG_SIZE != 0 ||
+          numbers[i] % ACE_CDR::LONGLONG_SIZE != 0 ||
+          strings[i] + field.numStrings * sizeof(StringEntry) > dataLength_ ||
+          numbers[i] + field.numNumbers * sizeof(NumberEntry) > dataLength_)
+        return false;
+      field.strings = reinterpret_cast<StringEntry const *>(data_ + strings[i]);
+      field.numbers = reinterpret_cast<NumberEntry const *>(data_ + numbers[i]);
+    }
+    return true;
+  }
+
+  LogFieldIndexFile::Field const *
+  LogFieldIndexFile::field(std::string const& _field) const throw()
+  {
+    FieldVector::const_iterator first, last = fields_.end();
+    for (first = fields_.begin(); first != last; ++first)
+      if (first->name == _field)
+        return &*first;
+    return NULL;
+  }
+
+  void
+  LogFieldIndexFile::append(ACE_UINT64 _offset, ACE_UINT32 _count, EventVector& _events) const
+  {
+    if (_offset % sizeof(ACE_UINT32) != 0 ||
+        _offset + static_cast<ACE_UINT64>(_count) * sizeof(ACE_UINT32) > dataLength_) {
+      MIRO_LOG(LL_ERROR, "LogFieldIndexFile - Corrupted field index entry.");
+      return;
+    }
+    ACE_UINT32 const * events = reinterpret_cast<ACE_UINT32 const *>(data_ + _offset);
+    _events.insert(_events.end(), events, events + _count);
+  }
+
+  ACE_UINT32
+  LogFieldIndexFile::find(std::string const& _field, std::string const& _value,
+                          EventVector& _events) const
+  {
+    _events.clear();
+
+    Field const * const field = this->field(_field);
+    if (field == NULL)
+      return 0;
+
+    StringEntry const * const last = field->strings + field->numStrings;
+    StringEntry const * const entry =
+      std::lower_bound(field->strings, last, _value, StringLess(data_, dataLength_));
+    if (entry != last &&
+        entry->length == _value.length() &&
+        entry->value + entry->length <= dataLength_ &&
+        memcmp(data_ + entry->value, _value.data(), _value.length()) == 0)
+      append(entry->events, entry->count, _events);
+
+    return _events.size();
+  }
+
+  ACE_UINT32
+  LogFieldIndexFile::find(std::string const& _field, double _min, double _max,
+                          EventVector& _events) const
+  {
+    _events.clear();
+
+    Field const * const field = this->field(_field);
+    if (field == NULL)
+      return 0;
+
+    NumberEntry const * const last = field->numbers + field->numNumbers;
+    // the values are indexed by the lower bounds of their ranges
+    NumberEntry const * entry =
+      std::lower_bound(field->numbers, last, LogFieldIndex::range(_min), NumberLess());
+    unsigned int values = 0;
+    for (; entry != last && entry->value <= _max; ++entry, ++values)
+      append(entry->events, entry->count, _events);
+
+    // the events of several values interleave
+    if (values > 1) {
+      std::sort(_events.begin(), _events.end());
+      _events.erase(std::unique(_events.begin(), _events.end()), _events.end());
+    }
+    return _events.size();
+  }
+
+  std::string
+  LogFieldIndexFile::fileName(std::string const& _logFile)
+  {
+    return _logFile + SUFFIX;
+  }
+
+  void
+  LogFieldIndexFile::write(std::string const& _logFile, ACE_UINT32 _numEvents,
+                           LogFieldIndex const& _index) throw(Exception)
+  {
+    ACE_stat st;
+    if (ACE_OS::stat(_logFile.c_str(), &st) == -1)
+      throw CException(errno, "Stat of " + _logFile + ": " + strerror(errno));
+
+    LogFieldIndex::FieldVector const& fields = _index.fields();
+
+    // the event numbers of the values lead the data area,
+    // they are placed while streaming the postings
+    std::vector<ACE_UINT64> events(_index.values(), 0);
+    ACE_UINT64 eventsLength = 0;
+    for (ACE_UINT32 value = 0; value < _index.values(); ++value) {
+      events[value] = eventsLength;
+      eventsLength += ACE_align_binary(_index.count(value) * sizeof(ACE_UINT32),
+                                       ACE_CDR::LONGLONG_SIZE);
+    }
+
+    // followed by the string values and the value tables of the fields
+    std::vector<char> data;
+    std::vector<ACE_UINT64> strings;
+    std::vector<ACE_UINT64> numbers;
+    std::vector<ACE_UINT32> numStrings;
+    std::vector<ACE_UINT32> numNumbers;
+
+    LogFieldIndex::FieldVector::const_iterator first, last = fields.end();
+    for (first = fields.begin(); first != last; ++first) {
+      std::vector<StringEntry> stringTable;
+      LogFieldIndex::StringValues::const_iterator f1, l1 = first->strings.end();
+      for (f1 = first->strings.begin(); f1 != l1; ++f1) {
+        // values of truncated events only
+        if (_index.count(f1->second) == 0)
+          continue;
+        StringEntry entry;
+        entry.value = eventsLength + appendData(data, f1->first.data(), f1->first.length());
+        entry.events = events[f1->second];
+        entry.count = _index.count(f1->second);
+        entry.length = f1->first.length();
+        stringTable.push_back(entry);
+      }
+
+      std::vector<NumberEntry> numberTable;
+      LogFieldIndex::NumberValues::const_iterator f2, l2 = first->numbers.end();
+      for (f2 = first->numbers.begin(); f2 != l2; ++f2) {
+        if (_index.count(f2->second) == 0)
+          continue;
+        NumberEntry entry;
+        entry.value = f2->first;
+        entry.events = events[f2->second];
+        entry.count = _index.count(f2->second);
+        entry.reserved = 0;
+        numberTable.push_back(entry);
+      }
+
+      strings.push_back(eventsLength +
+                        appendData(data, (stringTable.empty())? NULL : &stringTable[0],
+                                   stringTable.size() * sizeof(StringEntry)));
+      numbers.push_back(eventsLength +
+                        appendData(data, (numberTable.empty())? NULL : &numberTable[0],
+                                   numberTable.size() * sizeof(NumberEntry)));
+      numStrings.push_back(stringTable.size());
+      numNumbers.push_back(numberTable.size());
+    }
+
+    Header header;
+    header.id = PROTOCOL_ID;
+    header.version = PROTOCOL_VERSION;
+    header.byteOrder = ACE_CDR_BYTE_ORDER;
+
+    TAO_OutputCDR ostr;
+    ostr.write_octet_array(reinterpret_cast<ACE_CDR::Octet const *>(&header), sizeof(Header));
+    ostr.write_ulonglong(st.st_size);
+    ostr.write_ulonglong(st.st_mtime);
+    ostr.write_ulong(_numEvents);
+    ostr.write_ulong(fields.size());
+    for (unsigned int i = 0; i < fields.size(); ++i) {
+      ostr.write_string(fields[i].name.c_str());
+      ostr.write_ulong(numStrings[i]);
+      ostr.write_ulong(numNumbers[i]);
+      ostr.write_ulonglong(strings[i]);
+      ostr.write_ulonglong(numbers[i]);
+    }
+    ostr.align_write_ptr(ACE_CDR::LONGLONG_SIZE);
+    if (!ostr.good_bit())
+      throw Exception("Error marshalling field index of " + _logFile);
+    ostr.consolidate();
+
+    // the sidecar is mapped, so the event numbers of all the postings
+    // never have to be held in memory at once
+    std::string const name = fileName(_logFile);
+    std::string const tmp = LogIndexFile::tempName(name);
+    size_t const headerLength = ostr.total_length();
+    size_t const length = headerLength + eventsLength + data.size();
+
+    ACE_Mem_Map memMap;
+    if (memMap.map(tmp.c_str(), length,
+                   O_RDWR | O_CREAT | O_TRUNC, ACE_DEFAULT_FILE_PERMS,
+                   PROT_RDWR, ACE_MAP_SHARED) == -1) {
+      int const error = errno;
+      ACE_OS::unlink(tmp.c_str());
+      throw CException(error, "Opening " + tmp + ": " + strerror(error));
+    }
+
+    char * const base = static_cast<char *>(memMap.addr());
+    memcpy(base, ostr.begin()->rd_ptr(), headerLength);
+    char * const area = base + headerLength;
+    if (!data.empty())
+      memcpy(area + eventsLength, &data[0], data.size());
+
+    // the postings come in the order of the events,
+    // so the event numbers of each value stay ascending
+    std::vector<ACE_UINT32> placed(_index.values(), 0);
+    LogFieldIndex::PostingVector
+      chunk(std::min(static_cast<ACE_UINT32>(LogFieldIndex::CHUNK_SIZE), _index.size()));
+    bool written = true;
+    for (ACE_UINT32 i = 0; written && i < _index.size(); i += chunk.size()) {
+      ACE_UINT32 const count = std::min(static_cast<ACE_UINT32>(chunk.size()), _index.size() - i);
+      written = _index.read(i, count, &chunk[0]);
+      for (ACE_UINT32 j = 0; written && j < count; ++j) {
+        LogFieldIndex::Posting const& posting = chunk[j];
+        if (placed[posting.value] < _index.count(posting.value)) {
+          memcpy(area + events[posting.value] + placed[posting.value] * sizeof(ACE_UINT32),
+                 &posting.event, sizeof(ACE_UINT32));
+          ++placed[posting.value];
+        }
+      }
+    }
+
+    // the rename must not overtake the data
+    written = written && memMap.sync() == 0;
+    int const error = errno;
+    memMap.close();
+
+    if (!written) {
+      ACE_OS::unlink(tmp.c_str());
+      throw CException(error, "Writing " + tmp + ": " + strerror(error));
+    }
+    LogIndexFile::replace(tmp, name);
+
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "LogFieldIndexFile - Wrote " << name << std::endl <<
+                  "LogFieldIndexFile - Fields: " << fields.size() << std::endl <<
+                  "LogFieldIndexFile - Postings: " << _index.size());
+  }
+
+  bool
+  LogFieldIndexFile::build(std::string const& _logFile,
+                           std::vector<std::string> const& _fields) throw(Exception)
+  {
+    LogReader reader(_logFile);
+    if (reader.live())
+      throw Exception("Log file " + _logFile + " is still being written.");
+
+    // an up to date field index, holding all the fields
+    {
+      LogFieldIndexFile file(_logFile, reader.events());
+      std::vector<std::string>::const_iterator first, last = _fields.end();
+      for (first = _fields.begin(); first != last; ++first)
+        if (!file.hasField(*first))
+          break;
+      if (file.valid() && first == last)
+        return false;
+    }
+
+    LogFieldIndex index(_fields);
+    reader.access(LogReader::SEQUENTIAL);
+    LogCursor cursor(reader);
+    while (cursor.next())
+      index.add(cursor.number(), cursor.filterableData());
+
+    write(_logFile, reader.events(), index);
+    return true;
+  }
+}
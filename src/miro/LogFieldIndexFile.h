@@ -0,0 +1,214 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogFieldIndexFile_h
+#define miro_LogFieldIndexFile_h
+
+#include "LogFieldIndex.h"
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <ace/Mem_Map.h>
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  //! Sidecar index of filterable data fields of a log file.
+  /**
+   * The field index (<log file>.fdx) holds the event numbers of the
+   * events carrying a value of an indexed field of their filterable
+   * data, grouped by the value (see @ref LogFieldIndex). It is written
+   * by the @ref LogWriter on close, if configured (IndexField), or by
+   * the offline indexer, see @ref build().
+   *
+   * The sidecar is mapped and queried in place: The values of each
+   * field are kept in sorted tables, so a query is a binary search
+   * followed by a copy of the event numbers of the value. Like the
+   * sidecar event index (see @ref LogIndexFile), it is only valid as
+   * long as size and modification time of the log file and its number
+   * of events match the values recorded in the sidecar.
+   *
+   * The sidecar is written through a mapping as well, the event
+   * numbers are placed while streaming the spilled postings of the
+   * index, so writing it takes a bounded amount of memory.
+   *
+   * The field index is stored in host byte order. Sidecars of foreign
+   * byte order are ignored.
+   */
+  class miro_Export LogFieldIndexFile
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! Header block of the field index.
+    struct Header
+    {
+      ACE_UINT32 id;
+      ACE_UINT16 version;
+      ACE_UINT16 byteOrder;
+    };
+
+    //! Entry of the string value table of a field.
+    struct StringEntry
+    {
+      //! Offset of the characters in the data area.
+      ACE_UINT64 value;
+      //! Offset of the event numbers in the data area.
+      ACE_UINT64 events;
+      //! Number of events.
+      ACE_UINT32 count;
+      //! Number of characters.
+      ACE_UINT32 length;
+    };
+
+    //! Entry of the numeric value table of a field.
+    struct NumberEntry
+    {
+      //! Lower bound of the range of values, see @ref LogFieldIndex::range().
+      double value;
+      //! Offset of the event numbers in the data area.
+      ACE_UINT64 events;
+      //! Number of events.
+      ACE_UINT32 count;
+      ACE_UINT32 reserved;
+    };
+
+    //! Ascending event numbers.
+    typedef LogFieldIndex::EventVector EventVector;
+
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    static ACE_UINT32 const PROTOCOL_ID = 0x5844464d;      // "MFDX";
+    static ACE_UINT16 const PROTOCOL_VERSION = 0x0001;
+
+    //! File name suffix of the field index.
+    static char const * const SUFFIX;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Open the field index of a log file.
+    /**
+     * Check @ref valid() for success. Missing, corrupted or stale
+     * sidecars are not considered to be an error.
+     */
+    LogFieldIndexFile(std::string const& _logFile, ACE_UINT32 _numEvents);
+    //! Cleaning up.
+    ~LogFieldIndexFile();
+
+    //! Flag indicating a valid field index.
+    bool valid() const throw();
+    //! Flag indicating the field is indexed.
+    bool hasField(std::string const& _field) const throw();
+
+    //! Events with the string value in the field.
+    /** Returns the number of events. */
+    ACE_UINT32 find(std::string const& _field, std::string const& _value,
+                    EventVector& _events) const;
+    //! Events with a numeric value within [_min, _max] in the field.
+    /**
+     * As numeric values are indexed by ranges, the events of the
+     * ranges holding the bounds are included, even if their values lie
+     * just outside. Returns the number of events.
+     */
+    ACE_UINT32 find(std::string const& _field, double _min, double _max,
+                    EventVector& _events) const;
+
+    //! Name of the field index of a log file.
+    static std::string fileName(std::string const& _logFile);
+    //! Write the field index of a log file.
+    /**
+     * The sidecar is written to a temporary file, which is renamed
+     * afterwards. So concurrent readers never see a partial index.
+     */
+    static void write(std::string const& _logFile, ACE_UINT32 _numEvents,
+                      LogFieldIndex const& _index) throw(Exception);
+    //! Scan a log file and write the field index of the fields.
+    /**
+     * Returns false, if the log file already has an up to date
+     * field index of all the fields and no sidecar was written.
+     */
+    static bool build(std::string const& _logFile,
+                      std::vector<std::string> const& _fields) throw(Exception);
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! The value tables of an indexed field.
+    struct Field
+    {
+      std::string name;
+      StringEntry const * strings;
+      ACE_UINT32 numStrings;
+      NumberEntry const * numbers;
+      ACE_UINT32 numNumbers;
+    };
+    typedef std::vector<Field> FieldVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Parse and validate the mapped sidecar.
+    bool parse(std::string const& _logFile, ACE_UINT32 _numEvents) throw();
+    //! The tables of the field, NULL if not indexed.
+    Field const * field(std::string const& _field) const throw();
+    //! Append the event numbers at @ref _offset of the data area.
+    void append(ACE_UINT64 _offset, ACE_UINT32 _count, EventVector& _events) const;
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Memory mapped sidecar.
+    ACE_Mem_Map memMap_;
+    //! The data area, within the mapped sidecar.
+    char const * data_;
+    //! Length of the data area.
+    size_t dataLength_;
+    //! The indexed fields.
+    FieldVector fields_;
+  };
+
+  inline
+  bool
+  LogFieldIndexFile::valid() const throw()
+  {
+    return data_ != NULL;
+  }
+
+  inline
+  bool
+  LogFieldIndexFile::hasField(std::string const& _field) const throw()
+  {
+    return field(_field) != NULL;
+  }
+}
+#endif // miro_LogFieldIndexFile_h
@@ -0,0 +1,198 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogFileRotator.h"
+#include "LogWriter.h"
+#include "Log.h"
+#include "Exception.h"
+
+#include <ace/OS_NS_unistd.h>
+
+#include <sstream>
+
+namespace Miro
+{
+  LogFileRotator::LogFileRotator(std::string const& _fileName,
+                                 LogNotifyParameters const& _parameters) :
+      parameters_(_parameters),
+      fileName_(_fileName),
+      mutex_(),
+      work_(mutex_),
+      ready_(mutex_),
+      logNum_(0),
+      standby_(NULL),
+      standbyPending_(false),
+      closed_(false)
+  {
+    MIRO_LOG_CTOR("Miro::LogFileRotator");
+  }
+
+  LogFileRotator::~LogFileRotator()
+  {
+    MIRO_LOG_DTOR("Miro::LogFileRotator");
+    close();
+  }
+
+  std::string
+  LogFileRotator::segmentName(std::string const& _fileName, int _num)
+  {
+    std::stringstream num;
+    num << "-";
+    num.width(2);
+    num.fill('0');
+    num << _num << ".mlog";
+    return _fileName + num.str();
+  }
+
+  LogWriter *
+  LogFileRotator::open()
+  {
+    LogWriter * writer = new LogWriter(segmentName(fileName_, logNum_), parameters_);
+
+    // the helper thread is only needed for preparing standby segments
+    if (parameters_.standbyFile) {
+      if (activate() == -1) {
+        delete writer;
+        throw CException(errno, "LogFileRotator - Failed to spawn helper thread.");
+      }
+
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      standbyPending_ = true;
+      work_.signal();
+    }
+    return writer;
+  }
+
+  LogWriter *
+  LogFileRotator::rotate(LogWriter * _full)
+  {
+    // without helper thread, the full segment is finalized in place
+    if (!parameters_.standbyFile) {
+      delete _full;
+      return new LogWriter(segmentName(fileName_, ++logNum_), parameters_);
+    }
+
+    LogWriter * next = NULL;
+    int num;
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+
+      // leave finalization to the helper thread
+      retired_.push_back(_full);
+
+      // only wait, if rotating faster than the next file can be created
+      while (standbyPending_)
+        ready_.wait();
+
+      next = standby_;
+      standby_ = NULL;
+      num = ++logNum_;
+
+      standbyPending_ = parameters_.standbyFile;
+      work_.signal();
+    }
+
+    // standby segment disabled or its creation failed
+    if (next == NULL) {
+      next = new LogWriter(segmentName(fileName_, num), parameters_);
+    }
+    return next;
+  }
+
+  void
+  LogFileRotator::close()
+  {
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      closed_ = true;
+      work_.signal();
+    }
+    wait();
+
+    // discard the unused standby segment
+    if (standby_ != NULL) {
+      delete standby_;
+      standby_ = NULL;
+
+      std::string const name = segmentName(fileName_, logNum_ + 1);
+      if (ACE_OS::unlink(name.c_str()) == -1) {
+        MIRO_LOG_OSTR(LL_WARNING,
+                      "LogFileRotator - Error " << errno <<
+                      " removing standby log file " << name);
+      }
+    }
+  }
+
+  int
+  LogFileRotator::svc()
+  {
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "[Miro::LogFileRotator] starts in thread " << ACE_Thread::self());
+
+    mutex_.acquire();
+    while (true) {
+      while (!closed_ && !standbyPending_ && retired_.empty())
+        work_.wait();
+
+      // finalize full segments
+      if (!retired_.empty()) {
+        std::vector<LogWriter *> retired;
+        retired.swap(retired_);
+
+        mutex_.release();
+        std::vector<LogWriter *>::const_iterator first, last = retired.end();
+        for (first = retired.begin(); first != last; ++first) {
+          delete *first;
+        }
+        mutex_.acquire();
+      }
+      // prepare the next segment
+      else if (standbyPending_ && !closed_) {
+        std::string const name = segmentName(fileName_, logNum_ + 1);
+
+        mutex_.release();
+        LogWriter * writer = NULL;
+        try {
+          writer = new LogWriter(name, parameters_);
+          writer->prefault(parameters_.prefaultSize);
+        }
+        catch (Miro::Exception const& e) {
+          MIRO_LOG_OSTR(LL_ERROR,
+                        "LogFileRotator - Failed to create standby log file " << name << ": " << e);
+        }
+        mutex_.acquire();
+
+        standby_ = writer;
+        standbyPending_ = false;
+        ready_.broadcast();
+      }
+      else if (closed_) {
+        break;
+      }
+    }
+
+    // don't leave anyone waiting
+    standbyPending_ = false;
+    ready_.broadcast();
+    mutex_.release();
+
+    return 0;
+  }
+}
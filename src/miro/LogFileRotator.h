@@ -0,0 +1,108 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogFileRotator_h
+#define miro_LogFileRotator_h
+
+#include "miro/Parameters.h"
+
+#include "miro_Export.h"
+
+#include <ace/Task.h>
+#include <ace/Synch.h>
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  // forward declarations
+  class LogWriter;
+
+  //! Manages the segments (<name>-NN.mlog) of a rotating event log.
+  /**
+   * A helper thread pre-creates and pre-faults the next segment of the
+   * log, while the current one is written. Full segments are handed
+   * back and finalized (type code repository packing, truncation) by
+   * the same thread. So switching to the next segment is a pointer
+   * swap on the event delivery path. Without StandbyFile, no helper
+   * thread is started and segments are switched in place.
+   */
+  class miro_Export LogFileRotator : public ACE_Task_Base
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    LogFileRotator(std::string const& _fileName,
+                   LogNotifyParameters const& _parameters = *LogNotifyParameters::instance());
+    //! Finalizes all segments.
+    virtual ~LogFileRotator();
+
+    //! Open the first segment of the log and start the helper thread, if needed.
+    LogWriter * open();
+    //! Switch to the next segment.
+    /**
+     * Ownership of @ref _full is passed to the rotator, ownership of
+     * the returned writer to the caller. Blocks only, if the standby
+     * segment is not yet ready.
+     */
+    LogWriter * rotate(LogWriter * _full);
+    //! Finalize retired segments, discard the standby segment and stop the helper thread.
+    void close();
+
+    //! Name of the segment with number @ref _num.
+    static std::string segmentName(std::string const& _fileName, int _num);
+
+    // methods defined by ACE_Task_Base
+    virtual int svc();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Reference to the parameters.
+    LogNotifyParameters const& parameters_;
+    //! Base name of the log files.
+    std::string const fileName_;
+
+    //! Lock protecting the state below.
+    ACE_Thread_Mutex mutex_;
+    //! Signaled on pending work for the helper thread.
+    ACE_Condition_Thread_Mutex work_;
+    //! Signaled when the standby segment is created.
+    ACE_Condition_Thread_Mutex ready_;
+
+    //! Number of the current segment.
+    int logNum_;
+    //! The pre-created next segment.
+    LogWriter * standby_;
+    //! Flag indicating, that the standby segment is under construction.
+    bool standbyPending_;
+    //! Full segments to be finalized.
+    std::vector<LogWriter *> retired_;
+    //! Flag indicating that the rotator is shut down.
+    bool closed_;
+  };
+}
+#endif // miro_LogFileRotator_h
@@ -0,0 +1,246 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogFlightRecorder.h"
+#include "LogWriter.h"
+#include "Log.h"
+#include "Exception.h"
+
+#include <orbsvcs/Time_Utilities.h>
+
+#include <ace/Message_Block.h>
+#include <ace/OS_NS_string.h>
+
+#include <algorithm>
+
+namespace Miro
+{
+  LogFlightRecorder::LogFlightRecorder(LogNotifyParameters const& _parameters) :
+      parameters_(_parameters),
+      duration_(0),
+      buffer_(NULL),
+      base_(NULL),
+      capacity_(ACE_align_binary(std::max(static_cast<size_t>(_parameters.ringSize),
+                                          static_cast<size_t>(ACE_CDR::MAX_ALIGNMENT)),
+                                 ACE_CDR::LONGLONG_SIZE)),
+      ostr_(NULL),
+      head_(0),
+      size_(0),
+      tcrOstr_(_parameters.tCRFileSize),
+      typeRepository_(&tcrOstr_, _parameters.tCRFileSize)
+  {
+    MIRO_LOG_CTOR("Miro::LogFlightRecorder");
+
+    ORBSVCS_Time::Time_Value_to_TimeT(duration_, parameters_.ringDuration);
+
+    buffer_ = new ACE_Message_Block(capacity_ + ACE_CDR::MAX_ALIGNMENT);
+    ACE_CDR::mb_align(buffer_);
+    base_ = buffer_->rd_ptr();
+    // touch the ring, so recording does not page fault
+    ACE_OS::memset(base_, 0, capacity_);
+
+    ostr_ = new TAO_OutputCDR(base_, capacity_);
+  }
+
+  LogFlightRecorder::~LogFlightRecorder()
+  {
+    MIRO_LOG_DTOR("Miro::LogFlightRecorder");
+
+    delete ostr_;
+    buffer_->release();
+  }
+
+  bool
+  LogFlightRecorder::logEvent(ACE_Time_Value const& _stamp,
+                              CosNotification::StructuredEvent const& _event)
+  {
+    // obtain type code id
+    CORBA::Long typeId = -1;
+    CORBA::TypeCode_var tc = _event.remainder_of_body.type();
+    if (tc.in() != CORBA::_tc_null) {
+      typeId = typeRepository_.typeID(tc.in());
+    }
+    if (typeId == -2) {
+      MIRO_LOG(LL_ERROR, "LogFlightRecorder - Type code repository full. Event dropped.");
+      return false;
+    }
+
+    TimeBase::TimeT t;
+    ORBSVCS_Time::Absolute_Time_Value_to_TimeT(t, _stamp);
+
+    size_t offset = head_;
+    char * end = marshal(offset, t, _event, typeId);
+    if (end == NULL) {
+      // the failed attempt overwrote the oldest events up to the end of the ring,
+      // so wrap around
+      evict(head_, capacity_);
+      offset = 0;
+      end = marshal(offset, t, _event, typeId);
+      if (end == NULL) {
+        MIRO_LOG_OSTR(LL_ERROR,
+                      "LogFlightRecorder - Event of type " <<
+                      _event.header.fixed_header.event_type.type_name <<
+                      " exceeds the ring size. Recorded events lost.");
+        while (!records_.empty())
+          popRecord();
+        head_ = 0;
+        return false;
+      }
+    }
+
+    Record record;
+    record.stamp = t;
+    record.offset = offset;
+    record.length = end - (base_ + offset);
+    record.type = eventTypes_.eventTypeID(_event.header.fixed_header.event_type);
+
+    evict(record.offset, record.offset + record.length);
+    records_.push_back(record);
+    size_ += record.length;
+    head_ = record.offset + record.length;
+
+    // forget events beyond the time window
+    if (duration_ != 0) {
+      while (records_.front().stamp + duration_ < t)
+        popRecord();
+    }
+
+    return true;
+  }
+
+  char *
+  LogFlightRecorder::marshal(size_t _offset,
+                             TimeBase::TimeT _stamp,
+                             CosNotification::StructuredEvent const& _event,
+                             CORBA::Long _typeId)
+  {
+    ostr_->reset();
+    ostr_->current()->wr_ptr(_offset);
+
+    char * end = marshaller_.marshal(*ostr_, _stamp, _event, _typeId);
+    if (end == NULL) {
+      // start over with a clean stream
+      delete ostr_;
+      ostr_ = new TAO_OutputCDR(base_, capacity_);
+    }
+    return end;
+  }
+
+  void
+  LogFlightRecorder::evict(size_t _first, size_t _last)
+  {
+    // the oldest events follow the head of the ring
+    while (!records_.empty() &&
+           records_.front().offset < _last &&
+           records_.front().offset + records_.front().length > _first) {
+      popRecord();
+    }
+  }
+
+  void
+  LogFlightRecorder::popRecord()
+  {
+    size_ -= records_.front().length;
+    records_.pop_front();
+  }
+
+  LogFlightRecorder::Snapshot::Snapshot() :
+      buffer(NULL),
+      base(NULL),
+      size(0)
+  {}
+
+  LogFlightRecorder::Snapshot::~Snapshot()
+  {
+    if (buffer != NULL)
+      buffer->release();
+  }
+
+  void
+  LogFlightRecorder::dump(std::string const& _fileName) throw(Exception)
+  {
+    Snapshot * s = snapshot();
+    try {
+      dump(*s, _fileName, parameters_);
+    }
+    catch (...) {
+      delete s;
+      throw;
+    }
+    delete s;
+  }
+
+  LogFlightRecorder::Snapshot *
+  LogFlightRecorder::snapshot()
+  {
+    Snapshot * s = new Snapshot();
+    s->buffer = new ACE_Message_Block(size_ + (records_.size() + 1) * ACE_CDR::MAX_ALIGNMENT);
+    ACE_CDR::mb_align(s->buffer);
+    s->base = s->buffer->rd_ptr();
+
+    // copy the records without the gaps of the ring
+    RecordQueue::const_iterator first, last = records_.end();
+    for (first = records_.begin(); first != last; ++first) {
+      Record record = *first;
+      record.offset = s->size + ((record.offset - s->size) & (ACE_CDR::MAX_ALIGNMENT - 1));
+      ACE_OS::memcpy(s->base + record.offset, base_ + first->offset, record.length);
+      s->size = record.offset + record.length;
+      s->records.push_back(record);
+    }
+
+    eventTypes_.eventTypes(s->types);
+    CORBA::TypeCode_ptr tc;
+    for (CORBA::Long id = 0; (tc = typeRepository_.typeCode(id)) != CORBA::_tc_null; ++id)
+      s->typeCodes.push_back(CORBA::TypeCode::_duplicate(tc));
+
+    return s;
+  }
+
+  void
+  LogFlightRecorder::dump(Snapshot const& _snapshot, std::string const& _fileName,
+                          LogNotifyParameters const& _parameters) throw(Exception)
+  {
+    // a plain log file, large enough for all recorded events
+    LogNotifyParameters parameters(_parameters);
+    parameters.compress = false;
+    parameters.maxFileSize = static_cast<unsigned long>(-1);
+    parameters.extentSize =
+      _snapshot.size + ACE_CDR::MAX_ALIGNMENT + 4 * sizeof(ACE_UINT64) + sizeof(LogHeader);
+
+    LogWriter writer(_fileName, parameters);
+
+    // reproduce the type ids of the ring in the type code repository of the log file
+    for (CORBA::Long id = 0; id < static_cast<CORBA::Long>(_snapshot.typeCodes.size()); ++id) {
+      if (writer.typeID(_snapshot.typeCodes[id].in()) != id)
+        throw Exception("LogFlightRecorder - Type code repository mismatch in " + _fileName);
+    }
+
+    RecordQueue::const_iterator first, last = _snapshot.records.end();
+    for (first = _snapshot.records.begin(); first != last; ++first) {
+      if (!writer.logRecord(first->stamp, _snapshot.types[first->type],
+                            _snapshot.base + first->offset, first->length))
+        throw Exception("LogFlightRecorder - Failed to dump all events into " + _fileName);
+    }
+
+    MIRO_LOG_OSTR(LL_NOTICE,
+                  "LogFlightRecorder - Dumped " << _snapshot.records.size() <<
+                  " events into " << _fileName);
+  }
+}
@@ -0,0 +1,198 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogFlightRecorder_h
+#define miro_LogFlightRecorder_h
+
+#include "LogEventMarshaller.h"
+#include "LogIndex.h"
+#include "LogTypeRepository.h"
+#include "miro/Parameters.h"
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+#include <ace/Time_Value.h>
+#include <tao/CDR.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+// forward declarations
+class ACE_Message_Block;
+
+namespace Miro
+{
+  //! In memory ring buffer of the most recent events.
+  /**
+   * The flight recorder keeps the events of the last RingDuration,
+   * at most RingSize bytes of them, marshalled in the format of the
+   * log file. The ring and the type code repository are allocated
+   * up front, so recording an event is a marshalling pass (a block
+   * copy for the CDR encoded events of the notification channel)
+   * into memory, without file I/O.
+   *
+   * On demand, the recorded events are dumped into a log file, that
+   * the @ref LogReader and the LogPlayer can open. A snapshot of the
+   * recorded events can be written by another thread, while the
+   * recording goes on.
+   */
+  class miro_Export LogFlightRecorder
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! Copy of the recorded events, see @ref snapshot().
+    struct Snapshot;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    LogFlightRecorder(LogNotifyParameters const& _parameters = *LogNotifyParameters::instance());
+    //! Cleaning up.
+    ~LogFlightRecorder();
+
+    //! Record an event, dropping the oldest ones as necessary.
+    /** Returns false, if the event could not be recorded. */
+    bool logEvent(ACE_Time_Value const& _stamp,
+                  CosNotification::StructuredEvent const& _event);
+    //! Write the recorded events into a log file.
+    /** The recorded events are kept. */
+    void dump(std::string const& _fileName) throw(Exception);
+    //! Copy the recorded events, to be dumped without the recorder.
+    /** Ownership of the snapshot is passed to the caller. */
+    Snapshot * snapshot();
+    //! Write the events of a snapshot into a log file.
+    static void dump(Snapshot const& _snapshot, std::string const& _fileName,
+                     LogNotifyParameters const& _parameters) throw(Exception);
+
+    //! Number of recorded events.
+    size_t events() const;
+    //! Number of bytes occupied by the recorded events.
+    size_t size() const;
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Location of a recorded event in the ring.
+    struct Record
+    {
+      TimeBase::TimeT stamp;
+      size_t offset;
+      size_t length;
+      //! Index of the event type in @ref eventTypes_.
+      ACE_UINT32 type;
+    };
+    //! The recorded events, oldest first.
+    typedef std::deque<Record> RecordQueue;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Marshal the event at @ref _offset into the ring.
+    /** Returns the end of the event, NULL if it did not fit. */
+    char * marshal(size_t _offset,
+                   TimeBase::TimeT _stamp,
+                   CosNotification::StructuredEvent const& _event,
+                   CORBA::Long _typeId);
+    //! Drop the oldest events, overlapping the ring section [@ref _first, @ref _last).
+    void evict(size_t _first, size_t _last);
+    //! Drop the front record.
+    void popRecord();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Reference to the parameters.
+    LogNotifyParameters const& parameters_;
+    //! Maximum age of the recorded events, 0 for no limit.
+    TimeBase::TimeT duration_;
+    //! The ring memory.
+    ACE_Message_Block * buffer_;
+    //! 8 byte aligned start of the ring.
+    char * base_;
+    //! Size of the ring.
+    size_t capacity_;
+    //! CDR stream spanning the ring.
+    TAO_OutputCDR * ostr_;
+    //! Offset of the next event in the ring.
+    size_t head_;
+    //! Number of bytes occupied by the recorded events.
+    size_t size_;
+    //! The recorded events.
+    RecordQueue records_;
+    //! Marshals the events in the format of the log file.
+    LogEventMarshaller marshaller_;
+    //! CDR stream holding the type code repository.
+    TAO_OutputCDR tcrOstr_;
+    //! Type code repository of the recorded events.
+    LogTypeRepository typeRepository_;
+    //! Event types of the recorded events.
+    LogIndex eventTypes_;
+  };
+
+  //! Copy of the recorded events.
+  struct miro_Export LogFlightRecorder::Snapshot
+  {
+    Snapshot();
+    ~Snapshot();
+
+    //! The copied records, at the alignment they had in the ring.
+    ACE_Message_Block * buffer;
+    //! 8 byte aligned start of the copy.
+    char * base;
+    //! Number of bytes of the copy.
+    size_t size;
+    //! The records, located in the copy.
+    RecordQueue records;
+    //! Event types of the records.
+    CosNotification::EventTypeSeq types;
+    //! Type codes, indexed by the type ids of the records.
+    std::vector<CORBA::TypeCode_var> typeCodes;
+
+  private:
+    Snapshot(Snapshot const&);
+    Snapshot& operator = (Snapshot const&);
+  };
+
+  inline
+  size_t
+  LogFlightRecorder::events() const
+  {
+    return records_.size();
+  }
+
+  inline
+  size_t
+  LogFlightRecorder::size() const
+  {
+    return size_;
+  }
+}
+#endif // miro_LogFlightRecorder_h
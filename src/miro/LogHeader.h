@@ -39,13 +39,79 @@ namespace Miro
     struct READ {};
     struct WRITE {};
 
+    //! Entry of the event index (version >= 6).
+    /**
+     * The index is an array of these entries, stored in the byte order
+     * of the log file behind the type code repository.
+     */
+    struct IndexEntry {
+      //! Time stamp of the event (TimeBase::TimeT).
+      ACE_UINT64 stamp;
+      //! File offset of the event record.
+      /** For compressed log files, the offset within the uncompressed block. */
+      ACE_UINT64 offset;
+      //! Index into the event type table of the event index.
+      ACE_UINT32 type;
+      ACE_UINT32 reserved;
+    };
+
+    //! Entry of the event index of version 5, with 32 bit offsets.
+    struct IndexEntryV5 {
+      ACE_UINT64 stamp;
+      ACE_UINT32 offset;
+      ACE_UINT32 type;
+    };
+
+    //! Header of an event block of a compressed log file.
+    /**
+     * Followed by @ref length bytes of compressed events. Stored in
+     * the byte order of the log file.
+     */
+    struct BlockHeader {
+      //! Length of the compressed block.
+      ACE_UINT32 length;
+      //! Length of the uncompressed block.
+      ACE_UINT32 rawLength;
+      //! Number of events in the block.
+      ACE_UINT32 events;
+      //! The codec of the block (see @ref LogBlockCodec).
+      ACE_UINT32 codec;
+    };
+
+    //! Entry of the block index of a compressed log file (version >= 6).
+    struct BlockEntry {
+      //! Time stamp of the first event of the block (TimeBase::TimeT).
+      ACE_UINT64 firstStamp;
+      //! Time stamp of the last event of the block (TimeBase::TimeT).
+      ACE_UINT64 lastStamp;
+      //! File offset of the block header.
+      ACE_UINT64 offset;
+      //! Number of the first event of the block.
+      ACE_UINT64 firstEvent;
+    };
+
+    //! Entry of the block index of version 5, with 32 bit offsets.
+    struct BlockEntryV5 {
+      ACE_UINT64 firstStamp;
+      ACE_UINT64 lastStamp;
+      ACE_UINT32 offset;
+      ACE_UINT32 firstEvent;
+    };
+
     //--------------------------------------------------------------------------
     // public constants
     //--------------------------------------------------------------------------
 
     static ACE_UINT32 const PROTOCOL_ID = 0x474f4c4d;      // "MLOG";
-    static ACE_UINT16 const PROTOCOL_VERSION = 0x0004;
-    static ACE_UINT16 const MAX_VERSION = 0x0004;
+    static ACE_UINT16 const PROTOCOL_VERSION = 0x0006;
+    static ACE_UINT16 const MAX_VERSION = 0x0006;
+    //! First version holding an event index.
+    static ACE_UINT16 const INDEX_VERSION = 0x0005;
+    //! First version with 64 bit offsets and counts.
+    static ACE_UINT16 const WIDE_VERSION = 0x0006;
+
+    //! Flag: The events are stored in compressed blocks (version >= 5).
+    static ACE_UINT32 const FLAG_COMPRESSED = 0x0001;
 
     //--------------------------------------------------------------------------
     // public methods
@@ -54,6 +120,9 @@ namespace Miro
     LogHeader(WRITE);
     LogHeader(READ) throw(EFileType, EVersion);
 
+    //! Size of the offset and count fields following the header.
+    static size_t slotSize(ACE_UINT16 _version) throw();
+
     //--------------------------------------------------------------------------
     // public data
     //--------------------------------------------------------------------------
@@ -62,5 +131,12 @@ namespace Miro
     ACE_UINT16 version;
     ACE_UINT16 byteOrder;
   };
+
+  inline
+  size_t
+  LogHeader::slotSize(ACE_UINT16 _version) throw()
+  {
+    return (_version >= WIDE_VERSION)? sizeof(ACE_UINT64) : sizeof(ACE_UINT32);
+  }
 }
 #endif // miro_LogHeader_h
@@ -0,0 +1,188 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogIndex.h"
+#include "Log.h"
+
+#include <ace/ACE.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_string.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Miro
+{
+  LogIndex::LogIndex(ACE_UINT32 _chunkSize) :
+      chunkSize_(std::max(_chunkSize, ACE_UINT32(1))),
+      spilled_(0),
+      spillFile_(ACE_INVALID_HANDLE),
+      inMemory_(false),
+      lastEventType_(eventTypes_.end())
+  {}
+
+  LogIndex::~LogIndex()
+  {
+    if (spillFile_ != ACE_INVALID_HANDLE)
+      ACE_OS::close(spillFile_);
+  }
+
+  void
+  LogIndex::add(TimeBase::TimeT _stamp, ACE_UINT64 _offset,
+                CosNotification::EventType const& _type)
+  {
+    LogHeader::IndexEntry entry;
+    entry.stamp = _stamp;
+    entry.offset = _offset;
+    entry.type = eventTypeID(_type);
+    entry.reserved = 0;
+    entries_.push_back(entry);
+
+    if (entries_.size() >= chunkSize_ && !inMemory_)
+      spill();
+  }
+
+  void
+  LogIndex::clear()
+  {
+    IndexVector().swap(entries_);
+    spilled_ = 0;
+    eventTypes_.clear();
+    lastEventType_ = eventTypes_.end();
+  }
+
+  void
+  LogIndex::truncate(ACE_UINT32 _size)
+  {
+    if (_size < spilled_) {
+      // the spilled entries beyond are overwritten by the next chunk
+      spilled_ = _size;
+      entries_.clear();
+    }
+    else if (_size - spilled_ < entries_.size()) {
+      entries_.resize(_size - spilled_);
+    }
+  }
+
+  bool
+  LogIndex::copy(LogHeader::IndexEntry * _dest) const
+  {
+    // one chunk per read, as single reads are limited in size
+    for (ACE_UINT32 first = 0; first < spilled_; first += chunkSize_) {
+      if (!read(first, std::min(chunkSize_, spilled_ - first), _dest + first))
+        return false;
+    }
+    if (!entries_.empty())
+      memcpy(_dest + spilled_, &entries_[0], entries_.size() * sizeof(LogHeader::IndexEntry));
+    return true;
+  }
+
+  bool
+  LogIndex::write(ACE_HANDLE _handle) const
+  {
+    IndexVector chunk(std::min(chunkSize_, spilled_));
+    for (ACE_UINT32 first = 0; first < spilled_; first += chunk.size()) {
+      ACE_UINT32 const count = std::min(static_cast<ACE_UINT32>(chunk.size()), spilled_ - first);
+      size_t const length = count * sizeof(LogHeader::IndexEntry);
+      if (!read(first, count, &chunk[0]) ||
+          ACE_OS::write(_handle, &chunk[0], length) != static_cast<ssize_t>(length))
+        return false;
+    }
+
+    size_t const length = entries_.size() * sizeof(LogHeader::IndexEntry);
+    return length == 0 ||
+      ACE_OS::write(_handle, &entries_[0], length) == static_cast<ssize_t>(length);
+  }
+
+  void
+  LogIndex::spill()
+  {
+    if (spillFile_ == ACE_INVALID_HANDLE) {
+      char name[MAXPATHLEN];
+      if (ACE::get_temp_dir(name, MAXPATHLEN - 16) != -1) {
+        ACE_OS::strcat(name, "miroIndexXXXXXX");
+        spillFile_ = ACE_OS::mkstemp(name);
+      }
+      // the file is removed along with its handle
+      if (spillFile_ != ACE_INVALID_HANDLE)
+        ACE_OS::unlink(name);
+    }
+
+    size_t const length = entries_.size() * sizeof(LogHeader::IndexEntry);
+    if (spillFile_ == ACE_INVALID_HANDLE ||
+        ACE_OS::pwrite(spillFile_, &entries_[0], length,
+                       static_cast<ACE_OFF_T>(spilled_) * sizeof(LogHeader::IndexEntry)) !=
+        static_cast<ssize_t>(length)) {
+      MIRO_LOG_OSTR(LL_WARNING,
+                    "LogIndex - Could not spill the event index, keeping it in memory: " <<
+                    strerror(errno));
+      inMemory_ = true;
+      return;
+    }
+
+    spilled_ += entries_.size();
+    entries_.clear();
+  }
+
+  bool
+  LogIndex::read(ACE_UINT32 _first, ACE_UINT32 _count,
+                 LogHeader::IndexEntry * _dest) const
+  {
+    size_t const length = _count * sizeof(LogHeader::IndexEntry);
+    return length == 0 ||
+      ACE_OS::pread(spillFile_, _dest, length,
+                    static_cast<ACE_OFF_T>(_first) * sizeof(LogHeader::IndexEntry)) ==
+      static_cast<ssize_t>(length);
+  }
+
+  void
+  LogIndex::eventTypes(CosNotification::EventTypeSeq& _types) const
+  {
+    _types.length(eventTypes_.size());
+    EventTypeMap::const_iterator first, last = eventTypes_.end();
+    for (first = eventTypes_.begin(); first != last; ++first) {
+      _types[first->second].domain_name = CORBA::string_dup(first->first.first.c_str());
+      _types[first->second].type_name = CORBA::string_dup(first->first.second.c_str());
+    }
+  }
+
+  ACE_UINT32
+  LogIndex::eventTypeID(CosNotification::EventType const& _type)
+  {
+    char const * const domainName = _type.domain_name;
+    char const * const typeName = _type.type_name;
+
+    // events usually come in streams of the same type
+    if (lastEventType_ != eventTypes_.end() &&
+        lastEventType_->first.second == typeName &&
+        lastEventType_->first.first == domainName) {
+      return lastEventType_->second;
+    }
+
+    EventTypeName name(domainName, typeName);
+    EventTypeMap::iterator where = eventTypes_.find(name);
+    if (where == eventTypes_.end()) {
+      where = eventTypes_.insert(std::make_pair(name, ACE_UINT32(eventTypes_.size()))).first;
+    }
+    lastEventType_ = where;
+    return where->second;
+  }
+}
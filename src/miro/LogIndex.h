@@ -0,0 +1,163 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogIndex_h
+#define miro_LogIndex_h
+
+#include "LogHeader.h"
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace Miro
+{
+  //! In memory event index of a log file.
+  /**
+   * Collects the time stamp, file offset and event type of the
+   * events of a log file. Used by the @ref LogWriter for the index
+   * footer of the log file and by the @ref LogIndexFile for the
+   * sidecar index of log files without one.
+   *
+   * Only the most recent chunk of entries is kept in memory. Full
+   * chunks are spilled to an anonymous temporary file, so indexing a
+   * log file of any size takes a bounded amount of memory. If no
+   * temporary file can be written, the entries stay in memory.
+   */
+  class miro_Export LogIndex
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! The index entries.
+    typedef std::vector<LogHeader::IndexEntry> IndexVector;
+
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    //! Default number of entries kept in memory.
+    static ACE_UINT32 const CHUNK_SIZE = 64 * 1024;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /** Keeps at most @ref _chunkSize entries in memory. */
+    LogIndex(ACE_UINT32 _chunkSize = CHUNK_SIZE);
+    //! Cleaning up.
+    ~LogIndex();
+
+    //! Append an event to the index.
+    void add(TimeBase::TimeT _stamp, ACE_UINT64 _offset,
+             CosNotification::EventType const& _type);
+    //! Remove all entries.
+    void clear();
+    //! Drop the entries beyond the first @ref _size ones.
+    void truncate(ACE_UINT32 _size);
+
+    //! Number of indexed events.
+    ACE_UINT32 size() const;
+    //! Number of entries spilled to the temporary file.
+    ACE_UINT32 spilled() const;
+    //! Copy the index entries, in host byte order, to @ref _dest.
+    /** Returns false on error, errno tells the cause. */
+    bool copy(LogHeader::IndexEntry * _dest) const;
+    //! Write the index entries, in host byte order, to the file.
+    /**
+     * Written at the current position of the file, one chunk at a time.
+     * Returns false on error, errno tells the cause.
+     */
+    bool write(ACE_HANDLE _handle) const;
+    //! The event type table, ordered by the type index of the entries.
+    void eventTypes(CosNotification::EventTypeSeq& _types) const;
+    //! Index of the event type in the event type table.
+    /** The event type is added to the table, if not yet known. */
+    ACE_UINT32 eventTypeID(CosNotification::EventType const& _type);
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Domain name, type name pair.
+    typedef std::pair<std::string, std::string> EventTypeName;
+    //! Event type table of the event index.
+    typedef std::map<EventTypeName, ACE_UINT32> EventTypeMap;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Move the entries in memory to the temporary file.
+    void spill();
+    //! Read @ref _count spilled entries starting at @ref _first.
+    bool read(ACE_UINT32 _first, ACE_UINT32 _count,
+              LogHeader::IndexEntry * _dest) const;
+
+    //--------------------------------------------------------------------------
+    // hidden methods
+    //--------------------------------------------------------------------------
+    LogIndex(LogIndex const&);
+    LogIndex& operator= (LogIndex const&);
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Maximum number of entries kept in memory.
+    ACE_UINT32 const chunkSize_;
+    //! The index entries, that are not spilled.
+    IndexVector entries_;
+    //! Number of entries in the temporary file.
+    ACE_UINT32 spilled_;
+    //! Unlinked temporary file, holding the spilled entries.
+    ACE_HANDLE spillFile_;
+    //! Flag indicating that spilling failed, the entries stay in memory.
+    bool inMemory_;
+    //! The event types of the log file.
+    EventTypeMap eventTypes_;
+    //! The event type of the last event.
+    EventTypeMap::const_iterator lastEventType_;
+  };
+
+  inline
+  ACE_UINT32
+  LogIndex::size() const
+  {
+    return spilled_ + entries_.size();
+  }
+
+  inline
+  ACE_UINT32
+  LogIndex::spilled() const
+  {
+    return spilled_;
+  }
+}
+#endif // miro_LogIndex_h
@@ -0,0 +1,235 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogIndexFile.h"
+#include "LogIndex.h"
+#include "LogReader.h"
+#include "Log.h"
+
+#include <orbsvcs/Time_Utilities.h>
+#include <tao/CDR.h>
+
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_stdio.h>
+
+#include <sstream>
+#include <cstring>
+
+namespace Miro
+{
+  char const * const LogIndexFile::SUFFIX = ".idx";
+
+  LogIndexFile::LogIndexFile(std::string const& _logFile,
+                             ACE_UINT16 _byteOrder, ACE_UINT32 _numEvents) :
+      size_(0),
+      entries_(NULL)
+  {
+    std::string const name = fileName(_logFile);
+
+    if (ACE_OS::access(name.c_str(), R_OK) == 0 &&
+        memMap_.map(name.c_str(), static_cast<size_t>(-1), O_RDONLY,
+                    ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_PRIVATE) == 0 &&
+        !parse(_logFile, _byteOrder, _numEvents)) {
+      MIRO_LOG_OSTR(LL_NOTICE, "LogIndexFile - Ignoring stale sidecar index " << name);
+      entries_ = NULL;
+      size_ = 0;
+    }
+  }
+
+  LogIndexFile::~LogIndexFile()
+  {
+    memMap_.close();
+  }
+
+  bool
+  LogIndexFile::parse(std::string const& _logFile,
+                      ACE_UINT16 _byteOrder, ACE_UINT32 _numEvents) throw()
+  {
+    if (memMap_.size() < sizeof(Header))
+      return false;
+
+    Header const * header = static_cast<Header const *>(memMap_.addr());
+    if (header->id != PROTOCOL_ID ||
+        header->version != PROTOCOL_VERSION ||
+        header->byteOrder != _byteOrder)
+      return false;
+
+    ACE_stat st;
+    if (ACE_OS::stat(_logFile.c_str(), &st) == -1)
+      return false;
+
+    TAO_InputCDR istr(static_cast<char *>(memMap_.addr()) + sizeof(Header),
+                      memMap_.size() - sizeof(Header),
+                      (int)header->byteOrder);
+
+    ACE_UINT64 logSize;
+    ACE_UINT64 logMTime;
+    ACE_UINT32 numEvents;
+    if (!istr.read_ulonglong(logSize) ||
+        !istr.read_ulonglong(logMTime) ||
+        !istr.read_ulong(numEvents) ||
+        !istr.read_ulong(size_) ||
+        !(istr >> eventTypes_))
+      return false;
+
+    // validate against the log file
+    if (logSize != static_cast<ACE_UINT64>(st.st_size) ||
+        logMTime != static_cast<ACE_UINT64>(st.st_mtime) ||
+        numEvents != _numEvents ||
+        (_numEvents != 0 && size_ != _numEvents))
+      return false;
+
+    istr.align_read_ptr(ACE_CDR::LONGLONG_SIZE);
+    if (size_ * sizeof(LogHeader::IndexEntry) > istr.length())
+      return false;
+
+    entries_ = reinterpret_cast<LogHeader::IndexEntry const *>(istr.rd_ptr());
+    return true;
+  }
+
+  std::string
+  LogIndexFile::fileName(std::string const& _logFile)
+  {
+    return _logFile + SUFFIX;
+  }
+
+  void
+  LogIndexFile::write(std::string const& _logFile,
+                      ACE_UINT16 _byteOrder, ACE_UINT32 _numEvents,
+                      LogIndex const& _index) throw(Exception)
+  {
+    // the index entries are in host byte order
+    if (_byteOrder != ACE_CDR_BYTE_ORDER)
+      throw Exception("Sidecar index of " + _logFile +
+                      " not supported for foreign byte order.");
+
+    ACE_stat st;
+    if (ACE_OS::stat(_logFile.c_str(), &st) == -1)
+      throw CException(errno, "Stat of " + _logFile + ": " + strerror(errno));
+
+    CosNotification::EventTypeSeq types;
+    _index.eventTypes(types);
+
+    Header header;
+    header.id = PROTOCOL_ID;
+    header.version = PROTOCOL_VERSION;
+    header.byteOrder = ACE_CDR_BYTE_ORDER;
+
+    TAO_OutputCDR ostr;
+    ostr.write_octet_array(reinterpret_cast<ACE_CDR::Octet const *>(&header), sizeof(Header));
+    ostr.write_ulonglong(st.st_size);
+    ostr.write_ulonglong(st.st_mtime);
+    ostr.write_ulong(_numEvents);
+    ostr.write_ulong(_index.size());
+    ostr << types;
+    ostr.align_write_ptr(ACE_CDR::LONGLONG_SIZE);
+    if (!ostr.good_bit())
+      throw Exception("Error marshalling sidecar index of " + _logFile);
+    ostr.consolidate();
+
+    // the entries are streamed behind the header
+    std::string const name = fileName(_logFile);
+    writeAtomically(name, ostr.begin()->rd_ptr(), ostr.total_length(), &_index);
+
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "LogIndexFile - Wrote " << name << std::endl <<
+                  "LogIndexFile - Index events: " << _index.size());
+  }
+
+  void
+  LogIndexFile::writeAtomically(std::string const& _name,
+                                char const * _data, size_t _length,
+                                LogIndex const * _index) throw(Exception)
+  {
+    // write to a temporary file and move it into place
+    std::string const tmp = tempName(_name);
+
+    ACE_HANDLE handle = ACE_OS::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                                     ACE_DEFAULT_FILE_PERMS);
+    if (handle == ACE_INVALID_HANDLE)
+      throw CException(errno, "Opening " + tmp + ": " + strerror(errno));
+
+    // the rename must not overtake the data
+    bool const written =
+      ACE_OS::write(handle, _data, _length) == static_cast<ssize_t>(_length) &&
+      (_index == NULL || _index->write(handle)) &&
+      ACE_OS::fsync(handle) == 0;
+    int const error = errno;
+    ACE_OS::close(handle);
+
+    if (!written) {
+      ACE_OS::unlink(tmp.c_str());
+      throw CException(error, "Writing " + tmp + ": " + strerror(error));
+    }
+    replace(tmp, _name);
+  }
+
+  std::string
+  LogIndexFile::tempName(std::string const& _name)
+  {
+    std::ostringstream tmp;
+    tmp << _name << "." << ACE_OS::getpid();
+    return tmp.str();
+  }
+
+  void
+  LogIndexFile::replace(std::string const& _tempName,
+                        std::string const& _name) throw(Exception)
+  {
+    if (ACE_OS::rename(_tempName.c_str(), _name.c_str()) == -1) {
+      int const error = errno;
+      ACE_OS::unlink(_tempName.c_str());
+      throw CException(error, "Renaming " + _tempName + ": " + strerror(error));
+    }
+  }
+
+  bool
+  LogIndexFile::build(std::string const& _logFile) throw(Exception)
+  {
+    LogReader reader(_logFile);
+    if (reader.hasIndex())
+      return false;
+
+    LogIndex index;
+    ACE_Time_Value stamp;
+    TimeBase::TimeT t;
+    CosNotification::FixedEventHeader header;
+    ACE_UINT32 counter = 0;
+
+    reader.access(LogReader::SEQUENTIAL);
+    while ((reader.version() < 3 || counter++ < reader.events()) &&
+           reader.parseTimeStamp(stamp)) {
+      char const * const event = reader.rdPtr() - sizeof(TimeBase::TimeT);
+      reader.readAhead();
+      if (!reader.parseEventHeader(header))
+        break;
+
+      ORBSVCS_Time::Absolute_Time_Value_to_TimeT(t, stamp);
+      index.add(t, reader.fileOffset(event), header.event_type);
+
+      reader.skipEventBody();
+    }
+
+    write(_logFile, reader.byteOrder(), reader.events(), index);
+    return true;
+  }
+}
@@ -0,0 +1,183 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogIndexFile_h
+#define miro_LogIndexFile_h
+
+#include "LogHeader.h"
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+#include <ace/Mem_Map.h>
+
+#include <string>
+
+namespace Miro
+{
+  // forward declarations
+  class LogIndex;
+
+  //! Sidecar event index of a log file.
+  /**
+   * Log files prior to format version 5 carry no event index, so
+   * opening them requires a scan of all events. The sidecar index
+   * (<log file>.idx) caches the result of such a scan. It is only
+   * valid as long as size and modification time of the log file and
+   * the number of events noted in its header match the values
+   * recorded in the sidecar. Stale sidecars are simply ignored.
+   *
+   * The index entries are stored in the byte order of the log file,
+   * like the index footer of version 6 log files. Sidecars of prior
+   * versions are stale.
+   */
+  class miro_Export LogIndexFile
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! Header block of the sidecar index.
+    struct Header
+    {
+      ACE_UINT32 id;
+      ACE_UINT16 version;
+      ACE_UINT16 byteOrder;
+    };
+
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    static ACE_UINT32 const PROTOCOL_ID = 0x5844494d;      // "MIDX";
+    static ACE_UINT16 const PROTOCOL_VERSION = 0x0002;
+
+    //! File name suffix of the sidecar index.
+    static char const * const SUFFIX;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Open the sidecar index of a log file.
+    /**
+     * Check @ref valid() for success. Missing, corrupted or stale
+     * sidecars are not considered to be an error.
+     */
+    LogIndexFile(std::string const& _logFile,
+                 ACE_UINT16 _byteOrder, ACE_UINT32 _numEvents);
+    //! Cleaning up.
+    ~LogIndexFile();
+
+    //! Flag indicating a valid sidecar index.
+    bool valid() const throw();
+    //! Number of index entries.
+    ACE_UINT32 size() const throw();
+    //! The index entries, in the byte order of the log file.
+    LogHeader::IndexEntry const * entries() const throw();
+    //! The event types of the log file.
+    CosNotification::EventTypeSeq const& eventTypes() const throw();
+
+    //! Name of the sidecar index of a log file.
+    static std::string fileName(std::string const& _logFile);
+    //! Write the sidecar index of a log file.
+    /**
+     * The sidecar is written to a temporary file, which is renamed
+     * afterwards. So concurrent readers never see a partial index.
+     */
+    static void write(std::string const& _logFile,
+                      ACE_UINT16 _byteOrder, ACE_UINT32 _numEvents,
+                      LogIndex const& _index) throw(Exception);
+    //! Scan a log file and write its sidecar index.
+    /**
+     * Returns false, if the log file already has an up to date
+     * event index and no sidecar was written.
+     */
+    static bool build(std::string const& _logFile) throw(Exception);
+    //! Replace a file by the data, so readers never see a partial file.
+    /**
+     * The data, followed by the entries of @ref _index if given, is
+     * written and synced to a temporary file next to the file, which
+     * is renamed afterwards. Shared by the sidecar files of log files.
+     */
+    static void writeAtomically(std::string const& _name,
+                                char const * _data, size_t _length,
+                                LogIndex const * _index = NULL) throw(Exception);
+    //! Name of the temporary file, that is written in place of the file.
+    static std::string tempName(std::string const& _name);
+    //! Move the written and synced temporary file into place.
+    /** The temporary file is removed on failure. */
+    static void replace(std::string const& _tempName,
+                        std::string const& _name) throw(Exception);
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Parse and validate the mapped sidecar.
+    bool parse(std::string const& _logFile,
+               ACE_UINT16 _byteOrder, ACE_UINT32 _numEvents) throw();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Memory mapped sidecar.
+    ACE_Mem_Map memMap_;
+    //! Number of index entries.
+    ACE_UINT32 size_;
+    //! The index entries, within the mapped sidecar.
+    LogHeader::IndexEntry const * entries_;
+    //! The event types of the log file.
+    CosNotification::EventTypeSeq eventTypes_;
+  };
+
+  inline
+  bool
+  LogIndexFile::valid() const throw()
+  {
+    return entries_ != NULL;
+  }
+
+  inline
+  ACE_UINT32
+  LogIndexFile::size() const throw()
+  {
+    return size_;
+  }
+
+  inline
+  LogHeader::IndexEntry const *
+  LogIndexFile::entries() const throw()
+  {
+    return entries_;
+  }
+
+  inline
+  CosNotification::EventTypeSeq const&
+  LogIndexFile::eventTypes() const throw()
+  {
+    return eventTypes_;
+  }
+}
+#endif // miro_LogIndexFile_h
@@ -0,0 +1,181 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogLiveFile.h"
+#include "Log.h"
+
+#include <tao/CDR.h>
+
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_Thread.h>
+
+#include <cstring>
+
+namespace Miro
+{
+  char const * const LogLiveFile::SUFFIX = ".live";
+
+  LogLiveFile::LogLiveFile(std::string const& _logFile, size_t _tcrSize,
+                           LogHeader::WRITE) throw(CException) :
+      name_(fileName(_logFile)),
+      header_(NULL)
+  {
+    if (memMap_.map(name_.c_str(), sizeof(Header) + _tcrSize,
+                    O_RDWR | O_CREAT | O_TRUNC, ACE_DEFAULT_FILE_PERMS,
+                    PROT_RDWR, ACE_MAP_SHARED) == -1)
+      throw CException(errno, "Opening " + name_ + ": " + strerror(errno));
+
+    Header volatile * header = static_cast<Header *>(memMap_.addr());
+    header->version = PROTOCOL_VERSION;
+    header->byteOrder = ACE_CDR_BYTE_ORDER;
+    header->sequence = 0;
+    header->closed = 0;
+    header->events = 0;
+    header->types = 0;
+    header->length = 0;
+    header->tcrLength = 0;
+
+    // readers check the id first
+    releaseFence();
+    header->id = PROTOCOL_ID;
+    header_ = header;
+  }
+
+  LogLiveFile::LogLiveFile(std::string const& _logFile, LogHeader::READ) :
+      name_(fileName(_logFile)),
+      header_(NULL)
+  {
+    if (ACE_OS::access(name_.c_str(), R_OK) == 0 &&
+        memMap_.map(name_.c_str(), static_cast<size_t>(-1), O_RDONLY,
+                    ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_SHARED) == 0 &&
+        memMap_.size() >= sizeof(Header)) {
+
+      Header volatile * header = static_cast<Header *>(memMap_.addr());
+      if (header->id == PROTOCOL_ID) {
+        acquireFence();
+        if (header->version == PROTOCOL_VERSION &&
+            header->byteOrder == ACE_CDR_BYTE_ORDER) {
+          header_ = header;
+        }
+      }
+      if (header_ == NULL) {
+        MIRO_LOG_OSTR(LL_NOTICE, "LogLiveFile - Ignoring invalid live file " << name_);
+      }
+    }
+  }
+
+  LogLiveFile::~LogLiveFile()
+  {
+    memMap_.close();
+  }
+
+  void
+  LogLiveFile::beginUpdate() throw()
+  {
+    header_->sequence = header_->sequence + 1;
+    // the counter is odd, before any of the state changes
+    releaseFence();
+  }
+
+  void
+  LogLiveFile::endUpdate() throw()
+  {
+    // the state is complete, before the counter gets even
+    releaseFence();
+    header_->sequence = header_->sequence + 1;
+  }
+
+  void
+  LogLiveFile::publish(ACE_UINT32 _events, ACE_UINT64 _length) throw()
+  {
+    beginUpdate();
+    header_->events = _events;
+    header_->length = _length;
+    endUpdate();
+  }
+
+  bool
+  LogLiveFile::publishTypes(char const * _tcr, size_t _tcrLength, ACE_UINT32 _types) throw()
+  {
+    size_t const published = static_cast<size_t>(header_->tcrLength);
+    if (_tcrLength > tcrSize())
+      return false;
+
+    // the published part is not touched, so readers may copy it concurrently
+    char * const dest = static_cast<char *>(memMap_.addr()) + sizeof(Header);
+    memcpy(dest + published, _tcr + published, _tcrLength - published);
+
+    beginUpdate();
+    header_->types = _types;
+    header_->tcrLength = _tcrLength;
+    endUpdate();
+    return true;
+  }
+
+  void
+  LogLiveFile::close() throw()
+  {
+    if (header_ == NULL)
+      return;
+
+    beginUpdate();
+    header_->closed = 1;
+    endUpdate();
+    header_ = NULL;
+
+    // readers keep their mapping of the removed file
+    memMap_.close();
+    if (ACE_OS::unlink(name_.c_str()) == -1) {
+      MIRO_LOG_OSTR(LL_WARNING,
+                    "LogLiveFile - Error " << errno << " removing " << name_ << ": " <<
+                    strerror(errno));
+    }
+  }
+
+  LogLiveFile::State
+  LogLiveFile::state() const throw()
+  {
+    State s;
+    for (;;) {
+      ACE_UINT32 const sequence = header_->sequence;
+      acquireFence();
+
+      s.events = header_->events;
+      s.types = header_->types;
+      s.length = header_->length;
+      s.tcrLength = header_->tcrLength;
+      s.closed = (header_->closed != 0);
+
+      // retry, if the writer interfered
+      acquireFence();
+      if ((sequence & 1) == 0 && header_->sequence == sequence)
+        break;
+      ACE_OS::thr_yield();
+    }
+    return s;
+  }
+
+  std::string
+  LogLiveFile::fileName(std::string const& _logFile)
+  {
+    return _logFile + SUFFIX;
+  }
+}
@@ -0,0 +1,219 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogLiveFile_h
+#define miro_LogLiveFile_h
+
+#include "LogHeader.h"
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <ace/Mem_Map.h>
+
+#if defined(ACE_WIN32)
+#  include <windows.h>
+#endif
+
+#include <string>
+
+namespace Miro
+{
+  //! Published state of a log file, that is still being written.
+  /**
+   * The header of a log file only gets its type code repository and
+   * event index, when the @ref LogWriter closes it. With live tailing
+   * enabled, the writer publishes the number of complete events, the
+   * length of the event stream and the type codes seen so far in the
+   * live file (<log file>.live) instead. A @ref LogReader can so
+   * follow a log file, while it grows. The writer removes the live
+   * file, once the log file is finalized. A live file left behind by a
+   * crashed writer still makes the events of its log file readable.
+   *
+   * The state is guarded by a sequence counter, which is odd while the
+   * writer updates it. So a reader never sees an event count, that is
+   * ahead of the stream length or the type codes. The live file is in
+   * host byte order and meant for readers on the same machine.
+   */
+  class miro_Export LogLiveFile
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    //! Header block of the live file, followed by the type code repository.
+    struct Header
+    {
+      ACE_UINT32 id;
+      ACE_UINT16 version;
+      ACE_UINT16 byteOrder;
+      //! Sequence counter, odd while the state is updated.
+      ACE_UINT32 sequence;
+      //! Flag indicating a finalized log file.
+      ACE_UINT32 closed;
+      //! Number of complete events.
+      ACE_UINT32 events;
+      //! Number of type codes in the repository.
+      ACE_UINT32 types;
+      //! Length of the event stream behind the LogHeader.
+      ACE_UINT64 length;
+      //! Length of the type code repository.
+      ACE_UINT64 tcrLength;
+    };
+
+    //! Consistent snapshot of the published state.
+    struct State
+    {
+      ACE_UINT32 events;
+      ACE_UINT32 types;
+      ACE_UINT64 length;
+      ACE_UINT64 tcrLength;
+      bool closed;
+    };
+
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    static ACE_UINT32 const PROTOCOL_ID = 0x56494c4d;      // "MLIV";
+    static ACE_UINT16 const PROTOCOL_VERSION = 0x0001;
+
+    //! File name suffix of the live file.
+    static char const * const SUFFIX;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Create the live file of a log file (writer side).
+    /** Holds up to @ref _tcrSize bytes of type code repository. */
+    LogLiveFile(std::string const& _logFile, size_t _tcrSize, LogHeader::WRITE) throw(CException);
+    //! Open the live file of a log file (reader side).
+    /** Check @ref valid() for success. */
+    LogLiveFile(std::string const& _logFile, LogHeader::READ);
+    //! Cleaning up.
+    ~LogLiveFile();
+
+    //! Flag indicating a valid live file.
+    bool valid() const throw();
+
+    //! Publish the number of events and the length of the event stream.
+    void publish(ACE_UINT32 _events, ACE_UINT64 _length) throw();
+    //! Publish the type code repository.
+    /**
+     * @ref _tcr holds the complete repository of @ref _types type codes.
+     * As the repository only grows, just the new part is copied.
+     * Returns false, if it exceeds the size of the live file.
+     */
+    bool publishTypes(char const * _tcr, size_t _tcrLength, ACE_UINT32 _types) throw();
+    //! Mark the log file finalized and remove the live file.
+    void close() throw();
+
+    //! Read a consistent snapshot of the published state.
+    State state() const throw();
+    //! The type code repository, valid up to the published length.
+    char const * tcr() const throw();
+    //! Maximum length of the type code repository.
+    size_t tcrSize() const throw();
+
+    //! Name of the live file of a log file.
+    static std::string fileName(std::string const& _logFile);
+
+    //! Order all prior memory accesses before subsequent stores.
+    static void releaseFence() throw();
+    //! Order all prior loads before subsequent memory accesses.
+    static void acquireFence() throw();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Make the sequence counter odd.
+    void beginUpdate() throw();
+    //! Make the sequence counter even again.
+    void endUpdate() throw();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! Name of the live file.
+    std::string const name_;
+    //! Memory mapped live file.
+    ACE_Mem_Map memMap_;
+    //! Header block, within the mapped file.
+    /** NULL, if the live file is invalid. */
+    Header volatile * header_;
+  };
+
+  inline
+  bool
+  LogLiveFile::valid() const throw()
+  {
+    return header_ != NULL;
+  }
+
+  inline
+  char const *
+  LogLiveFile::tcr() const throw()
+  {
+    return static_cast<char const *>(memMap_.addr()) + sizeof(Header);
+  }
+
+  inline
+  size_t
+  LogLiveFile::tcrSize() const throw()
+  {
+    return memMap_.size() - sizeof(Header);
+  }
+
+  inline
+  void
+  LogLiveFile::releaseFence() throw()
+  {
+#if defined(__ATOMIC_RELEASE)
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#elif defined(__GNUC__)
+    __sync_synchronize();
+#elif defined(ACE_WIN32)
+    MemoryBarrier();
+#else
+#  error "No memory fence available for this compiler."
+#endif
+  }
+
+  inline
+  void
+  LogLiveFile::acquireFence() throw()
+  {
+#if defined(__ATOMIC_ACQUIRE)
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif defined(__GNUC__)
+    __sync_synchronize();
+#elif defined(ACE_WIN32)
+    MemoryBarrier();
+#else
+#  error "No memory fence available for this compiler."
+#endif
+  }
+}
+#endif // miro_LogLiveFile_h
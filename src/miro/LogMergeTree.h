@@ -0,0 +1,183 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogMergeTree_h
+#define miro_LogMergeTree_h
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+namespace Miro
+{
+  //! Loser tree for the k-way merge of sorted event streams.
+  /**
+   * Holds the current key of each of the k streams. The tree nodes
+   * store the loser of each match, so replacing the key of the
+   * winning stream replays just the matches on its path to the root,
+   * comparing the cached keys only: O(log k) per merged element.
+   *
+   * Ties are broken by the stream index, so the merge is stable.
+   * An exhausted stream is marked by a key, that compares larger
+   * than all real keys (e.g. ACE_Time_Value::max_time).
+   */
+  template<class T, class Compare = std::less<T> >
+  class LogMergeTree
+  {
+  public:
+    //! Build the tree over the initial keys of the streams.
+    LogMergeTree(std::vector<T> const& _keys,
+                 Compare const& _less = Compare());
+
+    //! Number of merged streams.
+    unsigned int size() const;
+    //! Index of the stream holding the smallest key.
+    unsigned int top() const;
+    //! The smallest key.
+    T const& topKey() const;
+    //! The current key of a stream.
+    T const& key(unsigned int _stream) const;
+
+    //! Replace the key of the winning stream by its next one.
+    void pop(T const& _next);
+    //! Replace all keys and rebuild the tree in O(k).
+    void reset(std::vector<T> const& _keys);
+
+  protected:
+    //! Strict ordering of two streams by key and index.
+    bool less(unsigned int _lhs, unsigned int _rhs) const;
+    //! Play all matches bottom up.
+    void build();
+
+    //! The current key of each stream.
+    std::vector<T> keys_;
+    //! The loser of each match, the overall winner in the first slot.
+    std::vector<unsigned int> tree_;
+    //! The key ordering.
+    Compare less_;
+  };
+
+  template<class T, class Compare>
+  inline
+  LogMergeTree<T, Compare>::LogMergeTree(std::vector<T> const& _keys,
+                                         Compare const& _less) :
+    keys_(_keys),
+    less_(_less)
+  {
+    build();
+  }
+
+  template<class T, class Compare>
+  inline
+  unsigned int
+  LogMergeTree<T, Compare>::size() const
+  {
+    return keys_.size();
+  }
+
+  template<class T, class Compare>
+  inline
+  unsigned int
+  LogMergeTree<T, Compare>::top() const
+  {
+    return tree_[0];
+  }
+
+  template<class T, class Compare>
+  inline
+  T const&
+  LogMergeTree<T, Compare>::topKey() const
+  {
+    return keys_[tree_[0]];
+  }
+
+  template<class T, class Compare>
+  inline
+  T const&
+  LogMergeTree<T, Compare>::key(unsigned int _stream) const
+  {
+    return keys_[_stream];
+  }
+
+  template<class T, class Compare>
+  inline
+  bool
+  LogMergeTree<T, Compare>::less(unsigned int _lhs, unsigned int _rhs) const
+  {
+    if (less_(keys_[_lhs], keys_[_rhs]))
+      return true;
+    if (less_(keys_[_rhs], keys_[_lhs]))
+      return false;
+    return _lhs < _rhs;
+  }
+
+  template<class T, class Compare>
+  void
+  LogMergeTree<T, Compare>::pop(T const& _next)
+  {
+    unsigned int const k = keys_.size();
+    unsigned int winner = tree_[0];
+    keys_[winner] = _next;
+
+    // leaves are at k..2k-1, replay the path to the root
+    for (unsigned int node = (winner + k) / 2; node > 0; node /= 2) {
+      if (less(tree_[node], winner))
+        std::swap(tree_[node], winner);
+    }
+    tree_[0] = winner;
+  }
+
+  template<class T, class Compare>
+  void
+  LogMergeTree<T, Compare>::reset(std::vector<T> const& _keys)
+  {
+    keys_ = _keys;
+    build();
+  }
+
+  template<class T, class Compare>
+  void
+  LogMergeTree<T, Compare>::build()
+  {
+    unsigned int const k = keys_.size();
+    tree_.assign((k > 0)? k : 1, 0);
+    if (k <= 1)
+      return;
+
+    std::vector<unsigned int> winner(2 * k);
+    for (unsigned int i = 0; i < k; ++i)
+      winner[k + i] = i;
+    for (unsigned int node = k - 1; node > 0; --node) {
+      unsigned int const l = winner[2 * node];
+      unsigned int const r = winner[2 * node + 1];
+      if (less(r, l)) {
+        winner[node] = r;
+        tree_[node] = l;
+      }
+      else {
+        winner[node] = l;
+        tree_[node] = r;
+      }
+    }
+    tree_[0] = winner[1];
+  }
+}
+
+#endif // miro_LogMergeTree_h
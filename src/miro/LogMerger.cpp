@@ -0,0 +1,167 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogMerger.h"
+#include "LogReader.h"
+#include "LogWriter.h"
+#include "LogExtractor.h"
+#include "LogMergeTree.h"
+#include "Log.h"
+
+#include <ace/OS_NS_unistd.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace Miro
+{
+  LogMerger::LogMerger(FileVector const& _files,
+                       unsigned int _fanIn,
+                       LogNotifyParameters const& _parameters) :
+    files_(_files),
+    fanIn_(std::max(_fanIn, 2u)),
+    parameters_(_parameters),
+    passes_(0)
+  {
+    parameters_.compress = false;
+    parameters_.maxFileSize = static_cast<unsigned long>(-1);
+  }
+
+  ACE_UINT32
+  LogMerger::merge(std::string const& _fileName) throw(Exception)
+  {
+    passes_ = 0;
+    return mergeFiles(files_, _fileName);
+  }
+
+  ACE_UINT32
+  LogMerger::mergeFiles(FileVector const& _files,
+                        std::string const& _fileName) throw(Exception)
+  {
+    if (_files.size() <= fanIn_)
+      return mergePass(_files, _fileName);
+
+    // merge groups of FanIn files into temporary log files first
+    FileVector parts;
+    ACE_UINT32 events;
+    try {
+      for (FileVector::size_type i = 0; i < _files.size(); i += fanIn_) {
+        std::stringstream name;
+        name << _fileName << ".part-" << passes_ << "-" << parts.size();
+        parts.push_back(name.str());
+
+        FileVector::const_iterator const first = _files.begin() + i;
+        FileVector const group(first, first + std::min<FileVector::size_type>(fanIn_, _files.size() - i));
+        mergePass(group, parts.back());
+      }
+      events = mergeFiles(parts, _fileName);
+    }
+    catch (...) {
+      for (FileVector::const_iterator part = parts.begin(); part != parts.end(); ++part)
+        ACE_OS::unlink(part->c_str());
+      throw;
+    }
+    for (FileVector::const_iterator part = parts.begin(); part != parts.end(); ++part)
+      ACE_OS::unlink(part->c_str());
+
+    return events;
+  }
+
+  ACE_UINT32
+  LogMerger::mergePass(FileVector const& _files,
+                       std::string const& _fileName) throw(Exception)
+  {
+    ++passes_;
+
+    LogWriter writer(_fileName, parameters_);
+    SourceVector sources;
+    ACE_UINT32 events = 0;
+
+    try {
+      // open the log files
+      std::vector<ACE_Time_Value> keys;
+      FileVector::const_iterator first, last = _files.end();
+      for (first = _files.begin(); first != last; ++first) {
+        Source source = { NULL, NULL, 0, ACE_Time_Value::max_time };
+        sources.push_back(source);
+        sources.back().reader = new LogReader(*first);
+        sources.back().reader->access(LogReader::SEQUENTIAL);
+        sources.back().extractor = new LogExtractor(*sources.back().reader, writer);
+        advance(sources.back());
+        keys.push_back(sources.back().stamp);
+      }
+
+      // k-way merge of the events
+      LogMergeTree<ACE_Time_Value> tree(keys);
+      while (tree.topKey() != ACE_Time_Value::max_time) {
+        Source& source = sources[tree.top()];
+
+        bool const copied = (source.reader->hasIndex())?
+          source.extractor->copyEvent(source.next) :
+          source.extractor->copyCurrent(source.stamp);
+        if (!copied)
+          throw Exception("LogMerger - Log file full: " + _fileName);
+        ++events;
+
+        ++source.next;
+        advance(source);
+        tree.pop(source.stamp);
+      }
+    }
+    catch (...) {
+      close(sources);
+      throw;
+    }
+    close(sources);
+
+    MIRO_LOG_OSTR(LL_NOTICE,
+                  "LogMerger - Merged " << events << " events of " <<
+                  _files.size() << " log files into " << _fileName);
+    return events;
+  }
+
+  void
+  LogMerger::advance(Source& _source) throw()
+  {
+    LogReader& reader = *_source.reader;
+    reader.readAhead();
+
+    if (reader.hasIndex()) {
+      _source.stamp = (_source.next < reader.indexSize())?
+        reader.indexTime(_source.next) : ACE_Time_Value::max_time;
+    }
+    // log files without index are read sequentially
+    else if ((reader.version() >= 3 && _source.next >= reader.events()) ||
+             !reader.parseTimeStamp(_source.stamp)) {
+      _source.stamp = ACE_Time_Value::max_time;
+    }
+  }
+
+  void
+  LogMerger::close(SourceVector& _sources) throw()
+  {
+    SourceVector::iterator first, last = _sources.end();
+    for (first = _sources.begin(); first != last; ++first) {
+      delete first->extractor;
+      delete first->reader;
+    }
+    _sources.clear();
+  }
+}
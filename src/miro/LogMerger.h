@@ -0,0 +1,137 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogMerger_h
+#define miro_LogMerger_h
+
+#include "Exception.h"
+#include "miro/Parameters.h"
+
+#include "miro_Export.h"
+
+#include <ace/Time_Value.h>
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  // forward declarations
+  class LogReader;
+  class LogExtractor;
+
+  //! Merges log files into one, ordered by time stamp.
+  /**
+   * The events of the log files are merged through a loser tree (@ref
+   * LogMergeTree) and copied as marshalled records by a @ref
+   * LogExtractor per file. The type code repositories of the files are
+   * unified in the one of the merged log, the type ids of the records
+   * are translated as necessary.
+   *
+   * The merge is streamed: Besides the mapped log files, the position
+   * of the next event per file and one chunk of the event index of the
+   * merged log are kept in memory. The @ref LogWriter spills the full
+   * chunks (IndexChunkSize events) to a temporary file. At most FanIn
+   * files are opened at once. Beyond that, the files are merged in
+   * multiple passes through temporary log files.
+   */
+  class miro_Export LogMerger
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    typedef std::vector<std::string> FileVector;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /**
+     * The merged log files are plain, as record copies are not
+     * supported for compressed ones, and have no size limit.
+     */
+    LogMerger(FileVector const& _files,
+              unsigned int _fanIn = 256,
+              LogNotifyParameters const& _parameters = *LogNotifyParameters::instance());
+
+    //! Merge the log files into @ref _fileName.
+    /** Returns the number of events of the merged log file. */
+    ACE_UINT32 merge(std::string const& _fileName) throw(Exception);
+
+    //! Number of merge passes of the last merge.
+    unsigned int passes() const throw();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! A log file to merge.
+    struct Source
+    {
+      LogReader * reader;
+      LogExtractor * extractor;
+      //! Position of the next event in the event index.
+      ACE_UINT32 next;
+      //! Time stamp of the next event, max_time once exhausted.
+      ACE_Time_Value stamp;
+    };
+    typedef std::vector<Source> SourceVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Merge the files, in multiple passes if there are more than FanIn.
+    ACE_UINT32 mergeFiles(FileVector const& _files,
+                          std::string const& _fileName) throw(Exception);
+    //! Merge at most FanIn files in one pass.
+    ACE_UINT32 mergePass(FileVector const& _files,
+                         std::string const& _fileName) throw(Exception);
+    //! Time stamp of the next event of the source.
+    static void advance(Source& _source) throw();
+    //! Close the log files of the sources.
+    static void close(SourceVector& _sources) throw();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The log files to merge.
+    FileVector const files_;
+    //! Maximum number of files merged at once.
+    unsigned int const fanIn_;
+    //! Parameters of the merged log files.
+    LogNotifyParameters parameters_;
+    //! Number of merge passes.
+    unsigned int passes_;
+  };
+
+  inline
+  unsigned int
+  LogMerger::passes() const throw()
+  {
+    return passes_;
+  }
+}
+#endif // miro_LogMerger_h
@@ -20,6 +20,7 @@
 //
 #include "LogNotifyConsumer.h"
 #include "LogWriter.h"
+#include "LogFlightRecorder.h"
 
 #include "Server.h"
 #include "Exception.h"
@@ -27,6 +28,7 @@
 #include "Log.h"
 
 #include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_unistd.h>
 #include <ace/Sample_History.h>
 #include <ace/Version.h>
 #if (ACE_MAJOR_VERSION > 5) || \
@@ -37,8 +39,6 @@
 #  include <ace/Stats.h>
 #endif
 
-#include <sstream>
-
 namespace Miro
 {
   using namespace std;
@@ -52,8 +52,21 @@ namespace Miro
       domainName_(_domainName),
       fileName_((_fileName.size() == 0) ? defaultFileName() : _fileName),
       mutex_(),
-      logWriter_(new LogWriter(fileName_ + "-00.mlog", _parameters)),
-      logNum_(0),
+      rotator_(fileName_, _parameters),
+      // the flight recorder writes log files on demand only
+      logWriter_((parameters_.flightRecorder)? NULL : rotator_.open()),
+      // compression runs in the writer thread, off the ORB threads
+      queue_((!parameters_.flightRecorder &&
+              (parameters_.asyncWrite || parameters_.compress))?
+             new LogEventQueue(parameters_.queueDepth, parameters_.dropOnOverflow) :
+             NULL),
+      recorder_((parameters_.flightRecorder)? new LogFlightRecorder(parameters_) : NULL),
+      dumpNum_(0),
+      dumpMutex_(),
+      dumpReady_(dumpMutex_),
+      dumpsClosed_(false),
+      writerTask_(*this),
+      writerRunning_(false),
       history_(NULL),
       nTimes_(0)
   {
@@ -85,6 +98,21 @@ namespace Miro
       }
     }
     setSubscriptions(added);
+
+    // do not overwrite the dumps of former runs
+    if (recorder_ != NULL) {
+      while (ACE_OS::access(LogFileRotator::segmentName(fileName_ + "-dump", dumpNum_).c_str(),
+                            F_OK) == 0)
+        ++dumpNum_;
+    }
+
+    // start the writer thread before events arrive
+    if (queue_ != NULL || recorder_ != NULL) {
+      if (writerTask_.activate() == -1)
+        throw CException(errno, "LogNotifyConsumer - Failed to spawn writer thread.");
+      writerRunning_ = true;
+    }
+
     connect();
   }
 
@@ -92,16 +120,31 @@ namespace Miro
   {
     MIRO_LOG_DTOR("LogNotifyConsumer");
 
+    stopWriterTask();
+
+    // dumps left by a failed writer thread
+    while (!dumps_.empty()) {
+      delete dumps_.front().snapshot;
+      dumps_.pop_front();
+    }
+
     delete logWriter_;
+    rotator_.close();
+    delete queue_;
+    delete recorder_;
     delete history_;
   }
 
   void
   LogNotifyConsumer::closeWriter()
   {
+    // flush pending events first
+    stopWriterTask();
+
     ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
     delete logWriter_;
     logWriter_ = 0;
+    rotator_.close();
   }
 
   void
@@ -110,32 +153,222 @@ namespace Miro
   {
     ACE_hrtime_t start = ACE_OS::gethrtime();
 
-    ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
+    if (recorder_ != NULL) {
+      ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
 
-    if (logWriter_ && connected()) {
-      if (!logWriter_->logEvent(ACE_OS::gettimeofday(), notification)) {
-        MIRO_LOG(LL_NOTICE,
-                 "Event log consumer max file size reached. - Starting new log file.");
-
-        delete logWriter_;
-        ++logNum_;
-        std::stringstream num;
-        num << "-";
-        num.width(2);
-        num.fill('0');
-        num << logNum_ << ".mlog";
-        logWriter_ = new LogWriter(fileName_ + num.str(), parameters_);
-        logWriter_->logEvent(ACE_OS::gettimeofday(), notification);
+      if (connected()) {
+        recordEvent(ACE_OS::gettimeofday(), notification);
+      }
+    }
+    else if (queue_ != NULL) {
+      // asynchronous mode: hand the event over to the writer thread
+      if (connected()) {
+        queue_->push(ACE_OS::gettimeofday(), notification);
+      }
+    }
+    else {
+      ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
+
+      if (logWriter_ && connected()) {
+        logEvent(ACE_OS::gettimeofday(), notification);
       }
     }
 
     // performance measurement
     if (nTimes_ > 0) {
       ACE_hrtime_t now = ACE_OS::gethrtime();
-      history_->sample(now - start);
 
-      --nTimes_;
+      ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
+      if (nTimes_ > 0) {
+        history_->sample(now - start);
+        --nTimes_;
+      }
+    }
+  }
+
+  void
+  LogNotifyConsumer::logEvent(ACE_Time_Value const& _stamp,
+                              CosNotification::StructuredEvent const& _event)
+  {
+    if (!logWriter_->logEvent(_stamp, _event)) {
+      MIRO_LOG(LL_NOTICE,
+               "Event log consumer max file size reached. - Starting new log file.");
+
+      LogWriter * full = logWriter_;
+      logWriter_ = NULL;
+      logWriter_ = rotator_.rotate(full);
+      logWriter_->logEvent(_stamp, _event);
+    }
+  }
+
+  void
+  LogNotifyConsumer::recordEvent(ACE_Time_Value const& _stamp,
+                                 CosNotification::StructuredEvent const& _event)
+  {
+    recorder_->logEvent(_stamp, _event);
+
+    if (isTrigger(_event.header.fixed_header.event_type)) {
+      dumpRecorder();
+    }
+  }
+
+  bool
+  LogNotifyConsumer::isTrigger(CosNotification::EventType const& _type) const
+  {
+    std::vector<EventParameters>::const_iterator first, last = parameters_.trigger.end();
+    for (first = parameters_.trigger.begin(); first != last; ++first) {
+      if ((first->domain == "*" || first->domain == _type.domain_name.in()) &&
+          (first->type == "*" || first->type == _type.type_name.in()))
+        return true;
+    }
+    return false;
+  }
+
+  std::string
+  LogNotifyConsumer::dumpRecorder()
+  {
+    ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
+
+    if (recorder_ == NULL)
+      return std::string();
+
+    // the file is written off the event delivery path
+    PendingDump dump;
+    dump.snapshot = recorder_->snapshot();
+    dump.fileName = LogFileRotator::segmentName(fileName_ + "-dump", dumpNum_++);
+
+    ACE_Guard<ACE_Thread_Mutex> dumpGuard(dumpMutex_);
+    dumps_.push_back(dump);
+    dumpReady_.signal();
+    return dump.fileName;
+  }
+
+  void
+  LogNotifyConsumer::logEvents(LogEventQueue::Buffer::const_iterator _first,
+                               LogEventQueue::Buffer::const_iterator _last)
+  {
+    bool fresh = false;
+    LogEventQueue::Buffer::const_iterator next;
+    while ((next = logWriter_->logEvents(_first, _last)) != _last) {
+      if (next == _first && fresh) {
+        // not even an empty log file holds the event
+        MIRO_LOG_OSTR(LL_ERROR,
+                      "LogNotifyConsumer - Event of type " <<
+                      next->event.header.fixed_header.event_type.type_name <<
+                      " does not fit into a log file. Event dropped.");
+        ++next;
+      }
+      _first = next;
+
+      MIRO_LOG(LL_NOTICE,
+               "Event log consumer max file size reached. - Starting new log file.");
+
+      LogWriter * full = logWriter_;
+      logWriter_ = NULL;
+      logWriter_ = rotator_.rotate(full);
+      fresh = true;
+    }
+  }
+
+  void
+  LogNotifyConsumer::writerLoop()
+  {
+    LogEventQueue::Buffer batch;
+    unsigned int size;
+
+    while ((size = queue_->pop(batch)) != 0) {
+      ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mutex_);
+
+      if (logWriter_) {
+        LogEventQueue::Buffer const& events = batch;
+        logEvents(events.begin(), events.begin() + size);
+      }
+      // release the payloads, the entries are recycled by the queue
+      for (unsigned int i = 0; i < size; ++i) {
+        batch[i].event.remainder_of_body = CORBA::Any();
+      }
+    }
+  }
+
+  void
+  LogNotifyConsumer::dumpLoop()
+  {
+    while (true) {
+      PendingDump dump;
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(dumpMutex_);
+        while (dumps_.empty() && !dumpsClosed_)
+          dumpReady_.wait();
+        // drained after shut down
+        if (dumps_.empty())
+          break;
+        dump = dumps_.front();
+        dumps_.pop_front();
+      }
+
+      try {
+        LogFlightRecorder::dump(*dump.snapshot, dump.fileName, parameters_);
+      }
+      catch (Exception const& e) {
+        MIRO_LOG_OSTR(LL_ERROR, "LogNotifyConsumer - Dumping the flight recorder failed: " << e);
+      }
+      delete dump.snapshot;
+    }
+  }
+
+  void
+  LogNotifyConsumer::stopWriterTask()
+  {
+    // called by closeWriter() and the destructor
+    if (writerRunning_) {
+      writerRunning_ = false;
+      if (queue_ != NULL) {
+        queue_->close();
+      }
+      else {
+        ACE_Guard<ACE_Thread_Mutex> guard(dumpMutex_);
+        dumpsClosed_ = true;
+        dumpReady_.signal();
+      }
+      writerTask_.wait();
+
+      if (queue_ != NULL) {
+        MIRO_LOG_OSTR(LL_NOTICE,
+                      "LogNotifyConsumer - queue high water mark: " << queue_->highWaterMark() <<
+                      " - dropped events: " << queue_->dropped());
+      }
+    }
+  }
+
+  LogNotifyConsumer::WriterTask::WriterTask(LogNotifyConsumer& _consumer) :
+      consumer_(_consumer)
+  {}
+
+  int
+  LogNotifyConsumer::WriterTask::svc()
+  {
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "[Miro::LogNotifyConsumer] writer starts in thread " << ACE_Thread::self());
+
+    try {
+      if (consumer_.recorder_ != NULL)
+        consumer_.dumpLoop();
+      else
+        consumer_.writerLoop();
+    }
+    catch (Miro::Exception const& e) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogNotifyConsumer writer - Uncaught Miro exception: " << e << std::endl
+                    << "Event logging stopped.");
+      // don't let the producers block on a dead writer
+      if (consumer_.queue_ != NULL)
+        consumer_.queue_->close();
+    }
+    catch (...) {
+      MIRO_LOG(LL_ERROR, "LogNotifyConsumer writer - Unknown exception. Event logging stopped.");
+      if (consumer_.queue_ != NULL)
+        consumer_.queue_->close();
     }
+    return 0;
   }
 
   void
@@ -22,12 +22,18 @@
 #define miro_LogNotifyConsumer_h
 
 #include "StructuredPushConsumer.h"
+#include "LogEventQueue.h"
+#include "LogFileRotator.h"
+#include "LogFlightRecorder.h"
 #include "miro/Parameters.h"
 
 #include <ace/High_Res_Timer.h>
+#include <ace/Task.h>
+#include <ace/Synch.h>
 
 #include "miro_Export.h"
 
+#include <deque>
 #include <string>
 
 // forward declarations
@@ -78,7 +84,61 @@ namespace Miro
     void evaluateTiming();
     void closeWriter();
 
+    //! Maximum number of events queued at once in asynchronous mode.
+    unsigned int queueHighWaterMark() const;
+    //! Number of events dropped due to queue overflow in asynchronous mode.
+    unsigned long droppedEvents() const;
+
+    //! Dump the flight recorder into the next dump file.
+    /**
+     * The recorded events are copied, the file is written by the
+     * writer thread. Returns the name of the file, empty if not in
+     * flight recorder mode. Not async signal safe, signal handlers
+     * have to defer the call.
+     */
+    std::string dumpRecorder();
+
   protected:
+    //! A dump of the flight recorder, waiting for the writer thread.
+    struct PendingDump
+    {
+      LogFlightRecorder::Snapshot * snapshot;
+      std::string fileName;
+    };
+
+    //! Writer thread of the asynchronous logging and the flight recorder mode.
+    class WriterTask : public ACE_Task_Base
+    {
+    public:
+      WriterTask(LogNotifyConsumer& _consumer);
+      virtual int svc();
+
+    protected:
+      LogNotifyConsumer& consumer_;
+    };
+    friend class WriterTask;
+
+    //! Write one event to the log, starting a new log file if necessary.
+    /** The caller has to hold the mutex. */
+    void logEvent(ACE_Time_Value const& _stamp,
+                  CosNotification::StructuredEvent const& _event);
+    //! Write a batch of events to the log, starting new log files as necessary.
+    /** The caller has to hold the mutex. */
+    void logEvents(LogEventQueue::Buffer::const_iterator _first,
+                   LogEventQueue::Buffer::const_iterator _last);
+    //! Record one event in flight recorder mode, dumping it on a trigger.
+    /** The caller has to hold the mutex. */
+    void recordEvent(ACE_Time_Value const& _stamp,
+                     CosNotification::StructuredEvent const& _event);
+    //! Flag indicating that the event type is configured as trigger.
+    bool isTrigger(CosNotification::EventType const& _type) const;
+    //! Drain the event queue into the log writer.
+    void writerLoop();
+    //! Write the pending dumps of the flight recorder.
+    void dumpLoop();
+    //! Stop the writer thread after the queue is drained.
+    void stopWriterTask();
+
     //! The default location for log files.
     /**
      * The default location is defined by the environment variable MIRO_LOG.
@@ -96,13 +156,48 @@ namespace Miro
 
     ACE_Recursive_Thread_Mutex mutex_;
 
+    //! Segment management of the log.
+    LogFileRotator rotator_;
     //! The log device.
     LogWriter * logWriter_;
-    int logNum_;
+
+    //! Event queue of the asynchronous logging mode (NULL otherwise).
+    LogEventQueue * queue_;
+    //! Ring buffer of the flight recorder mode (NULL otherwise).
+    LogFlightRecorder * recorder_;
+    //! Number of the next dump file.
+    /** Starts behind the dump files of former runs. */
+    int dumpNum_;
+    //! Lock protecting the pending dumps.
+    ACE_Thread_Mutex dumpMutex_;
+    //! Signaled on a pending dump or on shut down.
+    ACE_Condition_Thread_Mutex dumpReady_;
+    //! Dumps to be written by the writer thread.
+    std::deque<PendingDump> dumps_;
+    //! Flag indicating that no more dumps are requested.
+    bool dumpsClosed_;
+    //! Writer thread of the asynchronous logging and the flight recorder mode.
+    WriterTask writerTask_;
+    //! Flag indicating the writer thread is to be stopped.
+    bool writerRunning_;
 
     ACE_Sample_History * history_;
     int nTimes_;
     ACE_hrtime_t testStart_;
   };
+
+  inline
+  unsigned int
+  LogNotifyConsumer::queueHighWaterMark() const
+  {
+    return (queue_ != NULL)? queue_->highWaterMark() : 0;
+  }
+
+  inline
+  unsigned long
+  LogNotifyConsumer::droppedEvents() const
+  {
+    return (queue_ != NULL)? queue_->dropped() : 0;
+  }
 }
 #endif
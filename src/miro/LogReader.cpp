@@ -21,6 +21,10 @@
 #include "LogReader.h"
 #include "LogHeader.h"
 #include "LogTypeRepository.h"
+#include "LogIndexFile.h"
+#include "LogFieldIndexFile.h"
+#include "LogLiveFile.h"
+#include "LogBlockCodec.h"
 #include "Log.h"
 #include "Exception.h"
 #include "TimeHelper.h"
@@ -43,20 +47,54 @@
 #  include <tao/Environment.h>
 #endif
 
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_sys_mman.h>
+#include <ace/OS_NS_Thread.h>
+
+#include <algorithm>
 #include <cstdio>
 
 namespace Miro
 {
   using namespace std;
 
+  namespace
+  {
+    //! Polls of a live file, before waiting for the writer backs off to sleeping.
+    unsigned int const WAIT_SPINS = 64;
+    //! First and longest sleep between polls of a live file.
+    ACE_Time_Value const WAIT_MIN_SLEEP(0, 10);
+    ACE_Time_Value const WAIT_MAX_SLEEP(0, 1000);
+
+    //! Read the entry count of an index table.
+    /** 64 bit since version 6, a 32 bit count and a reserved field before. */
+    bool readCount(TAO_InputCDR& _istr, bool _wide, ACE_UINT64& _count)
+    {
+      if (_wide)
+        return _istr.read_ulonglong(_count);
+
+      ACE_UINT32 count;
+      ACE_UINT32 reserved;
+      if (!_istr.read_ulong(count) ||
+          !_istr.read_ulong(reserved))
+        return false;
+      _count = count;
+      return true;
+    }
+
+    //! Default size of the readahead window of SEQUENTIAL access.
+    size_t const READ_AHEAD_SIZE = 8 * 1024 * 1024;
+  }
+
   int const LogReader::READER = 0;
   int const LogReader::TRUNCATE = 1;
 
   LogReader::LogReader(string const& _fileName, int _mode) throw(Miro::Exception) :
       mode_(_mode),
       memMap_(_fileName.c_str(),  static_cast<size_t>(-1), (mode_ == TRUNCATE) ? O_RDWR : O_RDONLY,
-              ACE_DEFAULT_FILE_PERMS, PROT_RDWR,
-              (mode_ == TRUNCATE) ? ACE_MAP_SHARED : ACE_MAP_PRIVATE),
+              ACE_DEFAULT_FILE_PERMS, (mode_ == TRUNCATE) ? PROT_RDWR : PROT_READ,
+              ACE_MAP_SHARED),
       header_(NULL),
       istr_(NULL),
       typeRepository_(NULL),
@@ -66,7 +104,31 @@ namespace Miro
       tcrOffset_(sizeof(LogHeader)),
       eventsSlot_(NULL),
       events_(0),
-      eof_(false)
+      indexOffsetSlot_(NULL),
+      indexOffset_(0),
+      indexSize_(0),
+      index_(NULL),
+      indexV5_(NULL),
+      indexFile_(NULL),
+      fieldIndex_(NULL),
+      flags_(0),
+      blockIndex_(NULL),
+      blockIndexV5_(NULL),
+      numBlocks_(0),
+      block_(NULL),
+      blockNum_(static_cast<ACE_UINT32>(-1)),
+      swap_(false),
+      live_(NULL),
+      liveEnd_(NULL),
+      liveTypes_(0),
+      liveTcrLength_(0),
+      liveClosed_(false),
+      firstEvent_(0),
+      eof_(false),
+      access_(NORMAL),
+      readAheadSize_(READ_AHEAD_SIZE),
+      readAheadBegin_(0),
+      readAheadEnd_(0)
   {
     if (memMap_.addr() == MAP_FAILED)
       throw CException(errno, strerror(errno));
@@ -79,15 +141,13 @@ namespace Miro
 
     header_ = new(memMap_.addr()) LogHeader(r);
     version_ = header_->version;
+    swap_ = (header_->byteOrder != ACE_CDR_BYTE_ORDER);
 
     if (mode_ != READER && version_ < 3) {
       throw Miro::Exception("Log truncation not supported for log file format prior v 3");
     }
 
 
-    istr_ = new TAO_InputCDR((char*)memMap_.addr() + sizeof(LogHeader),
-                             memMap_.size() - sizeof(LogHeader),
-                             (int)header_->byteOrder);
     // version 2 log file
     if (version() == 2) {
       istr_ = new TAO_InputCDR((char*)memMap_.addr() + sizeof(LogHeader),
@@ -96,36 +156,87 @@ namespace Miro
       typeRepository_ = new LogTypeRepository(*istr_);
     }
     // version 3 log file
-    else if (version() == 3 || version() == 4) {
+    else if (version() >= 3) {
       istr_ = new TAO_InputCDR((char*)memMap_.addr() + sizeof(LogHeader),
                                memMap_.size() - sizeof(LogHeader),
                                (int)header_->byteOrder);
 
       tcrOffsetSlot_ = istr_->rd_ptr();
-      if (!istr_->read_ulong(tcrOffset_))
+      if (!readSlot(tcrOffset_))
         throw Exception("Could not read tcrOffset_.");
+      // the log file might still be written
+      if (tcrOffset_ == 0 && mode_ == READER && version() >= LogHeader::INDEX_VERSION) {
+        live_ = new LogLiveFile(_fileName, r);
+        if (!live_->valid()) {
+          delete live_;
+          live_ = NULL;
+        }
+      }
+      if (tcrOffset_ == 0 && live_ == NULL) {
+        throw Exception("Log file lacks type code repository and live file. "
+                        "Logging was not shut down properly.");
+      }
       if (tcrOffset_ > (memMap_.size() - sizeof(LogHeader) + 2 * 4)) {
         throw Exception("tcrOffset_ outside file boundaries. Logfile corrupted.");
       }
 
       eventsSlot_ = istr_->rd_ptr();
-      if (!istr_->read_ulong(events_))
+      ACE_UINT64 events;
+      if (!readSlot(events))
         throw Exception("Could not read events_.");
-      if (events_ == 0) {
+      if (events > ACE_UINT32_MAX)
+        throw Exception("Log file holds more than 2^32 events.");
+      events_ = static_cast<ACE_UINT32>(events);
+      if (events_ == 0 && live_ == NULL) {
         throw Exception("Log file contains zero events data.");
       }
 
+      // version 5 log file
+      if (version() >= LogHeader::INDEX_VERSION) {
+        indexOffsetSlot_ = istr_->rd_ptr();
+        if (!readSlot(indexOffset_) ||
+            !istr_->read_ulong(flags_))
+          throw Exception("Could not read indexOffset_.");
+
+        // reserved field, keeping the events 8 byte aligned
+        ACE_UINT32 reserved;
+        if (version() >= LogHeader::WIDE_VERSION &&
+            !istr_->read_ulong(reserved))
+          throw Exception("Could not read flags_.");
+      }
+      if (compressed()) {
+        if (mode_ != READER)
+          throw Exception("Log truncation not supported for compressed log files.");
+        if (indexOffset_ == 0)
+          throw Exception("Compressed log file lacks block index. Logfile corrupted.");
+      }
+
       MIRO_DBG_OSTR(MIRO, LL_DEBUG,
                     "LogReader - TCR Offset: 0x" <<
                     hex << tcrOffset_ << dec << endl <<
                     "LogReader - Number of events: " <<
                     events_ << dec);
 
-      TAO_InputCDR tcrIStream((char*)memMap_.addr() + tcrOffset_,
-                              memMap_.size() - tcrOffset_,
-                              (int)header_->byteOrder);
-      typeRepository_ = new LogTypeRepository(tcrIStream);
+      if (live_ != NULL) {
+        MIRO_DBG(MIRO, LL_DEBUG, "LogReader - Following live log file.");
+        remapLive();
+        update();
+      }
+      else {
+        TAO_InputCDR tcrIStream((char*)memMap_.addr() + tcrOffset_,
+                                memMap_.size() - tcrOffset_,
+                                (int)header_->byteOrder);
+        typeRepository_ = new LogTypeRepository(tcrIStream);
+      }
+
+      if (indexOffset_ != 0) {
+        parseIndex();
+      }
 
+      // start reading at the first block
+      if (compressed()) {
+        loadBlock(0);
+      }
 
       MIRO_DBG_OSTR(MIRO, LL_PRATTLE, "LogReader - Good bit : " << istr_->good_bit());
     }
@@ -134,11 +245,43 @@ namespace Miro
       s << "Unsupported log format version: "  << version();
       throw Exception(s.str());
     }
+
+    if (!compressed())
+      firstEvent_ = fileOffset(istr_->rd_ptr());
+
+    // look for a sidecar index
+    if (mode_ == READER && !hasIndex() && live_ == NULL) {
+      indexFile_ = new LogIndexFile(_fileName, header_->byteOrder, events_);
+      if (indexFile_->valid()) {
+        indexSize_ = indexFile_->size();
+        index_ = indexFile_->entries();
+        indexEventTypes_ = indexFile_->eventTypes();
+      }
+      else {
+        delete indexFile_;
+        indexFile_ = NULL;
+      }
+    }
+
+    // look for a field index
+    if (mode_ == READER && live_ == NULL) {
+      fieldIndex_ = new LogFieldIndexFile(_fileName, events_);
+      if (!fieldIndex_->valid()) {
+        delete fieldIndex_;
+        fieldIndex_ = NULL;
+      }
+    }
     MIRO_DBG_OSTR(MIRO, LL_DEBUG,  "version : " << version());
   }
 
   LogReader::~LogReader()
   {
+    delete indexFile_;
+    delete fieldIndex_;
+    delete live_;
+    if (block_ != NULL)
+      block_->release();
+
     if (mode_ == TRUNCATE) {
       string filename = memMap_.filename();
       size_t fileSize =  memMap_.size();
@@ -165,6 +308,11 @@ namespace Miro
 
       packTCR(dest);
 
+      // the event index got dropped
+      if (indexOffsetSlot_ != NULL) {
+        writeSlot(indexOffsetSlot_, 0);
+      }
+
       //--------------------------------------------------------------------------
       // log file size cleanup
       //--------------------------------------------------------------------------
@@ -190,6 +338,19 @@ namespace Miro
   bool
   LogReader::parseTimeStamp(ACE_Time_Value& _stamp) throw()
   {
+    // continue with the next block
+    if (compressed() && !eof_ && istr_->length() == 0 &&
+        !loadBlock(blockNum_ + 1)) {
+      eof_ = true;
+    }
+
+    // events not yet published by the writer of a live log file
+    if (live_ != NULL && !eof_ &&
+        ACE_ptr_align_binary(istr_->rd_ptr(), ACE_CDR::LONGLONG_SIZE) >= liveEnd_) {
+      eof_ = liveClosed_;
+      return false;
+    }
+
     if (eof_ ||
                 istr_->length() == 0 ||
                 istr_->rd_ptr() == 0)
@@ -469,11 +630,412 @@ namespace Miro
 
     if (events_ != count) {
       // TODO: honor byte swapping if necessary
-      *reinterpret_cast<ACE_UINT32 *>(eventsSlot_) = count;
+      // the mapping of a reader is read only
+      if (mode_ == TRUNCATE)
+        writeSlot(eventsSlot_, count);
       events_ = count;
     }
   }
 
+  bool
+  LogReader::readSlot(ACE_UINT64& _value) throw()
+  {
+    if (version() >= LogHeader::WIDE_VERSION)
+      return istr_->read_ulonglong(_value);
+
+    ACE_UINT32 value;
+    if (!istr_->read_ulong(value))
+      return false;
+    _value = value;
+    return true;
+  }
+
+  void
+  LogReader::writeSlot(char * _slot, ACE_UINT64 _value) throw(Miro::Exception)
+  {
+    TAO_OutputCDR o(_slot, 8);
+    if (!((version() >= LogHeader::WIDE_VERSION)?
+          o.write_ulonglong(_value) :
+          o.write_ulong(static_cast<ACE_UINT32>(_value))))
+      throw Miro::Exception("Failed to write log file header field.");
+  }
+
+  void
+  LogReader::parseIndex() throw(Miro::Exception)
+  {
+    if (indexOffset_ < tcrOffset_ ||
+        indexOffset_ >= memMap_.size()) {
+      throw Exception("indexOffset_ outside file boundaries. Logfile corrupted.");
+    }
+
+    TAO_InputCDR istr((char*)memMap_.addr() + indexOffset_,
+                      memMap_.size() - indexOffset_,
+                      (int)header_->byteOrder);
+
+    // event type table
+    if (!(istr >> indexEventTypes_))
+      throw Exception("Error reading event type table of the index. Logfile corrupted.");
+
+    // 64 bit offsets and counts since version 6
+    bool const wide = (version() >= LogHeader::WIDE_VERSION);
+    size_t const entrySize = (wide)?
+      sizeof(LogHeader::IndexEntry) : sizeof(LogHeader::IndexEntryV5);
+    size_t const blockEntrySize = (wide)?
+      sizeof(LogHeader::BlockEntry) : sizeof(LogHeader::BlockEntryV5);
+
+    // event index entries
+    istr.align_read_ptr(ACE_CDR::LONGLONG_SIZE);
+    ACE_UINT64 size;
+    if (!readCount(istr, wide, size) || size > ACE_UINT32_MAX)
+      throw Exception("Error reading event index. Logfile corrupted.");
+    indexSize_ = static_cast<ACE_UINT32>(size);
+
+    if (indexSize_ * entrySize > istr.length()) {
+      throw Exception("Event index outside file boundaries. Logfile corrupted.");
+    }
+    if (wide)
+      index_ = reinterpret_cast<LogHeader::IndexEntry const *>(istr.rd_ptr());
+    else
+      indexV5_ = reinterpret_cast<LogHeader::IndexEntryV5 const *>(istr.rd_ptr());
+
+    // block index of compressed log files
+    if (compressed()) {
+      istr.skip_bytes(indexSize_ * entrySize);
+      istr.align_read_ptr(ACE_CDR::LONGLONG_SIZE);
+      if (!readCount(istr, wide, size) || size > ACE_UINT32_MAX)
+        throw Exception("Error reading block index. Logfile corrupted.");
+      numBlocks_ = static_cast<ACE_UINT32>(size);
+
+      if (numBlocks_ * blockEntrySize > istr.length()) {
+        throw Exception("Block index outside file boundaries. Logfile corrupted.");
+      }
+      if (wide)
+        blockIndex_ = reinterpret_cast<LogHeader::BlockEntry const *>(istr.rd_ptr());
+      else
+        blockIndexV5_ = reinterpret_cast<LogHeader::BlockEntryV5 const *>(istr.rd_ptr());
+    }
+
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "LogReader - Index Offset: 0x" << hex << indexOffset_ << dec << endl <<
+                  "LogReader - Index events: " << indexSize_ << endl <<
+                  "LogReader - Index event types: " << indexEventTypes_.length());
+  }
+
+  void
+  LogReader::seekEvent(ACE_UINT32 _index) throw()
+  {
+    if (compressed()) {
+      if (!loadBlock(blockOf(_index))) {
+        eof_ = true;
+        return;
+      }
+      rdPtr(block_->rd_ptr() + entryOffset(_index) + sizeof(TimeBase::TimeT));
+    }
+    else {
+      rdPtr(indexEvent(_index) + sizeof(TimeBase::TimeT));
+    }
+  }
+
+  bool
+  LogReader::loadBlock(ACE_UINT32 _block) throw()
+  {
+    if (_block >= numBlocks_)
+      return false;
+    if (_block == blockNum_)
+      return true;
+
+    size_t const offset = blockOffset(_block);
+    if (offset + sizeof(LogHeader::BlockHeader) > memMap_.size()) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogReader - Block " << _block << " outside file boundaries.");
+      return false;
+    }
+
+    char const * const base = static_cast<char const *>(memMap_.addr());
+    LogHeader::BlockHeader const * header =
+      reinterpret_cast<LogHeader::BlockHeader const *>(base + offset);
+    size_t const length = indexValue(header->length);
+    size_t const rawLength = indexValue(header->rawLength);
+    if (offset + sizeof(LogHeader::BlockHeader) + length > memMap_.size()) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogReader - Block " << _block << " outside file boundaries.");
+      return false;
+    }
+
+    if (block_ == NULL || block_->size() < rawLength + ACE_CDR::MAX_ALIGNMENT) {
+      if (block_ != NULL)
+        block_->release();
+      block_ = new ACE_Message_Block(rawLength + ACE_CDR::MAX_ALIGNMENT);
+      ACE_CDR::mb_align(block_);
+    }
+
+    try {
+      LogBlockCodec::decompress(indexValue(header->codec),
+                                base + offset + sizeof(LogHeader::BlockHeader), length,
+                                block_->rd_ptr(), rawLength);
+    }
+    catch (Exception const& e) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogReader - Block " << _block << ": " << e);
+      blockNum_ = static_cast<ACE_UINT32>(-1);
+      return false;
+    }
+    blockNum_ = _block;
+
+    delete istr_;
+    istr_ = new TAO_InputCDR(block_->rd_ptr(), rawLength, (int)header_->byteOrder);
+    next_ = NULL;
+    eof_ = false;
+
+    return true;
+  }
+
+  ACE_UINT32
+  LogReader::blockOf(ACE_UINT32 _index) const throw()
+  {
+    // first block starting after the event
+    ACE_UINT32 first = 0;
+    ACE_UINT32 count = numBlocks_;
+
+    while (count > 0) {
+      ACE_UINT32 step = count / 2;
+      ACE_UINT32 middle = first + step;
+      if (blockFirstEvent(middle) <= _index) {
+        first = middle + 1;
+        count -= step + 1;
+      }
+      else {
+        count = step;
+      }
+    }
+    return (first > 0)? first - 1 : 0;
+  }
+
+  ACE_Time_Value
+  LogReader::indexTime(ACE_UINT32 _index) const throw()
+  {
+    TimeBase::TimeT const t = (indexV5_ != NULL)?
+      indexValue(indexV5_[_index].stamp) :
+      indexValue(index_[_index].stamp);
+
+    ACE_Time_Value stamp;
+    ORBSVCS_Time::Absolute_TimeT_to_Time_Value(stamp, t);
+    return stamp;
+  }
+
+  ACE_UINT32
+  LogReader::lowerBound(ACE_Time_Value const& _t) const throw()
+  {
+    ACE_UINT32 first = 0;
+    ACE_UINT32 count = indexSize_;
+
+    while (count > 0) {
+      ACE_UINT32 step = count / 2;
+      ACE_UINT32 middle = first + step;
+      if (indexTime(middle) < _t) {
+        first = middle + 1;
+        count -= step + 1;
+      }
+      else {
+        count = step;
+      }
+    }
+    return first;
+  }
+
+  bool
+  LogReader::hasFieldIndex(std::string const& _field) const throw()
+  {
+    return fieldIndex_ != NULL && fieldIndex_->hasField(_field);
+  }
+
+  ACE_UINT32
+  LogReader::findEvents(std::string const& _field, std::string const& _value,
+                        std::vector<ACE_UINT32>& _events) const
+  {
+    if (fieldIndex_ == NULL) {
+      _events.clear();
+      return 0;
+    }
+    return fieldIndex_->find(_field, _value, _events);
+  }
+
+  ACE_UINT32
+  LogReader::findEvents(std::string const& _field, double _min, double _max,
+                        std::vector<ACE_UINT32>& _events) const
+  {
+    if (fieldIndex_ == NULL) {
+      _events.clear();
+      return 0;
+    }
+    return fieldIndex_->find(_field, _min, _max, _events);
+  }
+
+  ACE_UINT32
+  LogReader::update() throw(Miro::Exception)
+  {
+    if (live_ == NULL)
+      return events_;
+
+    LogLiveFile::State const state = live_->state();
+
+    // type codes are published ahead of the events using them
+    if (typeRepository_ == NULL || state.types != liveTypes_) {
+      updateTypes(state.types, static_cast<size_t>(state.tcrLength));
+    }
+
+    // the writer grows the file ahead of the published events
+    size_t const end = sizeof(LogHeader) + static_cast<size_t>(state.length);
+    if (end > memMap_.size()) {
+      remapLive();
+      if (end > memMap_.size())
+        throw Exception("Live file exceeds log file boundaries. Logfile corrupted.");
+    }
+    liveEnd_ = static_cast<char const *>(memMap_.addr()) + end;
+    liveClosed_ = state.closed;
+    events_ = state.events;
+
+    return events_;
+  }
+
+  bool
+  LogReader::wait(ACE_Time_Value const& _timeout) throw(Miro::Exception)
+  {
+    ACE_UINT32 const events = events_;
+    ACE_Time_Value const deadline = ACE_OS::gettimeofday() + _timeout;
+    // the writer does not signal new events, so poll for them:
+    // a busy writer usually follows within microseconds
+    unsigned int spins = 0;
+    ACE_Time_Value interval = WAIT_MIN_SLEEP;
+
+    while (update() == events && live()) {
+      if (ACE_OS::gettimeofday() >= deadline)
+        return false;
+      if (spins < WAIT_SPINS) {
+        ++spins;
+        ACE_OS::thr_yield();
+        continue;
+      }
+      ACE_OS::sleep(interval);
+      interval = std::min(interval * 2., WAIT_MAX_SLEEP);
+    }
+    return events_ != events;
+  }
+
+  void
+  LogReader::remapLive() throw(Miro::Exception)
+  {
+    size_t const offset = fileOffset(istr_->rd_ptr());
+    size_t const nextOffset = (next_ != NULL)? fileOffset(next_) : 0;
+    bool const eof = eof_;
+
+    // a private mapping would not reliably follow the writer
+    memMap_.unmap();
+    if (memMap_.map(static_cast<size_t>(-1), PROT_READ, ACE_MAP_SHARED) == -1)
+      throw CException(errno, string("Remapping ") + memMap_.filename() + ": " + strerror(errno));
+
+    char * const base = static_cast<char *>(memMap_.addr());
+    header_ = reinterpret_cast<LogHeader *>(base);
+    size_t const slotSize = LogHeader::slotSize(version());
+    tcrOffsetSlot_ = base + sizeof(LogHeader);
+    eventsSlot_ = tcrOffsetSlot_ + slotSize;
+    indexOffsetSlot_ = eventsSlot_ + slotSize;
+
+    delete istr_;
+    istr_ = new TAO_InputCDR(base + sizeof(LogHeader),
+                             memMap_.size() - sizeof(LogHeader),
+                             (int)header_->byteOrder);
+    rdPtr(base + offset);
+    if (next_ != NULL)
+      next_ = base + nextOffset;
+    eof_ = eof;
+
+    // the advice applies to the mapping
+    Access const advised = access_;
+    access_ = NORMAL;
+    access(advised);
+  }
+
+  void
+  LogReader::access(Access _access) throw()
+  {
+    if (_access == access_)
+      return;
+
+    static int const advice[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM };
+    if (memMap_.advise(advice[_access]) == -1) {
+      MIRO_LOG_OSTR(LL_WARNING,
+                    "LogReader - Advising the access pattern of " << memMap_.filename() <<
+                    " failed: " << strerror(errno));
+    }
+    access_ = _access;
+    readAheadBegin_ = 0;
+    readAheadEnd_ = 0;
+  }
+
+  void
+  LogReader::readAhead(char const * _position) throw()
+  {
+    if (access_ != SEQUENTIAL || readAheadSize_ == 0)
+      return;
+
+    // positions within an uncompressed block are read ahead from the block
+    char const * const base = static_cast<char const *>(memMap_.addr());
+    size_t position;
+    if (base <= _position && _position < base + memMap_.size())
+      position = _position - base;
+    else if (compressed() && blockNum_ < numBlocks_)
+      position = blockOffset(blockNum_);
+    else
+      return;
+
+    // within the first half of the window, or the window reaches the end
+    if (readAheadBegin_ <= position && position < readAheadEnd_ &&
+        (readAheadEnd_ == memMap_.size() || position + readAheadSize_ / 2 < readAheadEnd_))
+      return;
+
+    size_t const page = ACE_OS::getpagesize();
+    size_t const begin = position - position % page;
+    size_t const end = std::min(position + readAheadSize_, memMap_.size());
+    ACE_OS::madvise(const_cast<char *>(base) + begin, end - begin, MADV_WILLNEED);
+    readAheadBegin_ = position;
+    readAheadEnd_ = end;
+  }
+
+  void
+  LogReader::updateTypes(ACE_UINT32 _types, size_t _tcrLength) throw(Miro::Exception)
+  {
+    if (_tcrLength > live_->tcrSize())
+      throw Exception("Type code repository outside live file boundaries. Live file corrupted.");
+
+    if (typeRepository_ == NULL) {
+      // private, aligned copy of the published part of the repository,
+      // its count of types is published separately
+      size_t const length = std::max(_tcrLength, sizeof(ACE_UINT32));
+      ACE_Message_Block tcr(length + ACE_CDR::MAX_ALIGNMENT);
+      ACE_CDR::mb_align(&tcr);
+      memcpy(tcr.rd_ptr(), live_->tcr(), _tcrLength);
+      *reinterpret_cast<ACE_UINT32 *>(tcr.rd_ptr()) = _types;
+
+      TAO_InputCDR tcrIStream(tcr.rd_ptr(), length, (int)header_->byteOrder);
+      typeRepository_ = new LogTypeRepository(tcrIStream);
+    }
+    else if (_types > liveTypes_) {
+      if (_tcrLength < liveTcrLength_)
+        throw Exception("Type code repository of the live file shrunk. Live file corrupted.");
+
+      // only the new type codes are read, the copy keeps their alignment
+      size_t const begin = liveTcrLength_ - liveTcrLength_ % ACE_CDR::MAX_ALIGNMENT;
+      size_t const length = _tcrLength - begin;
+      ACE_Message_Block tcr(length + ACE_CDR::MAX_ALIGNMENT);
+      ACE_CDR::mb_align(&tcr);
+      memcpy(tcr.rd_ptr(), live_->tcr() + begin, length);
+
+      TAO_InputCDR tcrIStream(tcr.rd_ptr(), length, (int)header_->byteOrder);
+      tcrIStream.skip_bytes(liveTcrLength_ - begin);
+      typeRepository_->read(tcrIStream, _types - liveTypes_);
+    }
+    liveTypes_ = _types;
+    liveTcrLength_ = _tcrLength;
+  }
+
   void
   LogReader::packTCR(char * dest) throw(Miro::Exception)
   {
@@ -485,9 +1047,7 @@ namespace Miro
       memmove(dest, source, size);
 
       // note new location of tcr
-      TAO_OutputCDR o(tcrOffsetSlot_, 4);
-      if (!o.write_ulong(offset))
-        throw Miro::Exception("Failed to write tcr offset count");
+      writeSlot(tcrOffsetSlot_, offset);
     }
     MIRO_DBG_OSTR(MIRO, LL_DEBUG,
                   "LogWriter - TCR Offset: 0x" << hex << offset << dec << endl <<
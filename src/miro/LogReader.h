@@ -32,9 +32,15 @@
 #include <ace/Mem_Map.h>
 
 #include <string>
+#include <vector>
 
 namespace Miro
 {
+  // forward declarations
+  class LogIndexFile;
+  class LogFieldIndexFile;
+  class LogLiveFile;
+  class LogCursor;
 
   class miro_Export LogReader
   {
@@ -42,6 +48,16 @@ namespace Miro
     static int const READER;
     static int const TRUNCATE;
 
+    //! Access pattern of the mapped log file, see @ref access().
+    enum Access {
+      //! Default readahead of the kernel.
+      NORMAL,
+      //! Playback and scans: aggressive readahead, pages dropped behind the reader.
+      SEQUENTIAL,
+      //! Seeking: no readahead, only the touched pages are read.
+      RANDOM
+    };
+
     //--------------------------------------------------------------------------
     // public methods
     //--------------------------------------------------------------------------
@@ -70,10 +86,151 @@ namespace Miro
     //! Flag indicating end of file.
     bool eof() const throw();
 
+    //! Report the byte order of the log file.
+    ACE_UINT16 byteOrder() const throw();
+    //! Offset of a position within the log file.
+    size_t fileOffset(char const * _ptr) const throw();
+    //! Position within the log file at an offset, see @ref fileOffset().
+    char const * filePointer(size_t _offset) const throw();
+    //! Type code of a type id of the log file.
+    /** CORBA::_tc_null if the type id is unknown. */
+    CORBA::TypeCode_ptr typeCode(ACE_INT32 _id) const throw();
+
+    //! Flag indicating that an event index is available.
+    /**
+     * Either the index footer of the log file (version >= 5) or a
+     * valid sidecar index (see @ref LogIndexFile).
+     */
+    bool hasIndex() const throw();
+    //! Number of events in the event index.
+    ACE_UINT32 indexSize() const throw();
+    //! Time stamp of the indexed event.
+    ACE_Time_Value indexTime(ACE_UINT32 _index) const throw();
+    //! Start of the indexed event record.
+    /**
+     * Suitable for @ref rdPtr(), followed by @ref parseTimeStamp().
+     * NULL for compressed log files, use @ref seekEvent() instead.
+     */
+    char const * indexEvent(ACE_UINT32 _index) const throw();
+    //! Position the reader behind the time stamp of the indexed event.
+    /**
+     * Suitable for all indexed log files. For compressed log files,
+     * the block holding the event is decompressed, if necessary.
+     */
+    void seekEvent(ACE_UINT32 _index) throw();
+    //! Position of the event type of the indexed event in @ref indexEventTypes().
+    ACE_UINT32 indexType(ACE_UINT32 _index) const throw();
+    //! The event types found in the log file.
+    CosNotification::EventTypeSeq const& indexEventTypes() const throw();
+    //! Index of the first event with a time stamp not before @ref _t.
+    /** Binary search on the event index. Returns indexSize() if there is none. */
+    ACE_UINT32 lowerBound(ACE_Time_Value const& _t) const throw();
+
+    //! Flag indicating a field index of the filterable data field.
+    /** See @ref LogFieldIndexFile. */
+    bool hasFieldIndex(std::string const& _field) const throw();
+    //! Events with the string value in the filterable data field.
+    /**
+     * Looks up the event numbers in the field index, suitable for @ref
+     * seekEvent() and @ref indexEvent(). Returns the number of events,
+     * 0 if the field is not indexed.
+     */
+    ACE_UINT32 findEvents(std::string const& _field, std::string const& _value,
+                          std::vector<ACE_UINT32>& _events) const;
+    //! Events with a numeric value within [_min, _max] in the filterable data field.
+    /**
+     * Numeric values are indexed by ranges, so events with values
+     * just outside the bounds may be included, see @ref
+     * LogFieldIndexFile::find().
+     */
+    ACE_UINT32 findEvents(std::string const& _field, double _min, double _max,
+                          std::vector<ACE_UINT32>& _events) const;
+
+    //! Flag indicating a log file of compressed event blocks.
+    bool compressed() const throw();
+    //! Number of event blocks of a compressed log file.
+    ACE_UINT32 blocks() const throw();
+
     unsigned int progress() const throw();
 
+    //! Flag indicating a log file, that is still being written.
+    /**
+     * A log file lacking its type code repository is read along with
+     * its live file (see @ref LogLiveFile). Only the events published
+     * by the writer are read. Once they are consumed, @ref
+     * parseTimeStamp() returns false without setting @ref eof(), until
+     * @ref update() catches up with the writer.
+     */
+    bool live() const throw();
+    //! Catch up with the writer of a live log file.
+    /**
+     * Makes the events and type codes published since the last call
+     * available and returns the number of events. The log file may get
+     * remapped, invalidating pointers into it like @ref rdPtr().
+     */
+    ACE_UINT32 update() throw(Miro::Exception);
+    //! Wait for new events of a live log file.
+    /**
+     * Polls the live file, spinning briefly before backing off to
+     * sleeps of up to a millisecond. Returns false, if there were no
+     * new events within @ref _timeout or the log file got finalized.
+     */
+    bool wait(ACE_Time_Value const& _timeout) throw(Miro::Exception);
+
+    //! Advise the kernel of the access pattern of the log file.
+    /**
+     * Applies to the whole mapping (madvise). The default is NORMAL.
+     * Scans and playback should use SEQUENTIAL, seeking around in the
+     * log file RANDOM, so it does not evict pages still in use.
+     */
+    void access(Access _access) throw();
+    //! The access pattern of the log file.
+    Access access() const throw();
+    //! Set the size of the readahead window of SEQUENTIAL access, 0 disables it.
+    void readAheadSize(size_t _size) throw();
+    //! Prefetch the log file ahead of the read position.
+    /**
+     * Asks the kernel to read the next @ref readAheadSize() bytes in
+     * the background (MADV_WILLNEED), without waiting for them. The
+     * window is renewed once half of it is consumed, so it is cheap to
+     * call once per event. Does nothing, unless the access is
+     * SEQUENTIAL.
+     */
+    void readAhead() throw();
+    //! Prefetch the log file ahead of a position within the log file.
+    /** For readers walking the records themselves, like @ref LogCursor. */
+    void readAhead(char const * _position) throw();
+
   protected:
+    friend class LogCursor;
+
     void packTCR(char * dest) throw(Miro::Exception);
+    //! Parse the event index of the log file (version >= 5).
+    void parseIndex() throw(Miro::Exception);
+    //! Index entry field in host byte order.
+    ACE_UINT32 indexValue(ACE_UINT32 const& _value) const throw();
+    //! Index entry field in host byte order.
+    ACE_UINT64 indexValue(ACE_UINT64 const& _value) const throw();
+    //! Offset of the indexed event.
+    ACE_UINT64 entryOffset(ACE_UINT32 _index) const throw();
+    //! File offset of the block header.
+    ACE_UINT64 blockOffset(ACE_UINT32 _block) const throw();
+    //! Number of the first event of the block.
+    ACE_UINT64 blockFirstEvent(ACE_UINT32 _block) const throw();
+    //! Read an offset or count field of the file header.
+    /** 32 bit prior to version 6. */
+    bool readSlot(ACE_UINT64& _value) throw();
+    //! Write an offset or count field of the file header.
+    void writeSlot(char * _slot, ACE_UINT64 _value) throw(Miro::Exception);
+    //! Decompress an event block and read from it.
+    /** Returns false, if there is no such block or it is corrupted. */
+    bool loadBlock(ACE_UINT32 _block) throw();
+    //! The event block holding the indexed event.
+    ACE_UINT32 blockOf(ACE_UINT32 _index) const throw();
+    //! Map the current size of a live log file, shared with the writer.
+    void remapLive() throw(Miro::Exception);
+    //! Read the type codes newly published in the live file.
+    void updateTypes(ACE_UINT32 _types, size_t _tcrLength) throw(Miro::Exception);
 
     //--------------------------------------------------------------------------
     // protected data
@@ -97,14 +254,65 @@ namespace Miro
     //! Slot to write the offset of the type code repository in the log file. */
     char * tcrOffsetSlot_;
     //! Offset of the type code repository in log file (version >= 3).
-    ACE_UINT32 tcrOffset_;
+    ACE_UINT64 tcrOffset_;
     //! Slot to write the offset of the type code repository in the log file. */
     char * eventsSlot_;
     //! Number of events in log (version >= 3).
     ACE_UINT32 events_;
+    //! Slot to write the offset of the event index in the log file.
+    char * indexOffsetSlot_;
+    //! Offset of the event index in log file (version >= 5, 0 if none).
+    ACE_UINT64 indexOffset_;
+    //! The event types of the event index.
+    CosNotification::EventTypeSeq indexEventTypes_;
+    //! Number of events in the event index.
+    ACE_UINT32 indexSize_;
+    //! The entries of the event index, within the mapped file or sidecar.
+    LogHeader::IndexEntry const * index_;
+    //! The entries of the event index of a version 5 log file.
+    LogHeader::IndexEntryV5 const * indexV5_;
+    //! Sidecar index of log files without index footer.
+    LogIndexFile * indexFile_;
+    //! Sidecar index of filterable data fields, NULL if none.
+    LogFieldIndexFile * fieldIndex_;
+    //! Flags of the log file (version >= 5).
+    ACE_UINT32 flags_;
+    //! The block index of a compressed log file, within the mapped file.
+    LogHeader::BlockEntry const * blockIndex_;
+    //! The block index of a compressed version 5 log file.
+    LogHeader::BlockEntryV5 const * blockIndexV5_;
+    //! Number of event blocks.
+    ACE_UINT32 numBlocks_;
+    //! The uncompressed event block.
+    ACE_Message_Block * block_;
+    //! Number of the event block held by @ref block_.
+    ACE_UINT32 blockNum_;
+    //! Flag indicating the byte order of the log file differs from the host.
+    bool swap_;
+    //! Live file of a log file, that is still being written.
+    LogLiveFile * live_;
+    //! End of the events published by the writer.
+    char const * liveEnd_;
+    //! Number of type codes published by the writer.
+    ACE_UINT32 liveTypes_;
+    //! Length of the published type code repository read so far.
+    size_t liveTcrLength_;
+    //! Flag indicating that the writer finalized the log file.
+    bool liveClosed_;
+
+    //! Offset of the first event in the log file (uncompressed log files).
+    size_t firstEvent_;
 
     //! Flag inidcating end of file.
     bool eof_;
+
+    //! Access pattern advised for the mapping.
+    Access access_;
+    //! Size of the readahead window.
+    size_t readAheadSize_;
+    //! File offsets of the current readahead window.
+    size_t readAheadBegin_;
+    size_t readAheadEnd_;
   };
 
   inline
@@ -123,17 +331,10 @@ namespace Miro
       eof_ = true;
     }
 
-
-    if (version() == 2) {
-      delete istr_;
-      istr_ = new TAO_InputCDR(_rdPtr,
-                               ((char *)memMap_.addr() + memMap_.size()) - _rdPtr,
-                               (int)header_->byteOrder);
-    }
-    else {
-      ACE_Message_Block const * mblock = istr_->start();
-      const_cast<ACE_Message_Block *>(mblock)->rd_ptr(const_cast<char *>(_rdPtr));
-    }
+    // the CDR stream aligns relative to the mapped file,
+    // so it is repositioned instead of recreated
+    ACE_Message_Block const * mblock = istr_->start();
+    const_cast<ACE_Message_Block *>(mblock)->rd_ptr(const_cast<char *>(_rdPtr));
   }
   inline
   bool
@@ -142,6 +343,118 @@ namespace Miro
     return eof_;
   }
   inline
+  ACE_UINT16
+  LogReader::byteOrder() const throw()
+  {
+    return header_->byteOrder;
+  }
+  inline
+  size_t
+  LogReader::fileOffset(char const * _ptr) const throw()
+  {
+    return _ptr - static_cast<char const *>(memMap_.addr());
+  }
+  inline
+  char const *
+  LogReader::filePointer(size_t _offset) const throw()
+  {
+    return static_cast<char const *>(memMap_.addr()) + _offset;
+  }
+  inline
+  CORBA::TypeCode_ptr
+  LogReader::typeCode(ACE_INT32 _id) const throw()
+  {
+    return typeRepository_->typeCode(_id);
+  }
+  inline
+  bool
+  LogReader::hasIndex() const throw()
+  {
+    return index_ != NULL || indexV5_ != NULL;
+  }
+  inline
+  ACE_UINT32
+  LogReader::indexSize() const throw()
+  {
+    return indexSize_;
+  }
+  inline
+  ACE_UINT32
+  LogReader::indexValue(ACE_UINT32 const& _value) const throw()
+  {
+    ACE_UINT32 v = _value;
+    if (swap_)
+      ACE_CDR::swap_4(reinterpret_cast<char const *>(&_value), reinterpret_cast<char *>(&v));
+    return v;
+  }
+  inline
+  ACE_UINT64
+  LogReader::indexValue(ACE_UINT64 const& _value) const throw()
+  {
+    ACE_UINT64 v = _value;
+    if (swap_)
+      ACE_CDR::swap_8(reinterpret_cast<char const *>(&_value), reinterpret_cast<char *>(&v));
+    return v;
+  }
+  inline
+  ACE_UINT64
+  LogReader::entryOffset(ACE_UINT32 _index) const throw()
+  {
+    return (indexV5_ != NULL)?
+      indexValue(indexV5_[_index].offset) :
+      indexValue(index_[_index].offset);
+  }
+  inline
+  ACE_UINT64
+  LogReader::blockOffset(ACE_UINT32 _block) const throw()
+  {
+    return (blockIndexV5_ != NULL)?
+      indexValue(blockIndexV5_[_block].offset) :
+      indexValue(blockIndex_[_block].offset);
+  }
+  inline
+  ACE_UINT64
+  LogReader::blockFirstEvent(ACE_UINT32 _block) const throw()
+  {
+    return (blockIndexV5_ != NULL)?
+      indexValue(blockIndexV5_[_block].firstEvent) :
+      indexValue(blockIndex_[_block].firstEvent);
+  }
+  inline
+  char const *
+  LogReader::indexEvent(ACE_UINT32 _index) const throw()
+  {
+    if (compressed())
+      return NULL;
+    return (char const *)memMap_.addr() + entryOffset(_index);
+  }
+  inline
+  bool
+  LogReader::compressed() const throw()
+  {
+    return (flags_ & LogHeader::FLAG_COMPRESSED) != 0;
+  }
+  inline
+  ACE_UINT32
+  LogReader::blocks() const throw()
+  {
+    return numBlocks_;
+  }
+  inline
+  ACE_UINT32
+  LogReader::indexType(ACE_UINT32 _index) const throw()
+  {
+    return (indexV5_ != NULL)?
+      indexValue(indexV5_[_index].type) :
+      indexValue(index_[_index].type);
+  }
+  inline
+  CosNotification::EventTypeSeq const&
+  LogReader::indexEventTypes() const throw()
+  {
+    return indexEventTypes_;
+  }
+  inline
   unsigned short
   LogReader::version() const throw()
   {
@@ -181,9 +494,35 @@ namespace Miro
     return true;
   }
   inline
+  bool
+  LogReader::live() const throw()
+  {
+    return live_ != NULL && !liveClosed_;
+  }
+  inline
+  LogReader::Access
+  LogReader::access() const throw()
+  {
+    return access_;
+  }
+  inline
+  void
+  LogReader::readAheadSize(size_t _size) throw()
+  {
+    readAheadSize_ = _size;
+  }
+  inline
+  void
+  LogReader::readAhead() throw()
+  {
+    readAhead(istr_->rd_ptr());
+  }
+  inline
   unsigned int
   LogReader::progress() const throw()
   {
+    if (compressed())
+      return (numBlocks_ == 0)? 100 : blockNum_ * 100 / numBlocks_;
     return (unsigned int)((double)((char *) istr_->rd_ptr() -
                                    (char *) memMap_.addr()) * 100. /
                           (double) memMap_.size());
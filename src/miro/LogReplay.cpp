@@ -0,0 +1,395 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogReplay.h"
+#include "LogReader.h"
+#include "LogMergeTree.h"
+#include "Client.h"
+#include "StructuredPushSupplier.h"
+#include "Log.h"
+
+#include <orbsvcs/CosNotifyChannelAdminC.h>
+
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+
+namespace
+{
+  struct LtDomain
+  {
+    template<class Pair>
+    bool operator() (Pair const& _lhs, char const * _rhs) const {
+      return ACE_OS::strcmp(_lhs.first.c_str(), _rhs) < 0;
+    }
+  };
+}
+
+namespace Miro
+{
+  ACE_Time_Value const LogReplay::LATE(0, 1000);
+
+  LogReplay::LogReplay(std::vector<std::string> const& _files,
+                       Client const * _client,
+                       std::string const& _channelName,
+                       double _speed,
+                       unsigned int _prefetch) throw(CORBA::Exception, Exception) :
+    events_(0),
+    speed_(_speed),
+    queue_(_prefetch, false),
+    prefetchTask_(*this, &LogReplay::prefetchLoop),
+    replayTask_(*this, &LogReplay::replayLoop),
+    stopCond_(mutex_),
+    stopped_(false),
+    sent_(0),
+    late_(0),
+    minLateness_(ACE_Time_Value::max_time),
+    maxLateness_(ACE_Time_Value::zero),
+    sumLateness_(0.),
+    sumSqLateness_(0.)
+  {
+    MIRO_LOG_CTOR("LogReplay");
+
+    typedef std::set<std::string> TypeSet;
+    typedef std::map<std::string, TypeSet> DomainMap;
+    DomainMap domains;
+
+    try {
+      std::vector<std::string>::const_iterator first, last = _files.end();
+      for (first = _files.begin(); first != last; ++first) {
+        LogReader * reader = new LogReader(*first);
+        readers_.push_back(reader);
+        events_ += reader->events();
+
+        CosNotification::EventTypeSeq types;
+        eventTypes(*reader, types);
+        for (unsigned int i = 0; i < types.length(); ++i) {
+          domains[types[i].domain_name.in()].insert(types[i].type_name.in());
+        }
+        // rewind after the scan
+        if (!reader->hasIndex()) {
+          delete reader;
+          readers_.back() = new LogReader(*first);
+        }
+        readers_.back()->access(LogReader::SEQUENTIAL);
+      }
+      counters_.resize(readers_.size(), 0);
+
+      // one supplier per domain, offering the logged event types
+      if (_client != NULL) {
+        DomainMap::const_iterator domain, end = domains.end();
+        for (domain = domains.begin(); domain != end; ++domain) {
+          CosNotifyChannelAdmin::EventChannel_var ec =
+            _client->resolveName<CosNotifyChannelAdmin::EventChannel>("/" + domain->first +
+                                                                      "/" + _channelName);
+          StructuredPushSupplier * supplier = new StructuredPushSupplier(ec.in());
+          suppliers_.push_back(std::make_pair(domain->first, supplier));
+
+          CosNotification::EventTypeSeq offers;
+          offers.length(domain->second.size());
+          TypeSet::const_iterator type = domain->second.begin();
+          for (unsigned int i = 0; i < offers.length(); ++i, ++type) {
+            offers[i].domain_name = CORBA::string_dup(domain->first.c_str());
+            offers[i].type_name = CORBA::string_dup(type->c_str());
+          }
+          supplier->setOffers(offers);
+          supplier->connect();
+        }
+      }
+    }
+    catch (...) {
+      SupplierVector::const_iterator supplier, end = suppliers_.end();
+      for (supplier = suppliers_.begin(); supplier != end; ++supplier) {
+        supplier->second->disconnect();
+        delete supplier->second;
+      }
+      ReaderVector::const_iterator reader, rend = readers_.end();
+      for (reader = readers_.begin(); reader != rend; ++reader)
+        delete *reader;
+      throw;
+    }
+  }
+
+  LogReplay::~LogReplay()
+  {
+    MIRO_LOG_DTOR("LogReplay");
+
+    stop();
+
+    SupplierVector::const_iterator supplier, end = suppliers_.end();
+    for (supplier = suppliers_.begin(); supplier != end; ++supplier) {
+      supplier->second->disconnect();
+      delete supplier->second;
+    }
+    ReaderVector::const_iterator reader, rend = readers_.end();
+    for (reader = readers_.begin(); reader != rend; ++reader)
+      delete *reader;
+  }
+
+  void
+  LogReplay::start() throw(Exception)
+  {
+    if (prefetchTask_.activate() == -1)
+      throw CException(errno, "LogReplay - Failed to spawn prefetch thread.");
+    if (replayTask_.activate() == -1) {
+      stop();
+      throw CException(errno, "LogReplay - Failed to spawn replay thread.");
+    }
+  }
+
+  void
+  LogReplay::stop()
+  {
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      stopped_ = true;
+      stopCond_.broadcast();
+    }
+    // wakes up both threads
+    queue_.close();
+    wait();
+  }
+
+  void
+  LogReplay::wait()
+  {
+    prefetchTask_.wait();
+    replayTask_.wait();
+  }
+
+  unsigned long
+  LogReplay::events() const
+  {
+    return events_;
+  }
+
+  unsigned long
+  LogReplay::sent() const
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    return sent_;
+  }
+
+  unsigned long
+  LogReplay::late() const
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    return late_;
+  }
+
+  TimeStats
+  LogReplay::lateness() const
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+
+    TimeStats stats;
+    if (sent_ == 0 || speed_ <= 0.)
+      return stats;
+
+    double const mean = sumLateness_ / sent_;
+    double const var = (sent_ > 1)?
+      std::max(0., (sumSqLateness_ - sumLateness_ * mean) / (sent_ - 1)) : 0.;
+
+    stats.min = minLateness_;
+    stats.max = maxLateness_;
+    stats.mean.set(mean / 1000000.);
+    stats.var.set(var / 1000000000000.);
+    return stats;
+  }
+
+  void
+  LogReplay::eventTypes(LogReader& _reader,
+                        CosNotification::EventTypeSeq& _types)
+  {
+    if (_reader.hasIndex()) {
+      _types = _reader.indexEventTypes();
+      return;
+    }
+
+    // scan the event headers
+    std::set<std::pair<std::string, std::string> > types;
+    ACE_Time_Value stamp;
+    CosNotification::FixedEventHeader header;
+    for (ACE_UINT32 i = 0;
+         (_reader.version() < 3 || i < _reader.events()) &&
+           _reader.parseTimeStamp(stamp) &&
+           _reader.parseEventHeader(header) &&
+           _reader.skipEventBody();
+         ++i) {
+      types.insert(std::make_pair(std::string(header.event_type.domain_name.in()),
+                                  std::string(header.event_type.type_name.in())));
+    }
+
+    _types.length(types.size());
+    std::set<std::pair<std::string, std::string> >::const_iterator type = types.begin();
+    for (unsigned int i = 0; i < _types.length(); ++i, ++type) {
+      _types[i].domain_name = CORBA::string_dup(type->first.c_str());
+      _types[i].type_name = CORBA::string_dup(type->second.c_str());
+    }
+  }
+
+  ACE_Time_Value
+  LogReplay::nextStamp(unsigned int _reader)
+  {
+    LogReader& reader = *readers_[_reader];
+    ACE_Time_Value stamp;
+    reader.readAhead();
+    if ((reader.version() < 3 || counters_[_reader] < reader.events()) &&
+        reader.parseTimeStamp(stamp)) {
+      ++counters_[_reader];
+      return stamp;
+    }
+    return ACE_Time_Value::max_time;
+  }
+
+  void
+  LogReplay::prefetchLoop()
+  {
+    std::vector<ACE_Time_Value> keys(readers_.size());
+    for (unsigned int i = 0; i < readers_.size(); ++i)
+      keys[i] = nextStamp(i);
+    LogMergeTree<ACE_Time_Value> tree(keys);
+
+    CosNotification::StructuredEvent event;
+    while (!readers_.empty() && tree.topKey() != ACE_Time_Value::max_time) {
+      unsigned int const file = tree.top();
+      LogReader& reader = *readers_[file];
+
+      if (!reader.parseEventHeader(event.header.fixed_header) ||
+          !reader.parseEventBody(event)) {
+        MIRO_LOG_OSTR(LL_WARNING, "LogReplay - Corrupt event in log file " << file);
+        tree.pop(ACE_Time_Value::max_time);
+        continue;
+      }
+      // blocks while the replay is prefetch events behind,
+      // fails once the replay is stopped
+      if (!queue_.push(tree.topKey(), event))
+        break;
+      tree.pop(nextStamp(file));
+    }
+    queue_.close();
+  }
+
+  void
+  LogReplay::replayLoop()
+  {
+    LogEventQueue::Buffer batch;
+    ACE_Time_Value start;
+    ACE_Time_Value first;
+    bool started = false;
+    unsigned int size;
+
+    while ((size = queue_.pop(batch)) != 0) {
+      for (unsigned int i = 0; i < size; ++i) {
+        LogEventQueue::Entry const& entry = batch[i];
+        if (!started) {
+          first = entry.stamp;
+          start = ACE_OS::gettimeofday();
+          started = true;
+        }
+
+        ACE_Time_Value lateness;
+        if (speed_ > 0.) {
+          ACE_Time_Value deadline = entry.stamp - first;
+          deadline *= 1. / speed_;
+          deadline += start;
+          if (!waitUntil(deadline))
+            return;
+          lateness = ACE_OS::gettimeofday() - deadline;
+        }
+        else {
+          ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+          if (stopped_)
+            return;
+        }
+
+        send(entry.event);
+
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        ++sent_;
+        if (lateness > LATE)
+          ++late_;
+        if (lateness < minLateness_)
+          minLateness_ = lateness;
+        if (lateness > maxLateness_)
+          maxLateness_ = lateness;
+        double const usec = static_cast<double>(lateness.sec()) * 1000000. + lateness.usec();
+        sumLateness_ += usec;
+        sumSqLateness_ += usec * usec;
+      }
+      // release the payloads
+      for (unsigned int i = 0; i < size; ++i) {
+        batch[i].event.remainder_of_body = CORBA::Any();
+      }
+    }
+  }
+
+  bool
+  LogReplay::waitUntil(ACE_Time_Value const& _deadline)
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    while (!stopped_ && ACE_OS::gettimeofday() < _deadline) {
+      stopCond_.wait(&_deadline);
+    }
+    return !stopped_;
+  }
+
+  void
+  LogReplay::send(CosNotification::StructuredEvent const& _event)
+  {
+    if (suppliers_.empty())
+      return;
+
+    char const * const domain = _event.header.fixed_header.event_type.domain_name.in();
+    SupplierVector::const_iterator supplier =
+      std::lower_bound(suppliers_.begin(), suppliers_.end(), domain, LtDomain());
+    if (supplier != suppliers_.end() &&
+        ACE_OS::strcmp(supplier->first.c_str(), domain) == 0)
+      supplier->second->sendEvent(_event);
+  }
+
+  LogReplay::ReplayTask::ReplayTask(LogReplay& _replay, void (LogReplay::*_loop)()) :
+    replay_(_replay),
+    loop_(_loop)
+  {}
+
+  int
+  LogReplay::ReplayTask::svc()
+  {
+    try {
+      (replay_.*loop_)();
+    }
+    catch (Miro::Exception const& e) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogReplay - Uncaught Miro exception: " << e << std::endl
+                    << "Replay stopped.");
+      replay_.queue_.close();
+    }
+    catch (CORBA::Exception const& e) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogReplay - Uncaught CORBA exception: " << e << std::endl
+                    << "Replay stopped.");
+      replay_.queue_.close();
+    }
+    return 0;
+  }
+}
@@ -0,0 +1,194 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogReplay_h
+#define miro_LogReplay_h
+
+#include "LogEventQueue.h"
+#include "TimeSeries.h"
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+
+#include <ace/Task.h>
+#include <ace/Synch.h>
+#include <ace/Time_Value.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace Miro
+{
+  // forward declarations
+  class Client;
+  class LogReader;
+  class StructuredPushSupplier;
+
+  //! Headless replay of log files into the event channels.
+  /**
+   * The events of all log files are merged by time stamp and pushed
+   * into the event channel of their domain, resolved as
+   * /<domain>/<channel name>, the way the LogPlayer does.
+   *
+   * A prefetch thread decodes the events ahead of their deadline into
+   * a bounded @ref LogEventQueue. The replay thread sends each event
+   * at an absolute deadline, the replay start plus the time stamp
+   * offset of the event divided by the speed. So scheduling errors
+   * do not accumulate over the replay. A speed of 0 replays the
+   * events as fast as possible.
+   *
+   * The lateness of each event against its deadline is recorded, to
+   * judge the fidelity of a replay.
+   */
+  class miro_Export LogReplay
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public constants
+    //--------------------------------------------------------------------------
+
+    //! Events sent later than this after their deadline are counted as late.
+    static ACE_Time_Value const LATE;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /**
+     * Opens the log files and connects a supplier for the event types
+     * of each domain.
+     *
+     * @param _client Resolves the event channels. If NULL, the events
+     * are decoded and scheduled, but not sent (dry run).
+     * @param _speed Replay speed factor, 0 for as fast as possible.
+     * @param _prefetch Maximum number of events decoded ahead.
+     */
+    LogReplay(std::vector<std::string> const& _files,
+              Client const * _client,
+              std::string const& _channelName = "EventChannel",
+              double _speed = 1.,
+              unsigned int _prefetch = 1024) throw(CORBA::Exception, Exception);
+    //! Stops the replay and disconnects the suppliers.
+    ~LogReplay();
+
+    //! Start the replay threads.
+    void start() throw(Exception);
+    //! Stop the replay before its end.
+    void stop();
+    //! Wait for the end of the replay.
+    void wait();
+
+    //! Number of events in the log files.
+    unsigned long events() const;
+    //! Number of events replayed.
+    unsigned long sent() const;
+    //! Number of events sent later than @ref LATE after their deadline.
+    unsigned long late() const;
+    //! Statistics of the lateness of the replayed events.
+    TimeStats lateness() const;
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Thread running one of the replay loops.
+    class ReplayTask : public ACE_Task_Base
+    {
+    public:
+      ReplayTask(LogReplay& _replay, void (LogReplay::*_loop)());
+      virtual int svc();
+
+    protected:
+      LogReplay& replay_;
+      void (LogReplay::*loop_)();
+    };
+    friend class ReplayTask;
+
+    typedef std::vector<LogReader *> ReaderVector;
+    typedef std::pair<std::string, StructuredPushSupplier *> SupplierPair;
+    typedef std::vector<SupplierPair> SupplierVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Decode the merged events into the queue.
+    void prefetchLoop();
+    //! Send the queued events at their deadlines.
+    void replayLoop();
+    //! Time stamp of the next event of a log file, max_time at its end.
+    ACE_Time_Value nextStamp(unsigned int _reader);
+    //! Collect the event types of a log file.
+    void eventTypes(LogReader& _reader,
+                    CosNotification::EventTypeSeq& _types);
+    //! Sleep until the deadline. Returns false, if the replay was stopped.
+    bool waitUntil(ACE_Time_Value const& _deadline);
+    //! Send an event to the channel of its domain.
+    void send(CosNotification::StructuredEvent const& _event);
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The log files.
+    ReaderVector readers_;
+    //! Number of events read from each log file.
+    std::vector<ACE_UINT32> counters_;
+    //! The suppliers, ordered by domain name.
+    SupplierVector suppliers_;
+    //! Total number of events.
+    unsigned long events_;
+    //! The replay speed factor.
+    double const speed_;
+
+    //! The decoded events, waiting for their deadline.
+    LogEventQueue queue_;
+    //! Decodes the events.
+    ReplayTask prefetchTask_;
+    //! Sends the events.
+    ReplayTask replayTask_;
+
+    //! Lock for the stop flag and the statistics.
+    mutable ACE_Thread_Mutex mutex_;
+    //! Signaled on stop.
+    ACE_Condition_Thread_Mutex stopCond_;
+    //! Flag indicating the replay was stopped.
+    bool stopped_;
+
+    //! Number of replayed events.
+    unsigned long sent_;
+    //! Number of late events.
+    unsigned long late_;
+    //! Smallest lateness.
+    ACE_Time_Value minLateness_;
+    //! Largest lateness.
+    ACE_Time_Value maxLateness_;
+    //! Sum of the lateness in usec.
+    double sumLateness_;
+    //! Sum of the squared lateness in usec^2.
+    double sumSqLateness_;
+  };
+}
+#endif // miro_LogReplay_h
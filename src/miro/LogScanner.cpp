@@ -0,0 +1,244 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "LogScanner.h"
+#include "LogReader.h"
+#include "Log.h"
+
+#include <ace/OS_NS_string.h>
+#include <ace/OS_NS_unistd.h>
+
+#include <algorithm>
+
+namespace Miro
+{
+  LogScanReducer::~LogScanReducer()
+  {}
+
+  LogScanner::LogScanner(FileVector const& _files,
+                         bool _bodies,
+                         ACE_UINT32 _rangeSize,
+                         LogReader::Access _access) throw(Exception) :
+    files_(_files),
+    bodies_(_bodies),
+    rangeSize_((_rangeSize != 0)? _rangeSize : 1),
+    access_(_access),
+    events_(0),
+    prototype_(NULL),
+    next_(0)
+  {
+    MIRO_LOG_CTOR("Miro::LogScanner");
+
+    for (unsigned int i = 0; i < files_.size(); ++i) {
+      LogReader reader(files_[i]);
+
+      if (!reader.hasIndex()) {
+        reader.access(access_);
+        partition(i, reader);
+        continue;
+      }
+
+      // cut the event index into ranges
+      ACE_UINT32 const size = reader.indexSize();
+      for (ACE_UINT32 first = 0; first < size; first += rangeSize_) {
+        Range const range = {
+          i, first, std::min(rangeSize_, size - first), 0, ACE_Time_Value::zero
+        };
+        ranges_.push_back(range);
+      }
+      events_ += size;
+    }
+  }
+
+  LogScanner::~LogScanner()
+  {
+    MIRO_LOG_DTOR("Miro::LogScanner");
+  }
+
+  void
+  LogScanner::partition(unsigned int _file, LogReader& _reader)
+  {
+    // follow the length prefixes of the event records
+    ACE_Time_Value stamp;
+    ACE_UINT32 n = 0;
+    while ((_reader.version() < 3 || n < _reader.events()) &&
+           _reader.parseTimeStamp(stamp)) {
+      if (n % rangeSize_ == 0) {
+        Range const range = {
+          _file, n, 0, _reader.fileOffset(_reader.rdPtr()), stamp
+        };
+        ranges_.push_back(range);
+      }
+      ++ranges_.back().size;
+      ++n;
+      _reader.readAhead();
+
+      if (!_reader.skipEvent())
+        break;
+    }
+    events_ += n;
+  }
+
+  void
+  LogScanner::scan(LogScanReducer& _reducer, int _threads) throw(Exception)
+  {
+    prototype_ = &_reducer;
+    reducers_.assign(ranges_.size(), NULL);
+    next_ = 0;
+    error_.clear();
+
+    if (_threads <= 0)
+      _threads = ACE_OS::num_processors_online();
+    if (_threads <= 0)
+      _threads = 1;
+    if (static_cast<size_t>(_threads) > ranges_.size())
+      _threads = ranges_.size();
+
+    if (_threads != 0) {
+      if (activate(THR_NEW_LWP | THR_JOINABLE, _threads) == -1)
+        throw CException(errno, "LogScanner - Failed to spawn worker threads.");
+      wait();
+    }
+
+    // reduce the results in the order of the ranges
+    ReducerVector::const_iterator first, last = reducers_.end();
+    for (first = reducers_.begin(); first != last; ++first) {
+      if (*first != NULL && error_.empty())
+        _reducer.reduce(**first);
+      delete *first;
+    }
+    reducers_.clear();
+    prototype_ = NULL;
+
+    if (!error_.empty())
+      throw Exception(error_);
+  }
+
+  int
+  LogScanner::svc()
+  {
+    // consecutive ranges mostly share the log file, so keep its reader
+    LogReader * reader = NULL;
+    unsigned int file = 0;
+
+    while (true) {
+      unsigned int index;
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        if (next_ == ranges_.size() || !error_.empty())
+          break;
+        index = next_++;
+      }
+      Range const& range = ranges_[index];
+      LogScanReducer * reducer = NULL;
+
+      try {
+        if (reader == NULL || file != range.file) {
+          delete reader;
+          reader = NULL;
+          reader = new LogReader(files_[range.file]);
+          reader->access(access_);
+          file = range.file;
+        }
+
+        reducer = prototype_->clone();
+        scanRange(range, *reader, *reducer);
+
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        reducers_[index] = reducer;
+      }
+      catch (Exception const& e) {
+        delete reducer;
+
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        if (error_.empty())
+          error_ = files_[range.file] + ": " + e.what();
+      }
+    }
+
+    delete reader;
+    return 0;
+  }
+
+  void
+  LogScanner::scanRange(Range const& _range, LogReader& _reader,
+                        LogScanReducer& _reducer) throw(Exception)
+  {
+    CosNotification::StructuredEvent event;
+    CosNotification::StructuredEvent const * const body = (bodies_)? &event : NULL;
+    ACE_UINT32 const last = _range.first + _range.size;
+
+    if (_reader.hasIndex()) {
+      CosNotification::EventTypeSeq const& types = _reader.indexEventTypes();
+
+      for (ACE_UINT32 i = _range.first; i < last; ++i) {
+        char const * record = _reader.indexEvent(i);
+        if (record == NULL || bodies_) {
+          // compressed log files are read through the event block
+          _reader.seekEvent(i);
+          if (_reader.eof())
+            throw Exception("LogScanner - Failed to seek indexed event.");
+          record = _reader.rdPtr() - sizeof(TimeBase::TimeT);
+          _reader.readAhead();
+
+          if (bodies_ &&
+              (!_reader.parseEventHeader(event.header.fixed_header) ||
+               !_reader.parseEventBody(event)))
+            throw Exception("LogScanner - Corrupted event.");
+        }
+
+        _reducer.event(_range.file, _reader.indexTime(i), recordLength(_reader, record),
+                       types[_reader.indexType(i)], body);
+      }
+      return;
+    }
+
+    // the first event is located by the partition
+    ACE_Time_Value stamp = _range.stamp;
+    _reader.rdPtr(_reader.filePointer(_range.offset));
+
+    for (ACE_UINT32 i = _range.first; i < last; ++i) {
+      if (i != _range.first && !_reader.parseTimeStamp(stamp))
+        throw Exception("LogScanner - Unexpected end of log file.");
+
+      char const * const record = _reader.rdPtr() - sizeof(TimeBase::TimeT);
+      _reader.readAhead();
+      if (!_reader.parseEventHeader(event.header.fixed_header) ||
+          !((bodies_)? _reader.parseEventBody(event) : _reader.skipEventBody()))
+        throw Exception("LogScanner - Corrupted event.");
+
+      _reducer.event(_range.file, stamp, recordLength(_reader, record),
+                     event.header.fixed_header.event_type, body);
+    }
+  }
+
+  size_t
+  LogScanner::recordLength(LogReader const& _reader, char const * _record) throw()
+  {
+    // the length is counted from the length slot behind the time stamp
+    char const * const slot = _record + sizeof(TimeBase::TimeT);
+    ACE_UINT32 length;
+    if (_reader.byteOrder() != ACE_CDR_BYTE_ORDER)
+      ACE_CDR::swap_4(slot, reinterpret_cast<char *>(&length));
+    else
+      ACE_OS::memcpy(&length, slot, sizeof(length));
+    return sizeof(TimeBase::TimeT) + length;
+  }
+}
@@ -0,0 +1,198 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogScanner_h
+#define miro_LogScanner_h
+
+#include "LogReader.h"
+#include "Exception.h"
+
+#include "miro_Export.h"
+
+#include <orbsvcs/CosNotificationC.h>
+#include <ace/Task.h>
+#include <ace/Synch.h>
+#include <ace/Time_Value.h>
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  //! Reducer of a scan over log files.
+  /**
+   * Each range of events of a scan is visited by a fresh copy of the
+   * reducer (see @ref clone()) on one of the worker threads. Once all
+   * ranges are scanned, the copies are reduced into the reducer
+   * passed to @ref LogScanner::scan() in the order of the ranges. So
+   * order dependent results, like the gaps between events, can be
+   * carried across range boundaries.
+   */
+  class miro_Export LogScanReducer
+  {
+  public:
+    //! Virtual destructor.
+    virtual ~LogScanReducer();
+
+    //! A fresh reducer for a range of events.
+    virtual LogScanReducer * clone() const = 0;
+    //! Visit an event.
+    /**
+     * @ref _length is the length of the event record in the log file,
+     * @ref _file the position of the log file in the scan.
+     * @ref _event is NULL, unless the scan demarshals the events.
+     */
+    virtual void event(unsigned int _file,
+                       ACE_Time_Value const& _stamp, size_t _length,
+                       CosNotification::EventType const& _type,
+                       CosNotification::StructuredEvent const * _event) = 0;
+    //! Reduce the results of the reducer of the following range.
+    virtual void reduce(LogScanReducer const& _next) = 0;
+  };
+
+  //! Scans log files in parallel.
+  /**
+   * The log files are partitioned into ranges of events, that are
+   * handed out to a pool of worker threads. The ranges are cut on the
+   * event index. Log files without index are partitioned on the length
+   * prefixes of their event records up front, without decoding them.
+   *
+   * By default, only the time stamp, record length and event type of
+   * the events are visited. For indexed log files, those are taken
+   * from the event index, so the records are not parsed at all.
+   */
+  class miro_Export LogScanner : public ACE_Task_Base
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    typedef std::vector<std::string> FileVector;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor, partitions the log files.
+    /**
+     * @ref _bodies demarshals the events for the reducer.
+     * @ref _rangeSize is the number of events per range.
+     * @ref _access is the access pattern advised for the log files.
+     */
+    LogScanner(FileVector const& _files,
+               bool _bodies = false,
+               ACE_UINT32 _rangeSize = 65536,
+               LogReader::Access _access = LogReader::SEQUENTIAL) throw(Exception);
+    //! Cleaning up.
+    virtual ~LogScanner();
+
+    //! Scan the log files with @ref _threads workers, 0 for one per cpu.
+    /** The results are reduced into @ref _reducer. */
+    void scan(LogScanReducer& _reducer, int _threads = 0) throw(Exception);
+
+    //! Number of events of the log files.
+    ACE_UINT64 events() const throw();
+    //! Number of ranges the log files are partitioned into.
+    unsigned int ranges() const throw();
+
+    //! Inherited method: the worker loop.
+    virtual int svc();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! A range of events of a log file.
+    struct Range
+    {
+      //! Position of the log file in the scan.
+      unsigned int file;
+      //! Number of the first event.
+      ACE_UINT32 first;
+      //! Number of events.
+      ACE_UINT32 size;
+      //! File offset behind the time stamp of the first event.
+      /** Log files without index only. */
+      size_t offset;
+      //! Time stamp of the first event.
+      /** Log files without index only. */
+      ACE_Time_Value stamp;
+    };
+    typedef std::vector<Range> RangeVector;
+    typedef std::vector<LogScanReducer *> ReducerVector;
+
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Partition a log file without event index.
+    void partition(unsigned int _file, LogReader& _reader);
+    //! Visit the events of a range.
+    void scanRange(Range const& _range, LogReader& _reader,
+                   LogScanReducer& _reducer) throw(Exception);
+    //! Length of the event record.
+    static size_t recordLength(LogReader const& _reader, char const * _record) throw();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The log files.
+    FileVector const files_;
+    //! Flag indicating to demarshal the events.
+    bool const bodies_;
+    //! Number of events per range.
+    ACE_UINT32 const rangeSize_;
+    //! Access pattern of the readers.
+    LogReader::Access const access_;
+    //! The ranges of events.
+    RangeVector ranges_;
+    //! Number of events of the log files.
+    ACE_UINT64 events_;
+
+    //! Lock for the scan state.
+    ACE_Thread_Mutex mutex_;
+    //! The reducer cloned for the ranges.
+    LogScanReducer const * prototype_;
+    //! The reducers of the ranges.
+    ReducerVector reducers_;
+    //! Next range to scan.
+    unsigned int next_;
+    //! Error message of the first failed range.
+    std::string error_;
+  };
+
+  inline
+  ACE_UINT64
+  LogScanner::events() const throw()
+  {
+    return events_;
+  }
+
+  inline
+  unsigned int
+  LogScanner::ranges() const throw()
+  {
+    return ranges_.size();
+  }
+}
+#endif // miro_LogScanner_h
@@ -0,0 +1,50 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogServiceImpl_h
+#define miro_LogServiceImpl_h
+
+#include "LogServiceS.h"
+
+#include "miro_Export.h"
+
+namespace Miro
+{
+  // forward declarations
+  class LogNotifyConsumer;
+
+  //! Servant of the remote control of the logging service.
+  class miro_Export LogServiceImpl : public virtual POA_Miro::LogService
+  {
+  public:
+    //! Initializing constructor.
+    LogServiceImpl(LogNotifyConsumer& _consumer);
+    //! Cleaning up.
+    virtual ~LogServiceImpl();
+
+    //! Inherited IDL interface: Dump the flight recorder.
+    virtual char * dumpRecorder() throw();
+
+  protected:
+    //! The consumer, running the flight recorder.
+    LogNotifyConsumer& consumer_;
+  };
+}
+#endif // miro_LogServiceImpl_h
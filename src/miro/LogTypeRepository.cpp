@@ -24,6 +24,8 @@
 
 #include <tao/CDR.h>
 
+#include <ace/ACE.h>
+
 #include <algorithm>
 #include <sstream>
 #include <stdexcept>
@@ -38,6 +40,10 @@ namespace Miro
       full_(false)
   {
     types_.reserve(64);
+    for (unsigned int i = 0; i < CACHE_SIZE; ++i) {
+      cache_[i].tc = CORBA::TypeCode::_nil();
+      cache_[i].id = -1;
+    }
 
     pNumTypes_ = ostr_->current()->wr_ptr();
     ostr_->write_ulong(0x00000000);
@@ -49,6 +55,11 @@ namespace Miro
       totalLength_(),
       full_(true)
   {
+    for (unsigned int i = 0; i < CACHE_SIZE; ++i) {
+      cache_[i].tc = CORBA::TypeCode::_nil();
+      cache_[i].id = -1;
+    }
+
     //--------------------------------------------------------------------------
     // parse log repository
     //--------------------------------------------------------------------------
@@ -66,8 +77,19 @@ namespace Miro
 
     MIRO_DBG_OSTR(MIRO, LL_DEBUG, "LogTypeRepository - number of types: " << numTypes);
 
+    read(_istr, numTypes);
+
+    ACE_Message_Block const * block = _istr.start();
+    totalLength_ = (block->rd_ptr() - block->base());
+
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG, "LogTypeRepository - total length: " << totalLength_);
+  }
+
+  void
+  LogTypeRepository::read(TAO_InputCDR& _istr, ACE_UINT32 _numTypes) throw(Exception)
+  {
     // read each type from cdr stream
-    for (ACE_UINT32 i = 0; i < numTypes; ++i) {
+    for (ACE_UINT32 i = 0; i < _numTypes; ++i) {
 
       // read type code from the mmapped file
       CORBA::TypeCode_ptr type;
@@ -80,11 +102,6 @@ namespace Miro
       // add type to our repository
       types_.push_back(CORBA::TypeCode::_duplicate(type));
     }
-
-    ACE_Message_Block const * block = _istr.start();
-    totalLength_ = (block->rd_ptr() - block->base());
-
-    MIRO_DBG_OSTR(MIRO, LL_DEBUG, "LogTypeRepository - total length: " << totalLength_);
   }
 
   LogTypeRepository::~LogTypeRepository() throw()
@@ -94,10 +111,75 @@ namespace Miro
     for (first = types_.begin(); first != last; ++first) {
       CORBA::release(*first);
     }
+    for (unsigned int i = 0; i < CACHE_SIZE; ++i) {
+      CORBA::release(cache_[i].tc);
+    }
+  }
+
+  CORBA::Long
+  LogTypeRepository::lookupType(CORBA::TypeCode_ptr _type)
+  {
+    CORBA::Long id = -1;
+    ACE_UINT32 const hash = typeHash(_type);
+
+    // search the hash bucket for type code
+    std::pair<TypeIndex::const_iterator, TypeIndex::const_iterator> bucket =
+      index_.equal_range(hash);
+    for (; bucket.first != bucket.second; ++bucket.first) {
+      if (_type->equal(types_[bucket.first->second])) {
+        id = bucket.first->second;
+        break;
+      }
+    }
+
+    // add type code to the repository, if unknown
+    if (id == -1) {
+      id = addType(_type, hash);
+      if (id < 0)
+        return id;
+    }
+
+    // remember the instance
+    CacheEntry& entry = cache_[cacheSlot(_type)];
+    CORBA::release(entry.tc);
+    entry.tc = CORBA::TypeCode::_duplicate(_type);
+    entry.id = id;
+
+    return id;
+  }
+
+  ACE_UINT32
+  LogTypeRepository::typeHash(CORBA::TypeCode_ptr _type)
+  {
+    CORBA::TCKind const kind = _type->kind();
+    ACE_UINT32 hash = static_cast<ACE_UINT32>(kind);
+
+    // TypeCode::equal() compares the repository ids of all kinds having one
+    switch (kind) {
+      case CORBA::tk_objref:
+      case CORBA::tk_struct:
+      case CORBA::tk_union:
+      case CORBA::tk_enum:
+      case CORBA::tk_alias:
+      case CORBA::tk_except:
+      case CORBA::tk_value:
+      case CORBA::tk_value_box:
+      case CORBA::tk_native:
+      case CORBA::tk_abstract_interface:
+      case CORBA::tk_local_interface:
+      case CORBA::tk_component:
+      case CORBA::tk_home:
+      case CORBA::tk_event:
+        hash = hash * 31 + ACE::hash_pjw(_type->id());
+        break;
+      default:
+        break;
+    }
+    return hash;
   }
 
   CORBA::Long
-  LogTypeRepository::addType(CORBA::TypeCode_ptr _type)
+  LogTypeRepository::addType(CORBA::TypeCode_ptr _type, ACE_UINT32 _hash)
   {
     // add type code to the mmapped file
 
@@ -119,6 +201,7 @@ namespace Miro
 
     // add type to our repository
     types_.push_back(CORBA::TypeCode::_duplicate(_type));
+    index_.insert(std::make_pair(_hash, CORBA::Long(types_.size() - 1)));
 
     // increase type code counter
     TAO_OutputCDR len(pNumTypes_, 32);
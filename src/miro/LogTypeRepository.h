@@ -40,7 +40,7 @@
 
 #include <string>
 #include <vector>
-#include <functional>
+#include <map>
 #include <algorithm>
 
 // forward declaration
@@ -68,16 +68,29 @@ namespace Miro
      * If the type code already exits in the repository the id is returned.
      * Otherwise, the type code is added to the repository first.
      *
-     * -1 is returned if the type code repository if full.
+     * -2 is returned if the type code repository is full.
+     *
+     * Lookup is by pointer identity first, then by a hash of the
+     * repository id and kind of the type code. TypeCode::equal() is only
+     * used to resolve hash collisions.
      */
     CORBA::Long typeID(CORBA::TypeCode_ptr _type);
 
+    //! Read further type codes from an input stream.
+    /**
+     * Appends @ref _numTypes type codes, keeping the ids and type codes
+     * read so far. For repositories, that grow while being read.
+     */
+    void read(TAO_InputCDR& _istr, ACE_UINT32 _numTypes) throw(Exception);
+
     //! Return the type code corresponding to the type id.
-    /** NULL if the type id is unknown. */
+    /** CORBA::_tc_null if the type id is unknown. */
     CORBA::TypeCode_ptr typeCode(ACE_INT32 _typeID);
 
     //! Maximum size of the repository backing storage.
     size_t totalLength() const;
+    //! Number of type codes in the repository.
+    ACE_UINT32 size() const;
 
   private:
     //--------------------------------------------------------------------------
@@ -85,23 +98,39 @@ namespace Miro
     //--------------------------------------------------------------------------
 
     typedef std::vector<CORBA::TypeCode_ptr> TypeCodeVector;
-    struct TCEq : public std::unary_function<char const *, bool> {
-      TCEq(CORBA::TypeCode_ptr _tc) : tc_(_tc) {}
-
-      bool operator()(CORBA::TypeCode_ptr _tc) const {
-        return tc_->equal(_tc);
-      }
-protected:
-      CORBA::TypeCode_ptr tc_;
+    //! Type ids, indexed by the hash of the repository id and kind.
+    typedef std::multimap<ACE_UINT32, CORBA::Long> TypeIndex;
+
+    //! Entry of the pointer identity cache.
+    /**
+     * The entry holds a reference to the type code, so its address
+     * can not be reused for another type while it is cached.
+     */
+    struct CacheEntry
+    {
+      CORBA::TypeCode_ptr tc;
+      CORBA::Long id;
     };
 
+    //--------------------------------------------------------------------------
+    // private constants
+    //--------------------------------------------------------------------------
+
+    //! Number of entries of the pointer identity cache (power of 2).
+    static unsigned int const CACHE_SIZE = 64;
 
     //--------------------------------------------------------------------------
     // private methods
     //--------------------------------------------------------------------------
 
+    //! Look up the type in the hash index, add it if unknown.
+    CORBA::Long lookupType(CORBA::TypeCode_ptr _type);
     //! Add type to the repository
-    CORBA::Long addType(CORBA::TypeCode_ptr _type);
+    CORBA::Long addType(CORBA::TypeCode_ptr _type, ACE_UINT32 _hash);
+    //! Hash of the type code, consistent with TypeCode::equal().
+    static ACE_UINT32 typeHash(CORBA::TypeCode_ptr _type);
+    //! Cache slot of a type code pointer.
+    static unsigned int cacheSlot(CORBA::TypeCode_ptr _type);
 
     //--------------------------------------------------------------------------
     // private data
@@ -115,6 +144,10 @@ protected:
     char * pNumTypes_;
 
     TypeCodeVector types_;
+    //! Hash index over types_.
+    TypeIndex index_;
+    //! Pointer identity cache.
+    CacheEntry cache_[CACHE_SIZE];
   };
 
   inline
@@ -124,19 +157,32 @@ protected:
     return totalLength_;
   }
 
+  inline
+  ACE_UINT32
+  LogTypeRepository::size() const
+  {
+    return static_cast<ACE_UINT32>(types_.size());
+  }
+
+  inline
+  unsigned int
+  LogTypeRepository::cacheSlot(CORBA::TypeCode_ptr _type)
+  {
+    // type codes are at least 8 byte aligned
+    return (reinterpret_cast<size_t>(_type) >> 3) & (CACHE_SIZE - 1);
+  }
+
   inline
   CORBA::Long
   LogTypeRepository::typeID(CORBA::TypeCode_ptr _type)
   {
-    // search for type code
-    TypeCodeVector::const_iterator where =
-      std::find_if(types_.begin(), types_.end(), TCEq(_type));
-    // return its index, if already known
-    if (where != types_.end()) {
-      return where - types_.begin();
+    // fast path: type code instance seen before
+    CacheEntry const& entry = cache_[cacheSlot(_type)];
+    if (entry.tc == _type) {
+      return entry.id;
     }
-    // add type code to the repository, and return the index
-    return addType(_type);
+    // search for type code, add it, if unknown
+    return lookupType(_type);
   }
 
   inline
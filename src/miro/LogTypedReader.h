@@ -0,0 +1,241 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef miro_LogTypedReader_h
+#define miro_LogTypedReader_h
+
+#include "LogReader.h"
+#include "LogCursor.h"
+#include "Log.h"
+
+#include <string>
+#include <vector>
+
+namespace Miro
+{
+  //! Typed iterator over the event bodies of a log file.
+  /**
+   * The reader yields the events of a log file carrying a body of
+   * the IDL type @ref T. The type codes of the log file are compared
+   * to the type code of @ref T once, each event record is then matched
+   * by the type id of its body. Records of other types are skipped by
+   * their length prefix, see @ref LogCursor.
+   *
+   * The body of a matching event is demarshalled straight from the
+   * log file into the reused value, bypassing the CORBA::Any of
+   * @ref LogReader::parseEventBody() and its extraction.
+   *
+   * Optionally, the events are also filtered by the domain and type
+   * name of their event type, like a @ref NotifyTypedConsumer.
+   *
+   * As the @ref LogCursor, the reader shares the position state of
+   * the @ref LogReader.
+   */
+  template<class T>
+  class LogTypedReader
+  {
+  public:
+    //--------------------------------------------------------------------------
+    // public types
+    //--------------------------------------------------------------------------
+
+    typedef T Value;
+
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+
+    //! Initializing constructor.
+    /**
+     * @param _type The type code of @ref T, like test::_tc_Sample.
+     * @param _typeName Type name of the events, empty for any.
+     * @param _domainName Domain name of the events, empty for any.
+     */
+    LogTypedReader(LogReader& _reader,
+                   CORBA::TypeCode_ptr _type,
+                   std::string const& _typeName = "",
+                   std::string const& _domainName = "");
+
+    //! Advance to the next event carrying a body of type @ref T.
+    /** Returns false at the end of the log file. */
+    bool next() throw();
+
+    //! The body of the current event.
+    /**
+     * The value is reused from event to event, its members are
+     * reallocated only as necessary.
+     */
+    Value const& value() const throw();
+    //! The body of the current event.
+    Value& value() throw();
+    //! Time stamp of the current event.
+    ACE_Time_Value const& stamp() const throw();
+    //! The record of the current event.
+    LogRecord const& record() const throw();
+    //! The cursor of the reader.
+    LogCursor& cursor() throw();
+
+  protected:
+    //--------------------------------------------------------------------------
+    // protected methods
+    //--------------------------------------------------------------------------
+
+    //! Flag indicating the type id denotes @ref T.
+    bool matchesType(ACE_INT32 _typeId) throw();
+    //! Flag indicating the event type matches the filter.
+    bool matchesName(LogRecord const& _record) const throw();
+
+    //--------------------------------------------------------------------------
+    // protected data
+    //--------------------------------------------------------------------------
+
+    //! The reader of the log file.
+    LogReader& reader_;
+    //! The cursor over the event records.
+    LogCursor cursor_;
+    //! The type code of @ref T.
+    CORBA::TypeCode_var type_;
+    //! Type name of the events, empty for any.
+    std::string const typeName_;
+    //! Domain name of the events, empty for any.
+    std::string const domainName_;
+    //! Matching flags, indexed by type id.
+    /**
+     * Type codes added to the log file later on, as by
+     * @ref LogReader::update(), are compared on demand.
+     */
+    std::vector<bool> match_;
+    //! The body of the current event.
+    Value value_;
+  };
+
+  template<class T>
+  inline
+  LogTypedReader<T>::LogTypedReader(LogReader& _reader,
+                                    CORBA::TypeCode_ptr _type,
+                                    std::string const& _typeName,
+                                    std::string const& _domainName) :
+    reader_(_reader),
+    cursor_(_reader),
+    type_(CORBA::TypeCode::_duplicate(_type)),
+    typeName_(_typeName),
+    domainName_(_domainName),
+    value_()
+  {}
+
+  template<class T>
+  inline
+  bool
+  LogTypedReader<T>::next() throw()
+  {
+    while (cursor_.next()) {
+      LogRecord const& record = cursor_.record();
+      if (record.typeId < 0 ||
+          !matchesType(record.typeId) ||
+          !matchesName(record))
+        continue;
+
+      // the CDR stream of the reader aligns relative to the log file,
+      // as the body was marshalled
+      reader_.rdPtr(record.body);
+      if (*reader_.istr() >> value_)
+        return true;
+
+      MIRO_LOG_OSTR(LL_ERROR,
+                    "LogTypedReader - Failed to demarshal the body of event " <<
+                    cursor_.number() << ".");
+      return false;
+    }
+    return false;
+  }
+
+  template<class T>
+  inline
+  typename LogTypedReader<T>::Value const&
+  LogTypedReader<T>::value() const throw()
+  {
+    return value_;
+  }
+
+  template<class T>
+  inline
+  typename LogTypedReader<T>::Value&
+  LogTypedReader<T>::value() throw()
+  {
+    return value_;
+  }
+
+  template<class T>
+  inline
+  ACE_Time_Value const&
+  LogTypedReader<T>::stamp() const throw()
+  {
+    return cursor_.record().stamp;
+  }
+
+  template<class T>
+  inline
+  LogRecord const&
+  LogTypedReader<T>::record() const throw()
+  {
+    return cursor_.record();
+  }
+
+  template<class T>
+  inline
+  LogCursor&
+  LogTypedReader<T>::cursor() throw()
+  {
+    return cursor_;
+  }
+
+  template<class T>
+  inline
+  bool
+  LogTypedReader<T>::matchesType(ACE_INT32 _typeId) throw()
+  {
+    // compare the type codes not seen so far
+    while (static_cast<size_t>(_typeId) >= match_.size()) {
+      CORBA::TypeCode_ptr tc = reader_.typeCode(static_cast<ACE_INT32>(match_.size()));
+      if (tc == CORBA::_tc_null)
+        return false;
+
+      bool equivalent = false;
+      try {
+        equivalent = tc->equivalent(type_.in());
+      }
+      catch (CORBA::Exception const&) {
+      }
+      match_.push_back(equivalent);
+    }
+    return match_[_typeId];
+  }
+
+  template<class T>
+  inline
+  bool
+  LogTypedReader<T>::matchesName(LogRecord const& _record) const throw()
+  {
+    return
+      (typeName_.empty() || typeName_ == _record.typeName.data) &&
+      (domainName_.empty() || domainName_ == _record.domainName.data);
+  }
+}
+#endif // miro_LogTypedReader_h
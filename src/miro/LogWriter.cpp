@@ -20,62 +20,127 @@
 //
 #include "LogWriter.h"
 #include "LogTypeRepository.h"
+#include "LogBlockCodec.h"
+#include "LogLiveFile.h"
+#include "LogFieldIndex.h"
+#include "LogFieldIndexFile.h"
 #include "Log.h"
 #include "Exception.h"
 
 #include <orbsvcs/Time_Utilities.h>
 
-#include <tao/Version.h>
-#if (TAO_MAJOR_VERSION > 1) || \
-  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION > 4) ) || \
-  ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) && (TAO_BETA_VERSION > 7) )
-#  include <tao/AnyTypeCode/Any_Impl.h>
-#elif ( (TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 4) )
-#  include <tao/Any_Impl.h>
-#else
-#include <tao/Marshal.h>
-#endif
-
 #include <ace/FILE_Connector.h>
 #include <ace/OS_Memory.h>
+#include <ace/OS_NS_unistd.h>
 
+#include <algorithm>
 #include <cstdio>
 
 namespace Miro
 {
   using namespace std;
 
+  namespace
+  {
+    size_t extentSize(LogNotifyParameters const& _parameters)
+    {
+      // extents are whole pages
+      size_t const pageSize = static_cast<size_t>(ACE_OS::getpagesize());
+      size_t size = std::max(static_cast<size_t>(_parameters.extentSize), pageSize);
+      return ((size + pageSize - 1) / pageSize) * pageSize;
+    }
+  }
+
   LogWriter::LogWriter(std::string const& _fileName,
                        LogNotifyParameters const& _parameters) :
       parameters_(_parameters),
       fileName_(_fileName),
-      memMap_((fileName_).c_str(), parameters_.maxFileSize,
+      extentSize_(extentSize(_parameters)),
+      memMap_((fileName_).c_str(), extentSize_,
               O_RDWR | O_CREAT | O_TRUNC, ACE_DEFAULT_FILE_PERMS, PROT_RDWR,
               ACE_MAP_SHARED),
-      header_(new(memMap_.addr()) LogHeader(w_)),
-      ostr_((char*)memMap_.addr() + sizeof(LogHeader),
-            memMap_.size() - sizeof(LogHeader) - parameters_.tCRFileSize),
-      tcrOstr_((char*)memMap_.addr() + memMap_.size() - parameters_.tCRFileSize,
-               parameters_.tCRFileSize),
+      header_(NULL),
+      ostr_(NULL),
+      streamOffset_(sizeof(LogHeader)),
+      tcrOstr_(parameters_.tCRFileSize),
       typeRepository_(&tcrOstr_, parameters_.tCRFileSize),
       tcrOffsetSlot_(NULL),
       numEventsSlot_(NULL),
+      indexOffsetSlot_(NULL),
       numEvents_(0UL),
       totalLength_(0),
-      full_(false)
+      full_(false),
+      batch_(false),
+      index_(parameters_.indexChunkSize),
+      live_(NULL),
+      fieldIndex_(NULL),
+      block_(NULL),
+      blockEvents_(0),
+      blockFirst_(0),
+      blockLast_(0)
   {
     MIRO_LOG_CTOR("Miro::LogWriter");
 
     if (memMap_.addr() == MAP_FAILED)
       throw CException(errno, "Opening " + _fileName + ": " + strerror(errno));
 
+    char * base = static_cast<char *>(memMap_.addr());
+    header_ = new(base) LogHeader(w_);
+    ostr_ = new TAO_OutputCDR(base + streamOffset_, memMap_.size() - streamOffset_);
+
     // The alignement is okay as we wrote 8 bytes of LogHeader
-    tcrOffsetSlot_ = ostr_.current()->wr_ptr();
-    ostr_.write_ulong(memMap_.size() - parameters_.tCRFileSize);
+    tcrOffsetSlot_ = ostr_->current()->wr_ptr();
+    // The type code repository is written on close.
+    ostr_->write_ulonglong(0);
+
+    // The allignement is okay as we write now a ulonglong.
+    numEventsSlot_ = ostr_->current()->wr_ptr();
+    ostr_->write_ulonglong(0);
+
+    // The event index is written on close.
+    indexOffsetSlot_ = ostr_->current()->wr_ptr();
+    ostr_->write_ulonglong(0);
+    // Flags and a reserved field, keeping the events 8 byte aligned.
+    ostr_->write_ulong((parameters_.compress)? LogHeader::FLAG_COMPRESSED : 0);
+    ostr_->write_ulong(0);
+
+    totalLength_ = ostr_->total_length();
+
+    // Events are collected in blocks, which are compressed into the file.
+    if (parameters_.compress) {
+      if (!LogBlockCodec::available()) {
+        MIRO_LOG(LL_WARNING, "LogWriter - No compression support, blocks are stored uncompressed.");
+      }
+      resetBlock(std::max(static_cast<size_t>(parameters_.blockSize),
+                          static_cast<size_t>(ACE_CDR::MAX_ALIGNMENT)));
+    }
 
-    // The allignement is okay as we write now a ulong.
-    numEventsSlot_ = ostr_.current()->wr_ptr();
-    ostr_.write_ulong(0);
+    // Readers can follow the log file, while it is written,
+    // and read it, if the writer crashes before packing the type code repository.
+    if (parameters_.liveTail && block_ == NULL) {
+      try {
+        live_ = new LogLiveFile(fileName_, parameters_.tCRFileSize, w_);
+        live_->publish(numEvents_, totalLength_);
+      }
+      catch (CException const& e) {
+        MIRO_LOG_OSTR(LL_WARNING, "LogWriter - Live tailing of " << fileName_ << " disabled: " << e);
+      }
+    }
+    else {
+      if (parameters_.liveTail) {
+        MIRO_LOG(LL_NOTICE,
+                 "LogWriter - No live file for compressed log files, "
+                 "they are only readable after a clean shutdown.");
+      }
+      // a live file left behind by a crashed writer would mislead readers
+      ACE_OS::unlink(LogLiveFile::fileName(fileName_).c_str());
+    }
+
+    // the field index of a former log file of that name is stale
+    ACE_OS::unlink(LogFieldIndexFile::fileName(fileName_).c_str());
+    if (!parameters_.indexField.empty()) {
+      fieldIndex_ = new LogFieldIndex(parameters_.indexField);
+    }
   }
 
   LogWriter::~LogWriter()
@@ -83,12 +148,28 @@ namespace Miro
     //--------------------------------------------------------------------------
     // place type codes at the end of the event stream
     //--------------------------------------------------------------------------
-    packTCR();
+    try {
+      if (block_ != NULL) {
+        flushBlock(ACE_align_binary(ostr_->total_length(), ACE_CDR::LONGLONG_SIZE));
+      }
+      packTCR();
+      packIndex();
+    }
+    catch (CException const& e) {
+      // We shouldn't throw in a destructor...
+      MIRO_LOG_OSTR(LL_ERROR,
+                    "LogWriter - Error writing type code repository of " << fileName_ << ": " << e);
+    }
 
     //--------------------------------------------------------------------------
     // log file size cleanup
     //--------------------------------------------------------------------------
 
+    delete ostr_;
+    if (block_ != NULL) {
+      block_->release();
+    }
+
     // close the memory mapped file
     memMap_.close();
 
@@ -99,92 +180,123 @@ namespace Miro
                     " truncating log file " << fileName_  << std::endl
                     << strerror(errno));
     }
+
+    // the field index refers to the final size of the log file
+    if (fieldIndex_ != NULL) {
+      try {
+        LogFieldIndexFile::write(fileName_, numEvents_, *fieldIndex_);
+      }
+      catch (Exception const& e) {
+        MIRO_LOG_OSTR(LL_ERROR,
+                      "LogWriter - Error writing field index of " << fileName_ << ": " << e);
+      }
+      delete fieldIndex_;
+    }
+
+    // the log file is complete, readers following it are done
+    if (live_ != NULL) {
+      live_->close();
+      delete live_;
+    }
   }
 
   bool
   LogWriter::logEvent(ACE_Time_Value const& _stamp,
                       CosNotification::StructuredEvent const& _event)
   {
-    // if there is place in the log file
-    if (!full_) { // not full
+    // obtain type code id
+    CORBA::Long typeId = -1;
+    if (!full_) {
+      CORBA::TypeCode_var tc = _event.remainder_of_body.type();
+      if (tc.in() != CORBA::_tc_null) {
+        typeId = typeID(tc.in());
+      }
+    }
+    return appendEvent(_stamp, _event, typeId);
+  }
+
+  bool
+  LogWriter::appendEvent(ACE_Time_Value const& _stamp,
+                         CosNotification::StructuredEvent const& _event,
+                         CORBA::Long _typeId)
+  {
+    // if there is place in the log file and not type code repository full
+    if (!full_ && _typeId != -2) {
 
       // set the time stamp
       TimeBase::TimeT t;
       ORBSVCS_Time::Absolute_Time_Value_to_TimeT(t, _stamp);
 
-      if (ostr_.write_ulonglong(t)) { // write time stamp
-
-        /*Slot to write the length of the serialized structured event.
-         * This is used for skipped parsing of the file. */
-        char * lengthSlot =
-          // The alignement is okay as we wrote an ulonglong before
-          ostr_.current()->wr_ptr();
-
-        // write the length slot
-        if (ostr_.write_ulong(0) &&
-                    // write the header
-                    ostr_ << _event.header &&
-                    // write the filterable data
-                    ostr_ << _event.filterable_data) { // and now the data
-
-
-          // serialize remainder_of_body
-
-          // obtain type code id
-          CORBA::Long typeId = -1;
-          CORBA::TypeCode_var tc = _event.remainder_of_body.type();
-          if (tc.in() != CORBA::_tc_null) {
-            typeId = typeRepository_.typeID(tc.in());
-          }
-
-#if (TAO_MAJOR_VERSION > 1) || \
-  ((TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION >= 4)) || \
-  ((TAO_MAJOR_VERSION == 1) && (TAO_MINOR_VERSION == 3 && TAO_BETA_VERSION >= 5))
-
-          //----------------------------------------------------------------
-          // we have Any_Impl
-          //----------------------------------------------------------------
-
-          // if not type code repository full
-          if (typeId != -2 &&
-                      // write type code id
-                      ostr_.write_long(typeId) &&
-                      // write any value if existent
-                      (_event.remainder_of_body.impl() == NULL ||
-                       _event.remainder_of_body.impl()->marshal_value(ostr_)) &&
-                      // not max file size reached
-                      (ostr_.total_length() <=
-                       (parameters_.maxFileSize - parameters_.tCRFileSize - 100000))) {
-
-            ostr_.consolidate();
-
-            MIRO_ASSERT(ostr_.current() == ostr_.begin());
-
-            // calculate length
-            char * here = ACE_ptr_align_binary(ostr_.current()->wr_ptr(), ACE_CDR::LONGLONG_SIZE);
-            CORBA::ULong length = here - lengthSlot;
-
-            // write the length of the event
-            // direct writing is allowed,
-            // as the alignement is correct and we write in host byte order
-            *reinterpret_cast<ACE_INT32 *>(lengthSlot) = length;
-
-            // write number of events
-            // direct writing is allowed,
-            // as the alignement is correct and we write in host byte order
-            *reinterpret_cast<ACE_INT32 *>(numEventsSlot_) = ++numEvents_;
-
-            totalLength_ = ostr_.total_length();
-            return true;
-          }
-#else
-#error Only TAO >= Version 1.3.5 is supported
-#endif
-        }
+      if (block_ != NULL) {
+        if (logBlockEvent(t, _event, _typeId))
+          return true;
+        full_ = true;
+        return false;
       }
-      full_ = true;
+
+      // start of the event in the log file
+      size_t const eventOffset =
+        ACE_align_binary(sizeof(LogHeader) + totalLength_, ACE_CDR::LONGLONG_SIZE);
+
+      if (marshalEvent(t, _event, _typeId)) {
+        index_.add(t, eventOffset, _event.header.fixed_header.event_type);
+        if (fieldIndex_ != NULL)
+          fieldIndex_->add(index_.size() - 1, _event.filterable_data);
+        return true;
+      }
+
+      // the event did not fit into the mapped extents (or the reservation of its batch),
+      // so grow the file and try once more
+      size_t const eventLength =
+        ostr_->total_length() - (eventOffset - streamOffset_);
+
+      if (grow(eventOffset, eventOffset + eventLength + ACE_CDR::MAX_ALIGNMENT) &&
+          marshalEvent(t, _event, _typeId)) {
+        index_.add(t, eventOffset, _event.header.fixed_header.event_type);
+        if (fieldIndex_ != NULL)
+          fieldIndex_->add(index_.size() - 1, _event.filterable_data);
+        return true;
+      }
+    }
+    full_ = true;
+
+    MIRO_LOG_OSTR(LL_ERROR,
+                  "Event log data - max file size reached:" <<
+                  totalLength_ <<
+                  " - Event logging stopped.");
+    return false;
+  }
+
+  bool
+  LogWriter::logRecord(TimeBase::TimeT _stamp,
+                       CosNotification::EventType const& _type,
+                       char const * _record, size_t _length)
+  {
+    if (full_ || block_ != NULL)
+      return false;
+
+    // start of the event in the log file
+    size_t const eventOffset =
+      ACE_align_binary(sizeof(LogHeader) + totalLength_, ACE_CDR::LONGLONG_SIZE);
+
+    if ((eventOffset + _length <= memMap_.size() ||
+         grow(eventOffset, eventOffset + _length)) &&
+        // the record keeps its alignment
+        ostr_->align_write_ptr(ACE_CDR::LONGLONG_SIZE) == 0 &&
+        ostr_->write_octet_array(reinterpret_cast<ACE_CDR::Octet const *>(_record), _length) &&
+        ostr_->current() == ostr_->begin()) {
+      publishEvent();
+      index_.add(_stamp, eventOffset, _type);
+      if (fieldIndex_ != NULL &&
+          !fieldIndex_->addRecord(index_.size() - 1,
+                                  static_cast<char *>(memMap_.addr()) + eventOffset, _length,
+                                  ACE_CDR_BYTE_ORDER)) {
+        MIRO_LOG(LL_ERROR, "LogWriter - Filterable data of event record not indexed.");
+      }
+      return true;
     }
 
+    full_ = true;
     MIRO_LOG_OSTR(LL_ERROR,
                   "Event log data - max file size reached:" <<
                   totalLength_ <<
@@ -192,21 +304,313 @@ namespace Miro
     return false;
   }
 
+  CORBA::Long
+  LogWriter::typeID(CORBA::TypeCode_ptr _tc)
+  {
+    size_t const tcrLength = typeRepository_.totalLength();
+    CORBA::Long const id = typeRepository_.typeID(_tc);
+
+    // new type codes are published ahead of the events using them
+    if (live_ != NULL && typeRepository_.totalLength() != tcrLength &&
+        !live_->publishTypes(tcrOstr_.begin()->rd_ptr(),
+                             typeRepository_.totalLength(), typeRepository_.size())) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogWriter - Type code repository exceeds live file of " << fileName_);
+    }
+    return id;
+  }
+
+  void
+  LogWriter::reserveBatch(size_t _events)
+  {
+    // compressed log files are grown per block
+    if (full_ || block_ != NULL || numEvents_ == 0)
+      return;
+
+    size_t const eventOffset =
+      ACE_align_binary(sizeof(LogHeader) + totalLength_, ACE_CDR::LONGLONG_SIZE);
+    size_t const average = totalLength_ / numEvents_ + ACE_CDR::MAX_ALIGNMENT;
+    size_t const required = std::min(eventOffset + _events * average, sizeLimit());
+
+    // events not fitting anyway are handled by logEvent()
+    if (required > memMap_.size()) {
+      grow(eventOffset, required);
+    }
+  }
+
+  void
+  LogWriter::commitBatch()
+  {
+    batch_ = false;
+    publish();
+  }
+
+  bool
+  LogWriter::marshalEvent(TimeBase::TimeT _stamp,
+                          CosNotification::StructuredEvent const& _event,
+                          CORBA::Long _typeId)
+  {
+    if (marshaller_.marshal(*ostr_, _stamp, _event, _typeId) == NULL)
+      return false;
+
+    // blocks of compressed log files are accounted on flush
+    if (block_ == NULL) {
+      publishEvent();
+    }
+    return true;
+  }
+
+  void
+  LogWriter::publishEvent()
+  {
+    ++numEvents_;
+    totalLength_ = (streamOffset_ - sizeof(LogHeader)) + ostr_->total_length();
+
+    // batches are published on commit
+    if (!batch_)
+      publish();
+  }
+
+  void
+  LogWriter::publish()
+  {
+    // the events have to be visible before their count
+    LogLiveFile::releaseFence();
+    // direct writing is allowed,
+    // as the alignement is correct and we write in host byte order
+    *reinterpret_cast<ACE_UINT64 volatile *>(numEventsSlot_) = numEvents_;
+
+    if (live_ != NULL)
+      live_->publish(numEvents_, totalLength_);
+  }
+
+  bool
+  LogWriter::logBlockEvent(TimeBase::TimeT _stamp,
+                           CosNotification::StructuredEvent const& _event,
+                           CORBA::Long _typeId)
+  {
+    // start of the event in the block
+    size_t eventOffset = ACE_align_binary(ostr_->total_length(), ACE_CDR::LONGLONG_SIZE);
+
+    if (!marshalEvent(_stamp, _event, _typeId)) {
+      // the block is full, so compress it into the file
+      size_t const eventLength = ostr_->total_length() - eventOffset;
+      if (!flushBlock(eventOffset))
+        return false;
+
+      // start the next block, large enough for the event
+      resetBlock(std::max(static_cast<size_t>(parameters_.blockSize),
+                          eventLength + ACE_CDR::MAX_ALIGNMENT));
+      eventOffset = 0;
+      if (!marshalEvent(_stamp, _event, _typeId))
+        return false;
+    }
+
+    // the compressed block has to fit into the file, along with its index entries
+    size_t const rawLength = ACE_align_binary(ostr_->total_length(), ACE_CDR::LONGLONG_SIZE);
+    if (ACE_align_binary(sizeof(LogHeader) + totalLength_, ACE_CDR::LONGLONG_SIZE) +
+        sizeof(LogHeader::BlockHeader) + LogBlockCodec::bound(rawLength) +
+        (index_.size() + 1) * sizeof(LogHeader::IndexEntry) +
+        (blocks_.size() + 1) * sizeof(LogHeader::BlockEntry) > sizeLimit()) {
+      // leave the event to the next log file
+      flushBlock(eventOffset);
+      return false;
+    }
+
+    if (blockEvents_ == 0)
+      blockFirst_ = _stamp;
+    blockLast_ = _stamp;
+    ++blockEvents_;
+    index_.add(_stamp, eventOffset, _event.header.fixed_header.event_type);
+    if (fieldIndex_ != NULL)
+      fieldIndex_->add(index_.size() - 1, _event.filterable_data);
+
+    return true;
+  }
+
+  bool
+  LogWriter::flushBlock(size_t _rawLength)
+  {
+    if (blockEvents_ == 0)
+      return true;
+
+    char * const data = block_->rd_ptr();
+
+    // clear the alignment padding of the last event
+    size_t const length = std::min(ostr_->total_length(), _rawLength);
+    memset(data + length, 0, _rawLength - length);
+
+    codecBuffer_.resize(LogBlockCodec::bound(_rawLength));
+    size_t compressedLength;
+    ACE_UINT32 const codec =
+      LogBlockCodec::compress(parameters_.compressionLevel,
+                              data, _rawLength,
+                              &codecBuffer_[0], compressedLength);
+
+    size_t const offset = ACE_align_binary(sizeof(LogHeader) + totalLength_, ACE_CDR::LONGLONG_SIZE);
+    size_t const required = offset + sizeof(LogHeader::BlockHeader) + compressedLength;
+    if (required > memMap_.size() && !reserve(required)) {
+      MIRO_LOG_OSTR(LL_ERROR,
+                    "LogWriter - No room for event block in " << fileName_ <<
+                    ", " << blockEvents_ << " events lost.");
+      index_.truncate(numEvents_);
+      if (fieldIndex_ != NULL)
+        fieldIndex_->truncate(numEvents_);
+      blockEvents_ = 0;
+      return false;
+    }
+
+    // direct writing is allowed,
+    // as the alignement is correct and we write in host byte order
+    char * const base = static_cast<char *>(memMap_.addr());
+    LogHeader::BlockHeader * header = reinterpret_cast<LogHeader::BlockHeader *>(base + offset);
+    header->length = compressedLength;
+    header->rawLength = _rawLength;
+    header->events = blockEvents_;
+    header->codec = codec;
+    memcpy(base + offset + sizeof(LogHeader::BlockHeader), &codecBuffer_[0], compressedLength);
+
+    LogHeader::BlockEntry entry;
+    entry.firstStamp = blockFirst_;
+    entry.lastStamp = blockLast_;
+    entry.offset = offset;
+    entry.firstEvent = numEvents_;
+    blocks_.push_back(entry);
+
+    MIRO_DBG_OSTR(MIRO, LL_PRATTLE,
+                  "LogWriter - Block of " << blockEvents_ << " events: " <<
+                  _rawLength << " -> " << compressedLength << " bytes");
+
+    numEvents_ += blockEvents_;
+    totalLength_ = required - sizeof(LogHeader);
+    blockEvents_ = 0;
+    publish();
+    return true;
+  }
+
+  void
+  LogWriter::resetBlock(size_t _size)
+  {
+    if (block_ == NULL || block_->size() < _size + ACE_CDR::MAX_ALIGNMENT) {
+      if (block_ != NULL)
+        block_->release();
+      block_ = new ACE_Message_Block(_size + ACE_CDR::MAX_ALIGNMENT);
+      ACE_CDR::mb_align(block_);
+    }
+
+    delete ostr_;
+    ostr_ = new TAO_OutputCDR(block_->rd_ptr(), block_->space());
+  }
+
+  size_t
+  LogWriter::sizeLimit() const
+  {
+    // leave room for the type code repository
+    size_t limit = parameters_.maxFileSize;
+    size_t const tcrLength = typeRepository_.totalLength() + ACE_CDR::MAX_ALIGNMENT;
+    limit = (limit > tcrLength)? limit - tcrLength : 0;
+    limit -= limit % static_cast<size_t>(ACE_OS::getpagesize());
+    return limit;
+  }
+
+  bool
+  LogWriter::reserve(size_t _required)
+  {
+    // grow in whole extents
+    size_t size = ((_required + extentSize_ - 1) / extentSize_) * extentSize_;
+
+    size_t const limit = sizeLimit();
+    if (size > limit) {
+      size = limit;
+      if (size < _required || size <= memMap_.size())
+        return false;
+    }
+
+    try {
+      remap(size);
+    }
+    catch (CException const& e) {
+      MIRO_LOG_OSTR(LL_ERROR, "LogWriter - Failed to grow " << fileName_ << ": " << e);
+      return false;
+    }
+
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "LogWriter - " << fileName_ << " grown to " << memMap_.size() << " bytes.");
+    return true;
+  }
+
+  bool
+  LogWriter::grow(size_t _streamOffset, size_t _required)
+  {
+    if (!reserve(_required))
+      return false;
+
+    // restart the CDR stream at the current event
+    char * base = static_cast<char *>(memMap_.addr());
+    delete ostr_;
+    ostr_ = new TAO_OutputCDR(base + _streamOffset, memMap_.size() - _streamOffset);
+    streamOffset_ = _streamOffset;
+    return true;
+  }
+
+  void
+  LogWriter::remap(size_t _size) throw(CException)
+  {
+    size_t const oldSize = memMap_.size();
+
+    memMap_.unmap();
+    if (memMap_.map(_size, PROT_RDWR, ACE_MAP_SHARED) == -1) {
+      int const error = errno;
+      // keep the log accessible
+      if (memMap_.map(oldSize, PROT_RDWR, ACE_MAP_SHARED) == -1) {
+        throw CException(errno, "Remapping " + fileName_ + ": " + strerror(errno));
+      }
+      throw CException(error, "Growing " + fileName_ + ": " + strerror(error));
+    }
+
+    // the mapping might have moved
+    char * base = static_cast<char *>(memMap_.addr());
+    header_ = reinterpret_cast<LogHeader *>(base);
+    tcrOffsetSlot_ = base + sizeof(LogHeader);
+    numEventsSlot_ = tcrOffsetSlot_ + sizeof(ACE_UINT64);
+    indexOffsetSlot_ = numEventsSlot_ + sizeof(ACE_UINT64);
+  }
+
+  void
+  LogWriter::prefault(size_t _size)
+  {
+    char * const base = static_cast<char *>(memMap_.addr());
+    char * first = base + sizeof(LogHeader) + totalLength_;
+    char * last = base + memMap_.size();
+    if (static_cast<size_t>(last - first) > _size)
+      last = first + _size;
+
+    // one write per page, the events will overwrite it anyway
+    size_t const pageSize = ACE_OS::getpagesize();
+    for (char volatile * p = first; p < last; p += pageSize) {
+      *p = 0;
+    }
+  }
+
   void
   LogWriter::packTCR() throw(CException)
   {
-    char * dest = (char *)memMap_.addr();
-    ACE_UINT32 offset = sizeof(LogHeader) + totalLength_;
+    size_t offset = sizeof(LogHeader) + totalLength_;
 
     // 8 byte alignement
     offset += (0x08 - (totalLength_ & 0x07)) & 0x07;
 
-    dest += offset;
-    memmove(dest, tcrOstr_.current()->base(), typeRepository_.totalLength());
+    // make room for the type code repository
+    size_t const required = offset + typeRepository_.totalLength();
+    if (required > memMap_.size()) {
+      remap(required);
+    }
+
+    char * dest = (char *)memMap_.addr() + offset;
+    memcpy(dest, tcrOstr_.begin()->rd_ptr(), typeRepository_.totalLength());
 
     // note new location of tcr
     TAO_OutputCDR o_(tcrOffsetSlot_, 8);
-    o_.write_ulong(offset);
+    o_.write_ulonglong(offset);
 
     MIRO_DBG_OSTR(MIRO, LL_DEBUG,
                   "LogWriter - TCR Offset: 0x" << std::hex << offset << std::dec << std::endl <<
@@ -217,4 +621,62 @@ namespace Miro
     MIRO_DBG_OSTR(MIRO, LL_DEBUG,
                   "LogWriter - TCR length: " <<  typeRepository_.totalLength());
   }
+
+  void
+  LogWriter::packIndex() throw(CException)
+  {
+    // event type table, sorted by id
+    CosNotification::EventTypeSeq types;
+    index_.eventTypes(types);
+
+    TAO_OutputCDR typesOstr;
+    typesOstr << types;
+    typesOstr.consolidate();
+
+    // 8 byte alignement
+    size_t const offset = ACE_align_binary(totalLength_, ACE_CDR::LONGLONG_SIZE);
+    size_t const entriesOffset =
+      ACE_align_binary(offset + typesOstr.total_length(), ACE_CDR::LONGLONG_SIZE);
+    size_t const entriesLength = index_.size() * sizeof(LogHeader::IndexEntry);
+    // block index of compressed log files
+    size_t const blocksOffset =
+      ACE_align_binary(entriesOffset + sizeof(ACE_UINT64) + entriesLength,
+                       ACE_CDR::LONGLONG_SIZE);
+    size_t const blocksLength = blocks_.size() * sizeof(LogHeader::BlockEntry);
+    size_t const required = (block_ == NULL)?
+      entriesOffset + sizeof(ACE_UINT64) + entriesLength :
+      blocksOffset + sizeof(ACE_UINT64) + blocksLength;
+
+    if (required > memMap_.size()) {
+      remap(required);
+    }
+
+    char * const base = static_cast<char *>(memMap_.addr());
+
+    // event type table
+    memcpy(base + offset, typesOstr.begin()->rd_ptr(), typesOstr.total_length());
+    // direct writing is allowed,
+    // as the alignement is correct and we write in host byte order
+    *reinterpret_cast<ACE_UINT64 *>(base + entriesOffset) = index_.size();
+    // streamed from the spilled chunks of the index
+    if (!index_.copy(reinterpret_cast<LogHeader::IndexEntry *>(base + entriesOffset +
+                                                               sizeof(ACE_UINT64))))
+      throw CException(errno, "Reading the event index of " + fileName_ + ": " + strerror(errno));
+    if (block_ != NULL) {
+      *reinterpret_cast<ACE_UINT64 *>(base + blocksOffset) = blocks_.size();
+      if (blocksLength > 0) {
+        memcpy(base + blocksOffset + sizeof(ACE_UINT64), &blocks_[0], blocksLength);
+      }
+    }
+
+    // note location of the index
+    *reinterpret_cast<ACE_UINT64 *>(indexOffsetSlot_) = offset;
+
+    MIRO_DBG_OSTR(MIRO, LL_DEBUG,
+                  "LogWriter - Index Offset: 0x" << std::hex << offset << std::dec << std::endl <<
+                  "LogWriter - Index event types: " << types.length());
+
+    // get total length of the file
+    totalLength_ = required;
+  }
 }
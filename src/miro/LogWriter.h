@@ -22,6 +22,8 @@
 #define LogWriter_h
 
 #include "LogHeader.h"
+#include "LogIndex.h"
+#include "LogEventMarshaller.h"
 #include "LogTypeRepository.h"
 #include "StructuredPushConsumer.h"
 #include "miro/Parameters.h"
@@ -32,10 +34,16 @@
 #include <ace/High_Res_Timer.h>
 #include <tao/CDR.h>
 
+#include <iterator>
 #include <string>
+#include <vector>
 
 namespace Miro
 {
+  // forward declarations
+  class LogLiveFile;
+  class LogFieldIndex;
+
   class miro_Export LogWriter
   {
   public:
@@ -52,15 +60,100 @@ namespace Miro
     //! Inherited IDL interface: StructuredPushSupplier method
     bool logEvent(ACE_Time_Value const& _stamp,
                   CosNotification::StructuredEvent const& _event);
+    //! Log a batch of events.
+    /**
+     * The elements of the range provide the members stamp and event,
+     * like @ref LogEventQueue::Entry. Space for the batch is reserved
+     * once up front, the events are marshalled back to back into it,
+     * consecutive events of a type share the lookup of the type id, and
+     * the event count of the log file is published once for the whole
+     * batch. The file only grows per event, if the batch exceeds its
+     * estimate.
+     *
+     * Returns the position of the first event, that did not fit into
+     * the log file, @ref _last if all events were logged.
+     */
+    template<class ForwardIterator>
+    ForwardIterator logEvents(ForwardIterator _first, ForwardIterator _last);
+    //! Log an already marshalled event.
+    /**
+     * @ref _record holds the event in the format of the log file,
+     * starting with the time stamp. Its type id has to refer to the
+     * type code repository of this writer, see @ref typeID().
+     * Not supported for compressed log files.
+     */
+    bool logRecord(TimeBase::TimeT _stamp,
+                   CosNotification::EventType const& _type,
+                   char const * _record, size_t _length);
+    //! Type id of the type code in the type code repository of the log.
+    /** -2 if the repository is full. */
+    CORBA::Long typeID(CORBA::TypeCode_ptr _tc);
     //! Report the protocol version.
     ACE_UINT16 version() const;
+    //! Flag indicating a log file of compressed event blocks.
+    bool compressed() const;
+    //! Touch the first @ref _size bytes of the event stream.
+    /** Moves the page faults of a fresh log file off the logging path. */
+    void prefault(size_t _size);
 
   protected:
+    //--------------------------------------------------------------------------
+    // protected types
+    //--------------------------------------------------------------------------
+
+    //! Block index of a compressed log file.
+    typedef std::vector<LogHeader::BlockEntry> BlockVector;
+
     //--------------------------------------------------------------------------
     // protected methods
     //--------------------------------------------------------------------------
 
+    //! Grow the file ahead of a batch of @ref _events events.
+    /** The estimate is based on the average event length so far. */
+    void reserveBatch(size_t _events);
+    //! Publish the event count of the batch.
+    void commitBatch();
+    //! Log an event of a known type id.
+    /** Returns false, if the event did not fit. */
+    bool appendEvent(ACE_Time_Value const& _stamp,
+                     CosNotification::StructuredEvent const& _event,
+                     CORBA::Long _typeId);
+    //! Marshal the event into the mapped extents.
+    /** Returns false, if the event did not fit. */
+    bool marshalEvent(TimeBase::TimeT _stamp,
+                      CosNotification::StructuredEvent const& _event,
+                      CORBA::Long _typeId);
+    //! Account for the event just written to the mapped extents.
+    void publishEvent();
+    //! Publish event count and stream length to readers of the log file.
+    void publish();
+    //! Add the event to the current block of a compressed log file.
+    /** Returns false, if the file is full. */
+    bool logBlockEvent(TimeBase::TimeT _stamp,
+                       CosNotification::StructuredEvent const& _event,
+                       CORBA::Long _typeId);
+    //! Compress the first @ref _rawLength bytes of the current block into the file.
+    /** Returns false, if the file is full. */
+    bool flushBlock(size_t _rawLength);
+    //! Restart the CDR stream on an empty block buffer of at least @ref _size bytes.
+    void resetBlock(size_t _size);
+    //! Maximum size of the file, leaving room for the type code repository.
+    size_t sizeLimit() const;
+    //! Make sure, that the mapped file holds at least @ref _required bytes.
+    /** Returns false, if the maximum file size would be exceeded. */
+    bool reserve(size_t _required);
+    //! Grow the file, so that it holds at least @ref _required bytes.
+    /**
+     * The CDR stream is restarted at @ref _streamOffset.
+     * Returns false, if the maximum file size would be exceeded.
+     */
+    bool grow(size_t _streamOffset, size_t _required);
+    //! Map @ref _size bytes of the file.
+    void remap(size_t _size) throw(CException);
+
     void packTCR() throw(CException);
+    //! Append the event index behind the type code repository.
+    void packIndex() throw(CException);
 
     //--------------------------------------------------------------------------
     // protected data
@@ -70,6 +163,8 @@ namespace Miro
     LogNotifyParameters const& parameters_;
     //! The name of the log file.
     std::string const fileName_;
+    //! Size of the extents, the file grows by.
+    size_t const extentSize_;
     //! Memory mapped file, holding the log.
     ACE_Mem_Map memMap_;
     //! Writer flag for log header.
@@ -78,8 +173,19 @@ namespace Miro
     //! Header block of the log file.
     LogHeader * header_;
     //! CDR stream to log to.
-    TAO_OutputCDR ostr_;
+    /**
+     * Writes into the mapped file. Recreated, when the file grows.
+     * For compressed log files, it writes into the block buffer.
+     */
+    TAO_OutputCDR * ostr_;
+    //! Offset of the start of the CDR stream in the log file.
+    size_t streamOffset_;
     //! CDR stream to log type codes to.
+    /**
+     * The type code repository is kept in memory, until the log is
+     * closed. New type codes are written through to the live file, so
+     * the log stays readable, if the writer crashes.
+     */
     TAO_OutputCDR tcrOstr_;
     //! Instance of the type repository.
     LogTypeRepository typeRepository_;
@@ -87,19 +193,81 @@ namespace Miro
     char * tcrOffsetSlot_;
     //! Slot to write the number of events in the log file. */
     char * numEventsSlot_;
+    //! Slot to write the offset of the event index in the log file. */
+    char * indexOffsetSlot_;
     //! Variable holding the number of events in the log file.
-    ACE_INT32 numEvents_;
+    ACE_UINT32 numEvents_;
     //! The length of the cdr stream
     size_t totalLength_;
     //! Flag indicating that the file is full.
     bool full_;
+    //! Flag indicating that the event count is published by @ref commitBatch().
+    bool batch_;
+
+    //! The event index, written on close.
+    /** Spilled to a temporary file in chunks of IndexChunkSize events. */
+    LogIndex index_;
+    //! Marshals the events in the format of the log file.
+    LogEventMarshaller marshaller_;
+    //! State published for readers following the log file.
+    /** NULL, if live tailing is disabled. */
+    LogLiveFile * live_;
+    //! Index of the filterable data fields, written on close.
+    /** NULL, if no fields are indexed. */
+    LogFieldIndex * fieldIndex_;
+
+    //! Buffer of the current event block of a compressed log file.
+    /** NULL, if the log is not compressed. */
+    ACE_Message_Block * block_;
+    //! Buffer for the compressed event block.
+    std::vector<char> codecBuffer_;
+    //! Number of events in the current block.
+    ACE_UINT32 blockEvents_;
+    //! Time stamp of the first event in the current block.
+    TimeBase::TimeT blockFirst_;
+    //! Time stamp of the last event in the current block.
+    TimeBase::TimeT blockLast_;
+    //! The block index, written on close.
+    BlockVector blocks_;
   };
 
+  template<class ForwardIterator>
+  ForwardIterator
+  LogWriter::logEvents(ForwardIterator _first, ForwardIterator _last)
+  {
+    reserveBatch(std::distance(_first, _last));
+
+    // the anys of the batch keep their type codes alive
+    CORBA::TypeCode_ptr type = CORBA::TypeCode::_nil();
+    CORBA::Long typeId = -1;
+
+    batch_ = true;
+    for (; _first != _last; ++_first) {
+      CORBA::TypeCode_var tc = _first->event.remainder_of_body.type();
+      if (tc.in() != type && !full_) {
+        type = tc.in();
+        typeId = (type != CORBA::_tc_null)? typeID(type) : -1;
+      }
+      if (!appendEvent(_first->stamp, _first->event, typeId))
+        break;
+    }
+    commitBatch();
+
+    return _first;
+  }
+
   inline
   ACE_UINT16
   LogWriter::version() const
   {
     return LogHeader::PROTOCOL_VERSION;
   }
+
+  inline
+  bool
+  LogWriter::compressed() const
+  {
+    return block_ != NULL;
+  }
 }
 #endif
@@ -25,20 +25,34 @@
 #include "ServerWorker.h"
 #include "ClientParameters.h"
 #include "LogNotifyConsumer.h"
+#include "LogServiceImpl.h"
 #include "Configuration.h"
 
 #include <orbsvcs/Notify/Service.h>
 #include <orbsvcs/CosNotifyChannelAdminC.h>
 #include <orbsvcs/CosNamingC.h>
+#include <tao/ORB_Core.h>
 
 #include <ace/OS_NS_strings.h>
 #include <ace/Get_Opt.h>
+#include <ace/Reactor.h>
 
 namespace Miro
 {
+  namespace
+  {
+    //! The reactor of the ORB, the only one running in the service.
+    ACE_Reactor *
+    orbReactor()
+    {
+      return TAO_ORB_Core_instance()->reactor();
+    }
+  }
+
   using namespace std;
 
   NotifyLogSvc::NotifyLogSvc() :
+      _server(NULL),
       _consumer(NULL)
   {
     MIRO_LOG_CTOR("Miro::NotifyLogSvc");
@@ -70,6 +84,16 @@ namespace Miro
                                     RobotParameters::instance()->namingContextName,
                                     _fileName,
                                     *Miro::LogNotifyParameters::instance());
+
+      if (Miro::LogNotifyParameters::instance()->flightRecorder) {
+        if (orbReactor()->register_handler(SIGUSR1, this) == -1) {
+          MIRO_LOG(LL_WARNING, "NotifyLogSvc - Failed to register the flight recorder dump signal.");
+        }
+
+        // remote control of the flight recorder
+        _server = new Server();
+        _server->activateNamedObject(_serviceName, new LogServiceImpl(*_consumer));
+      }
     }
     catch (Miro::Exception const& e) {
       MIRO_LOG_OSTR(LL_CRITICAL, "Miro exception constructing LogNotifyConsumer:\n" << e.what());
@@ -111,6 +135,13 @@ namespace Miro
     MIRO_LOG(LL_NOTICE, "Miro::NotifyLogSvc::fini()");
 
     if (_consumer) {
+      if (Miro::LogNotifyParameters::instance()->flightRecorder) {
+        orbReactor()->remove_handler(SIGUSR1, (ACE_Sig_Action *) 0);
+        orbReactor()->purge_pending_notifications(this);
+      }
+      // the servant refers to the consumer
+      delete _server;
+      _server = NULL;
       _consumer->closeWriter();
       delete _consumer;
     }
@@ -121,6 +152,24 @@ namespace Miro
     return 0;
   }
 
+  int
+  NotifyLogSvc::handle_signal(int, siginfo_t *, ucontext_t *)
+  {
+    // writing the dump is not async signal safe
+    orbReactor()->notify(this);
+    return 0;
+  }
+
+  int
+  NotifyLogSvc::handle_exception(ACE_HANDLE)
+  {
+    if (_consumer) {
+      std::string const fileName = _consumer->dumpRecorder();
+      MIRO_LOG_OSTR(LL_NOTICE, "NotifyLogSvc - Dumping the flight recorder to " << fileName);
+    }
+    return 0;
+  }
+
   int
   NotifyLogSvc::parse_args(int& argc, char* argv[])
   {
@@ -133,6 +182,7 @@ namespace Miro
     // reset to default parameters
     *params = Miro::LogNotifyParameters();
     _fileName    = "";
+    _serviceName = "LogService";
     _verbose     = false;
 
     Miro::ConfigDocument * config = Miro::Configuration::document();
@@ -140,13 +190,16 @@ namespace Miro
     config->getParameters("Miro::LogNotifyParameters", *params);
 
     // initialize parameters from command line
-    ACE_Get_Opt get_opts(argc, argv, "n:v?");
+    ACE_Get_Opt get_opts(argc, argv, "n:s:v?");
 
     while ((c = get_opts()) != -1) {
       switch (c) {
         case 'n':
           _fileName = get_opts.optarg;
           break;
+        case 's':
+          _serviceName = get_opts.optarg;
+          break;
         case 'v':
           _verbose = true;
           break;
@@ -157,8 +210,9 @@ namespace Miro
     }
 
     if (rc) {
-      cerr << "usage: " << argv[0] << "[-n <file name> -v?]" << endl
+      cerr << "usage: " << argv[0] << "[-n <file name> -s <service name> -v?]" << endl
            << "  -n name of the log file to create" << endl
+           << "  -s name of the flight recorder control at the naming service (default: LogService)" << endl
            << "  -c <channel name> name of the event channel (default: NotifyEventChannel)" << endl
            << "  -v verbose mode" << endl
            << "  -MCF <filename.xml> Miro Configuration File specifying type_name list to record" << endl
@@ -47,6 +47,11 @@ namespace Miro
     virtual int init(int argc, ACE_TCHAR *argv[]);
     virtual int info(ACE_TCHAR **src, size_t len) const;
     virtual int fini();
+    //! SIGUSR1 requests a dump of the flight recorder.
+    /** The dump is deferred to the reactor of the ORB, out of the signal context. */
+    virtual int handle_signal(int signum, siginfo_t * = 0, ucontext_t * = 0);
+    //! Reactor notification: Dump the flight recorder.
+    virtual int handle_exception(ACE_HANDLE = ACE_INVALID_HANDLE);
 
   private:
     int parse_args(int& argc, char* argv[]);
@@ -55,6 +60,8 @@ namespace Miro
     Miro::LogNotifyConsumer * _consumer;
 
     std::string _fileName;
+    //! Name of the LogService object at the naming service.
+    std::string _serviceName;
     bool        _verbose;
 
     // hidden default copy dtor and assignement operator.
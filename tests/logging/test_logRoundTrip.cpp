@@ -0,0 +1,1299 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "PayloadC.h"
+
+#include "miro/LogWriter.h"
+#include "miro/LogEventQueue.h"
+#include "miro/LogReader.h"
+#include "miro/LogCursor.h"
+#include "miro/LogTypedReader.h"
+#include "miro/LogExtractor.h"
+#include "miro/LogFieldIndex.h"
+#include "miro/LogFieldIndexFile.h"
+#include "miro/LogColumnExporter.h"
+#include "miro/LogMerger.h"
+#include "miro/LogScanner.h"
+#include "miro/LogFlightRecorder.h"
+#include "miro/LogLiveFile.h"
+#include "miro/LogMergeTree.h"
+#include "miro/Parameters.h"
+#include "miro/StructuredPushSupplier.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <tao/ORB.h>
+#include <tao/CDR.h>
+
+#include <ace/OS_NS_unistd.h>
+#include <ace/OS_NS_string.h>
+#include <ace/OS_NS_sys_stat.h>
+
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Round trip of events through the LogWriter and the LogReader.
+//
+// Each payload is logged as a plain any and as the already marshalled
+// any the notification channel delivers: at both alignments of the
+// encoding and in foreign byte order. The encoded anys take the raw
+// copy path of the LogWriter, where byte order and alignment allow.
+// All of them have to read back equal to the original payload. The
+// second half of the events is logged in batches.
+//
+// The events are also read back by a reader following the log file,
+// while it is written, and from the log file of a writer, that was
+// never closed. And they are recorded by a flight recorder, that is
+// too small to hold all of them. Its dump has to hold the most recent
+// events.
+//
+// Rewritten in the layouts of format versions 5 and 4, with 32 bit
+// header slots, index and block index, or no index at all, the log
+// file has to read back the same events, sequentially as well as
+// through the index.
+//
+// The record views of a cursor over the log file, read ahead in small
+// windows, have to match the events, as have the events decoded on
+// demand.
+//
+// A typed reader has to demarshal the bodies of the one payload type
+// straight from the log file, skipping the events of other types.
+//
+// The field index of the filterable data, written along with the log
+// file as well as built offline, has to find the events by value and
+// by value range. So has a field index spilling its postings in tiny
+// chunks, with a tail of events dropped and indexed anew.
+//
+// The columnar export of the sample types, in one pass over the log
+// file, has to hold the time stamps, event numbers, values, strings
+// and sequence elements of the sample events, the sequences of samples
+// as a child table, and nothing of the other types. Recursive types
+// have to be flattened up to the first recursive reference, the
+// deeper levels skipped, but decoded.
+//
+// A time window of the log file, cut by copying the event records,
+// has to read back the events within the window, except for the
+// excluded event type. Also, if the type ids of the cut differ from
+// the ones of the log file.
+//
+// Merging copies of the log file, in more than one pass, has to read
+// back each event once per copy, in a row. The event index of the
+// merged log file, spilled by the writer in chunks of fewer events
+// than the log holds, has to point at the events.
+//
+// A parallel scan of the log file has to visit each event once and
+// reduce the ranges of events back into their original order.
+//
+// The time stamps of the events dealt round robin to a number of
+// streams have to merge back into their original order.
+
+namespace
+{
+  enum Encoding {
+    PLAIN, ENCODED, ENCODED_SHIFTED, ENCODED_SWAPPED
+  };
+
+  unsigned int const NUM_ENCODINGS = 4;
+
+  enum PayloadID {
+    OCTET_SEQ, SAMPLE, SAMPLE_SEQ, NO_PAYLOAD
+  };
+
+  unsigned int const NUM_PAYLOADS = 4;
+  char const * const payloadName[NUM_PAYLOADS] = {
+    "OctetSeq",
+    "Sample",
+    "SampleSeq",
+    "NoPayload"
+  };
+
+  unsigned int const ROUNDS = 50;
+  unsigned int const NUM_EVENTS = ROUNDS * NUM_PAYLOADS * NUM_ENCODINGS;
+  //! Number of events logged at once.
+  unsigned int const BATCH_SIZE = 13;
+
+  std::string const fileName = "test_logRoundTrip.mlog";
+  std::string const cutFileName = "test_logRoundTrip_cut.mlog";
+  std::string const fieldFileName = "test_logRoundTrip_fields.mlog";
+  std::string const legacyFileName = "test_logRoundTrip_legacy.mlog";
+  std::string const exportDirectory = "test_logRoundTrip_columns";
+  std::string const treeFileName = "test_logRoundTrip_tree.mlog";
+
+  //! Number of tree events.
+  unsigned int const NUM_TREES = 100;
+  //! Maximum depth of the trees.
+  unsigned int const TREE_DEPTH = 24;
+  int failures = 0;
+
+  void
+  fail(std::string const& _what, unsigned int _n)
+  {
+    std::cerr << "FAILED: " << _what << " (event " << _n << ")" << std::endl;
+    ++failures;
+  }
+
+  //! Time stamp of the event, a zero time stamp marks the end of the log.
+  ACE_Time_Value
+  stampOf(unsigned int _n)
+  {
+    return ACE_Time_Value(1 + _n);
+  }
+
+  test::Sample
+  produceSample(unsigned int _n)
+  {
+    test::Sample sample;
+    sample.flag = static_cast<CORBA::Octet>(_n);
+    sample.value = _n * 0.125;
+    sample.count = static_cast<CORBA::Short>(_n % 7);
+    sample.name = CORBA::string_dup((_n & 1)? "odd" : "even");
+    sample.data.length(_n % 5);
+    for (CORBA::ULong i = 0; i < sample.data.length(); ++i)
+      sample.data[i] = _n + i;
+    return sample;
+  }
+
+  bool
+  equal(test::Sample const& _a, test::Sample const& _b)
+  {
+    if (_a.flag != _b.flag ||
+        _a.value != _b.value ||
+        _a.count != _b.count ||
+        ACE_OS::strcmp(_a.name.in(), _b.name.in()) != 0 ||
+        _a.data.length() != _b.data.length())
+      return false;
+    for (CORBA::ULong i = 0; i < _a.data.length(); ++i)
+      if (_a.data[i] != _b.data[i])
+        return false;
+    return true;
+  }
+
+  //! A chain of _n % TREE_DEPTH nodes below the root, odd roots with a leaf as well.
+  test::Tree
+  produceTree(unsigned int _n, unsigned int _level)
+  {
+    bool const chain = _level < _n % TREE_DEPTH;
+    bool const leaf = _level == 0 && (_n & 1);
+
+    test::Tree tree;
+    tree.value = _n * 100 + _level;
+    tree.children.length((chain? 1 : 0) + (leaf? 1 : 0));
+    if (chain)
+      tree.children[0] = produceTree(_n, _level + 1);
+    if (leaf)
+      tree.children[tree.children.length() - 1].value = _n * 100 + 99;
+    return tree;
+  }
+
+  void
+  producePayload(PayloadID _payload, unsigned int _n, CORBA::Any& _any)
+  {
+    switch (_payload) {
+    case OCTET_SEQ:
+      {
+        test::OctetSeq * load = new test::OctetSeq;
+        load->length(997 + _n % 8);
+        for (CORBA::ULong i = 0; i < load->length(); ++i)
+          (*load)[i] = static_cast<CORBA::Octet>(i + _n);
+        _any <<= load;
+        break;
+      }
+    case SAMPLE:
+      _any <<= produceSample(_n);
+      break;
+    case SAMPLE_SEQ:
+      {
+        test::SampleSeq * load = new test::SampleSeq;
+        load->length(1 + _n % 3);
+        for (CORBA::ULong i = 0; i < load->length(); ++i)
+          (*load)[i] = produceSample(_n + i);
+        _any <<= load;
+        break;
+      }
+    case NO_PAYLOAD:
+      _any = CORBA::Any();
+      break;
+    }
+  }
+
+  bool
+  checkPayload(PayloadID _payload, unsigned int _n, CORBA::Any const& _any)
+  {
+    switch (_payload) {
+    case OCTET_SEQ:
+      {
+        test::OctetSeq const * load;
+        if (!(_any >>= load) ||
+            load->length() != 997 + _n % 8)
+          return false;
+        for (CORBA::ULong i = 0; i < load->length(); ++i)
+          if ((*load)[i] != static_cast<CORBA::Octet>(i + _n))
+            return false;
+        return true;
+      }
+    case SAMPLE:
+      {
+        test::Sample const * load;
+        return (_any >>= load) && equal(*load, produceSample(_n));
+      }
+    case SAMPLE_SEQ:
+      {
+        test::SampleSeq const * load;
+        if (!(_any >>= load) ||
+            load->length() != 1 + _n % 3)
+          return false;
+        for (CORBA::ULong i = 0; i < load->length(); ++i)
+          if (!equal((*load)[i], produceSample(_n + i)))
+            return false;
+        return true;
+      }
+    case NO_PAYLOAD:
+      {
+        CORBA::TypeCode_var tc = _any.type();
+        return tc->kind() == CORBA::tk_null;
+      }
+    }
+    return false;
+  }
+
+  //! Replace the any by its marshalled form, as delivered by the notification channel.
+  void
+  encode(Encoding _encoding, CORBA::Any& _any)
+  {
+    if (_encoding == PLAIN)
+      return;
+
+    TAO_OutputCDR ostr(static_cast<size_t>(0),
+                       (_encoding == ENCODED_SWAPPED)? !ACE_CDR_BYTE_ORDER : ACE_CDR_BYTE_ORDER);
+    // moves the encoded value by four bytes
+    if (_encoding == ENCODED_SHIFTED)
+      ostr.write_ulong(0);
+    ostr << _any;
+
+    TAO_InputCDR istr(ostr);
+    CORBA::ULong dummy;
+    if (_encoding == ENCODED_SHIFTED)
+      istr.read_ulong(dummy);
+    if (!(istr >> _any))
+      throw Miro::Exception("Error encoding the payload.");
+  }
+
+  void
+  produceEvent(unsigned int _n, CosNotification::StructuredEvent& _event)
+  {
+    PayloadID const payload = static_cast<PayloadID>((_n / NUM_ENCODINGS) % NUM_PAYLOADS);
+    Miro::StructuredPushSupplier::initStructuredEvent(_event, "Test", payloadName[payload]);
+    producePayload(payload, _n, _event.remainder_of_body);
+    encode(static_cast<Encoding>(_n % NUM_ENCODINGS), _event.remainder_of_body);
+  }
+
+  void
+  writeLog(bool _compress)
+  {
+    Miro::LogNotifyParameters parameters;
+    parameters.compress = _compress;
+    // many small blocks
+    parameters.blockSize = 4096;
+
+    Miro::LogWriter writer(fileName, parameters);
+    CosNotification::StructuredEvent event;
+    Miro::LogEventQueue::Buffer batch;
+
+    for (unsigned int n = 0; n < NUM_EVENTS; ++n) {
+      // the second half is logged in batches
+      if (n < NUM_EVENTS / 2) {
+        produceEvent(n, event);
+        if (!writer.logEvent(stampOf(n), event))
+          fail("logging the event", n);
+        continue;
+      }
+
+      batch.push_back(Miro::LogEventQueue::Entry());
+      batch.back().stamp = stampOf(n);
+      produceEvent(n, batch.back().event);
+      if (batch.size() == BATCH_SIZE || n + 1 == NUM_EVENTS) {
+        if (writer.logEvents(batch.begin(), batch.end()) != batch.end())
+          fail("logging the batch", n);
+        batch.clear();
+      }
+    }
+  }
+
+  unsigned int
+  recordLog()
+  {
+    Miro::LogNotifyParameters parameters;
+    // wraps around several times
+    parameters.ringSize = 64 * 1024;
+    parameters.ringDuration = ACE_Time_Value::zero;
+
+    Miro::LogFlightRecorder recorder(parameters);
+    CosNotification::StructuredEvent event;
+
+    for (unsigned int n = 0; n < NUM_EVENTS; ++n) {
+      produceEvent(n, event);
+      if (!recorder.logEvent(stampOf(n), event))
+        fail("recording the event", n);
+    }
+    if (recorder.events() == 0 || recorder.events() == NUM_EVENTS)
+      fail("number of recorded events", recorder.events());
+    if (recorder.size() > parameters.ringSize)
+      fail("size of the recorded events", recorder.size());
+
+    recorder.dump(fileName);
+    return NUM_EVENTS - recorder.events();
+  }
+
+  bool
+  readEvent(Miro::LogReader& _reader, ACE_Time_Value const& _stamp, unsigned int _n)
+  {
+    PayloadID const payload = static_cast<PayloadID>((_n / NUM_ENCODINGS) % NUM_PAYLOADS);
+    CosNotification::StructuredEvent event;
+
+    if (!_reader.parseEventHeader(event.header.fixed_header) ||
+        !_reader.parseEventBody(event)) {
+      fail("parsing the event", _n);
+      return false;
+    }
+    if (_stamp != stampOf(_n))
+      fail("time stamp", _n);
+    if (ACE_OS::strcmp(event.header.fixed_header.event_type.type_name.in(),
+                       payloadName[payload]) != 0)
+      fail("event type", _n);
+    if (!checkPayload(payload, _n, event.remainder_of_body))
+      fail(std::string("payload ") + payloadName[payload], _n);
+    return true;
+  }
+
+  void
+  readLog(bool _compress, unsigned int _first)
+  {
+    Miro::LogReader reader(fileName);
+    if (reader.compressed() != _compress)
+      fail("log file format", 0);
+    if (reader.events() != NUM_EVENTS - _first)
+      fail("number of events in the log file", reader.events());
+
+    ACE_Time_Value stamp;
+    unsigned int n = _first;
+    for (; n - _first < reader.events() && reader.parseTimeStamp(stamp); ++n) {
+      if (!readEvent(reader, stamp, n))
+        break;
+    }
+    if (n != NUM_EVENTS)
+      fail("number of events read back", n);
+  }
+
+  //! Append a value in host byte order.
+  template<class T>
+  void
+  appendValue(std::vector<char>& _file, T const& _value)
+  {
+    char const * const value = reinterpret_cast<char const *>(&_value);
+    _file.insert(_file.end(), value, value + sizeof(T));
+  }
+
+  //! Rewrite the log file in the layout of a former format version.
+  /**
+   * Version 5 has 32 bit header slots, index offsets and counts,
+   * version 4 has neither flags nor an index. The event records, event
+   * blocks and the type code repository are copied as they are, they
+   * keep their 8 byte alignment.
+   */
+  void
+  writeLegacyLog(unsigned short _version)
+  {
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    std::vector<char> const log((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+    // the event type table is demarshalled in place
+    std::vector<ACE_UINT64> aligned(log.size() / sizeof(ACE_UINT64) + 1);
+    ACE_OS::memcpy(&aligned[0], &log[0], log.size());
+    char const * const base = reinterpret_cast<char const *>(&aligned[0]);
+
+    // header slots of version 6, followed by flags and a reserved field
+    char const * slot = base + sizeof(Miro::LogHeader);
+    ACE_UINT64 tcrOffset;
+    ACE_UINT64 events;
+    ACE_UINT64 indexOffset;
+    ACE_UINT32 flags;
+    ACE_OS::memcpy(&tcrOffset, slot, sizeof(tcrOffset));
+    slot += sizeof(ACE_UINT64);
+    ACE_OS::memcpy(&events, slot, sizeof(events));
+    slot += sizeof(ACE_UINT64);
+    ACE_OS::memcpy(&indexOffset, slot, sizeof(indexOffset));
+    slot += sizeof(ACE_UINT64);
+    ACE_OS::memcpy(&flags, slot, sizeof(flags));
+    size_t const v6Events = (slot - base) + 2 * sizeof(ACE_UINT32);
+
+    Miro::LogHeader header((Miro::LogHeader::WRITE()));
+    header.version = _version;
+    bool const indexed = (_version >= Miro::LogHeader::INDEX_VERSION);
+
+    // the events move up by the narrower header slots
+    std::vector<char> file;
+    appendValue(file, header);
+    size_t const shift = v6Events - (sizeof(Miro::LogHeader) + 2 * sizeof(ACE_UINT32) +
+                                     ((indexed)? 2 * sizeof(ACE_UINT32) : 0));
+    appendValue(file, static_cast<ACE_UINT32>(tcrOffset - shift));
+    appendValue(file, static_cast<ACE_UINT32>(events));
+    if (indexed) {
+      appendValue(file, static_cast<ACE_UINT32>(indexOffset - shift));
+      appendValue(file, flags);
+    }
+
+    // events and type code repository
+    file.insert(file.end(), base + v6Events, base + indexOffset);
+
+    if (indexed) {
+      // event type table
+      TAO_InputCDR istr(base + indexOffset, log.size() - indexOffset);
+      CosNotification::EventTypeSeq types;
+      if (!(istr >> types))
+        fail("parsing the event type table", 0);
+      istr.align_read_ptr(ACE_CDR::LONGLONG_SIZE);
+      char const * pos = istr.rd_ptr();
+      file.insert(file.end(), base + indexOffset, pos);
+
+      // event index
+      bool const compressed = (flags & Miro::LogHeader::FLAG_COMPRESSED) != 0;
+      ACE_UINT64 count;
+      ACE_OS::memcpy(&count, pos, sizeof(count));
+      pos += sizeof(count);
+      appendValue(file, static_cast<ACE_UINT32>(count));
+      appendValue(file, ACE_UINT32(0));
+      for (ACE_UINT64 i = 0; i < count; ++i, pos += sizeof(Miro::LogHeader::IndexEntry)) {
+        Miro::LogHeader::IndexEntry entry;
+        ACE_OS::memcpy(&entry, pos, sizeof(entry));
+        // offsets within the uncompressed blocks stay
+        Miro::LogHeader::IndexEntryV5 v5 = {
+          entry.stamp,
+          static_cast<ACE_UINT32>((compressed)? entry.offset : entry.offset - shift),
+          entry.type
+        };
+        appendValue(file, v5);
+      }
+
+      // block index
+      if (compressed) {
+        pos = ACE_ptr_align_binary(pos, ACE_CDR::LONGLONG_SIZE);
+        ACE_OS::memcpy(&count, pos, sizeof(count));
+        pos += sizeof(count);
+        appendValue(file, static_cast<ACE_UINT32>(count));
+        appendValue(file, ACE_UINT32(0));
+        for (ACE_UINT64 i = 0; i < count; ++i, pos += sizeof(Miro::LogHeader::BlockEntry)) {
+          Miro::LogHeader::BlockEntry entry;
+          ACE_OS::memcpy(&entry, pos, sizeof(entry));
+          Miro::LogHeader::BlockEntryV5 v5 = {
+            entry.firstStamp,
+            entry.lastStamp,
+            static_cast<ACE_UINT32>(entry.offset - shift),
+            static_cast<ACE_UINT32>(entry.firstEvent)
+          };
+          appendValue(file, v5);
+        }
+      }
+    }
+
+    std::ofstream out(legacyFileName.c_str(), std::ios::binary);
+    out.write(&file[0], file.size());
+  }
+
+  void
+  legacyLog(bool _compress, unsigned short _version)
+  {
+    writeLegacyLog(_version);
+    {
+      Miro::LogReader reader(legacyFileName);
+      if (reader.version() != _version || reader.compressed() != _compress)
+        fail("legacy log file format", _version);
+      if (reader.events() != NUM_EVENTS)
+        fail("number of events in the legacy log file", reader.events());
+      if (reader.hasIndex() != (_version >= Miro::LogHeader::INDEX_VERSION))
+        fail("index of the legacy log file", _version);
+
+      ACE_Time_Value stamp;
+      unsigned int n = 0;
+      for (; n < reader.events() && reader.parseTimeStamp(stamp); ++n) {
+        if (!readEvent(reader, stamp, n))
+          break;
+      }
+      if (n != NUM_EVENTS)
+        fail("number of events read back from the legacy log file", n);
+
+      // the index entries and, for compressed log files, the blocks
+      for (n = 0; reader.hasIndex() && n < NUM_EVENTS; n += 7) {
+        reader.seekEvent(n);
+        if (reader.eof() ||
+            !readEvent(reader, reader.indexTime(n), n))
+          fail("seeking the legacy index", n);
+      }
+    }
+    ACE_OS::unlink(legacyFileName.c_str());
+  }
+
+  void
+  cursorLog()
+  {
+    Miro::LogReader reader(fileName);
+    // renews the readahead window many times
+    reader.access(Miro::LogReader::SEQUENTIAL);
+    reader.readAheadSize(4096);
+    Miro::LogCursor cursor(reader);
+    CosNotification::StructuredEvent event;
+
+    unsigned int n = 0;
+    for (; cursor.next(); ++n) {
+      PayloadID const payload = static_cast<PayloadID>((n / NUM_ENCODINGS) % NUM_PAYLOADS);
+      Miro::LogRecord const& record = cursor.record();
+      if (record.stamp != stampOf(n) || cursor.number() != n)
+        fail("time stamp of the record", n);
+      if (ACE_OS::strcmp(record.domainName.data, "Test") != 0 ||
+          record.typeName.length != ACE_OS::strlen(payloadName[payload]) ||
+          ACE_OS::strcmp(record.typeName.data, payloadName[payload]) != 0)
+        fail("event type of the record", n);
+      if ((record.typeId < 0) != (payload == NO_PAYLOAD) ||
+          record.body + record.bodyLength != record.data + record.length)
+        fail("body of the record", n);
+
+      // some events are decoded
+      if (n % 7 == 0 &&
+          (!cursor.decode(event) ||
+           !checkPayload(payload, n, event.remainder_of_body)))
+        fail("decoding the record", n);
+    }
+    if (n != NUM_EVENTS)
+      fail("number of records", n);
+
+    // back to an indexed event
+    unsigned int const middle = NUM_EVENTS / 2;
+    if (!cursor.seek(middle) || !cursor.next() ||
+        cursor.record().stamp != stampOf(middle))
+      fail("seeking the record", middle);
+  }
+
+  void
+  typedLog()
+  {
+    Miro::LogReader reader(fileName);
+    Miro::LogTypedReader<test::Sample> samples(reader, test::_tc_Sample);
+
+    unsigned int n = 0;
+    unsigned int events = 0;
+    for (; samples.next(); ++n, ++events) {
+      // the next sample payload
+      while (n < NUM_EVENTS && (n / NUM_ENCODINGS) % NUM_PAYLOADS != SAMPLE)
+        ++n;
+      if (samples.stamp() != stampOf(n) ||
+          !equal(samples.value(), produceSample(n)))
+        fail("typed sample", n);
+    }
+    if (events != NUM_EVENTS / NUM_PAYLOADS)
+      fail("number of typed samples", events);
+
+    // no events of that domain
+    Miro::LogReader other(fileName);
+    Miro::LogTypedReader<test::Sample> none(other, test::_tc_Sample, "", "Other");
+    if (none.next())
+      fail("filtering typed samples", none.cursor().number());
+  }
+
+  //! The events n with n % _modulo within [_first, _last] have to be found.
+  void
+  checkFieldQuery(std::string const& _what, std::vector<ACE_UINT32> const& _events,
+                  unsigned int _modulo, unsigned int _first, unsigned int _last)
+  {
+    unsigned int n = 0;
+    std::vector<ACE_UINT32>::const_iterator event = _events.begin();
+    for (; n < NUM_EVENTS; ++n) {
+      if (n % _modulo < _first || n % _modulo > _last)
+        continue;
+      if (event == _events.end() || *event != n) {
+        fail(_what, n);
+        return;
+      }
+      ++event;
+    }
+    if (event != _events.end())
+      fail(_what, *event);
+  }
+
+  void
+  fieldIndexLog(bool _compress)
+  {
+    std::vector<std::string> fields;
+    fields.push_back("robot");
+    fields.push_back("severity");
+    {
+      Miro::LogNotifyParameters parameters;
+      parameters.compress = _compress;
+      parameters.indexField = fields;
+      Miro::LogWriter writer(fieldFileName, parameters);
+      CosNotification::StructuredEvent event;
+
+      for (unsigned int n = 0; n < NUM_EVENTS; ++n) {
+        produceEvent(n, event);
+        event.filterable_data.length(3);
+        event.filterable_data[0].name = CORBA::string_dup("robot");
+        event.filterable_data[0].value <<= (n % 3 == 0)? "k10a" : "k10b";
+        event.filterable_data[1].name = CORBA::string_dup("severity");
+        event.filterable_data[1].value <<= CORBA::Short(n % 5);
+        event.filterable_data[2].name = CORBA::string_dup("sequence");
+        event.filterable_data[2].value <<= CORBA::ULong(n);
+        if (!writer.logEvent(stampOf(n), event))
+          fail("logging the event with filterable data", n);
+      }
+    }
+
+    std::vector<ACE_UINT32> events;
+    {
+      Miro::LogReader reader(fieldFileName);
+      if (!reader.hasFieldIndex("robot") || !reader.hasFieldIndex("severity") ||
+          reader.hasFieldIndex("sequence"))
+        fail("fields of the field index", 0);
+
+      reader.findEvents("robot", "k10a", events);
+      checkFieldQuery("field index value query", events, 3, 0, 0);
+      if (reader.findEvents("robot", "k10", events) != 0)
+        fail("field index query of an unknown value", 0);
+      reader.findEvents("severity", 3, 10, events);
+      checkFieldQuery("field index range query", events, 5, 3, 4);
+    }
+
+    // offline indexing
+    ACE_OS::unlink(Miro::LogFieldIndexFile::fileName(fieldFileName).c_str());
+    fields.pop_back();
+    if (!Miro::LogFieldIndexFile::build(fieldFileName, fields) ||
+        Miro::LogFieldIndexFile::build(fieldFileName, fields))
+      fail("building the field index", 0);
+    {
+      Miro::LogReader reader(fieldFileName);
+      if (reader.hasFieldIndex("severity"))
+        fail("fields of the built field index", 0);
+      reader.findEvents("robot", "k10b", events);
+      checkFieldQuery("built field index value query", events, 3, 1, 2);
+    }
+
+    // spilled postings, reading back the spilled ones of the dropped events
+    fields.push_back("severity");
+    {
+      Miro::LogReader reader(fieldFileName);
+      Miro::LogFieldIndex index(fields, 7);
+      {
+        Miro::LogCursor cursor(reader);
+        while (cursor.next() && cursor.number() < NUM_EVENTS * 3 / 4)
+          index.add(cursor.number(), cursor.filterableData());
+      }
+      index.truncate(NUM_EVENTS / 2);
+      Miro::LogCursor cursor(reader);
+      while (cursor.next()) {
+        if (cursor.number() >= NUM_EVENTS / 2)
+          index.add(cursor.number(), cursor.filterableData());
+      }
+      if (index.spilled() == 0 || index.size() != 2 * NUM_EVENTS)
+        fail("spilling the field index", index.size());
+      Miro::LogFieldIndexFile::write(fieldFileName, reader.events(), index);
+    }
+    {
+      Miro::LogReader reader(fieldFileName);
+      reader.findEvents("robot", "k10a", events);
+      checkFieldQuery("spilled field index value query", events, 3, 0, 0);
+      reader.findEvents("severity", 2.5, 3.5, events);
+      checkFieldQuery("spilled field index range query", events, 5, 3, 3);
+    }
+
+    ACE_OS::unlink(Miro::LogFieldIndexFile::fileName(fieldFileName).c_str());
+    ACE_OS::unlink(fieldFileName.c_str());
+  }
+
+  //! Contents of the column file of the exported type.
+  std::vector<char>
+  readColumn(Miro::LogColumnExporter const& _exporter, ACE_INT32 _typeId,
+             std::string const& _name, Miro::LogColumnPlan::ColumnKind _kind)
+  {
+    std::vector<char> data;
+    Miro::LogColumnPlan::ColumnVector const& columns = _exporter.plan(_typeId)->columns();
+    for (unsigned int i = 0; i < columns.size(); ++i) {
+      if (columns[i].name == _name && columns[i].kind == _kind) {
+        std::string const name = exportDirectory + "/" + _exporter.typeDirectory(_typeId) +
+          "/" + Miro::LogColumnExporter::columnFile(i);
+        std::ifstream file(name.c_str(), std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return data;
+      }
+    }
+    fail("exported column " + _name, 0);
+    return data;
+  }
+
+  template<class T>
+  T
+  columnValue(std::vector<char> const& _column, ACE_UINT64 _row)
+  {
+    T value;
+    ACE_OS::memcpy(&value, &_column[_row * sizeof(T)], sizeof(T));
+    return value;
+  }
+
+  //! Type id of the plan equivalent to the type code, -1 if there is none.
+  ACE_INT32
+  exportedType(Miro::LogColumnExporter const& _exporter, CORBA::TypeCode_ptr _type)
+  {
+    for (ACE_INT32 id = 0; id < _exporter.types(); ++id) {
+      if (_exporter.plan(id) != NULL &&
+          _exporter.plan(id)->type()->equivalent(_type))
+        return id;
+    }
+    return -1;
+  }
+
+  //! Remove the column files and the schema of the exported type.
+  void
+  removeExport(Miro::LogColumnExporter const& _exporter, ACE_INT32 _typeId)
+  {
+    std::string const directory = exportDirectory + "/" + _exporter.typeDirectory(_typeId);
+    for (unsigned int i = 0; i < _exporter.plan(_typeId)->columns().size(); ++i)
+      ACE_OS::unlink((directory + "/" + Miro::LogColumnExporter::columnFile(i)).c_str());
+    ACE_OS::unlink((directory + "/schema.json").c_str());
+    ACE_OS::rmdir(directory.c_str());
+  }
+
+  //! The sample sequences, flattened into a child table of samples.
+  void
+  checkSampleSeqColumns(Miro::LogColumnExporter const& _exporter, ACE_INT32 _typeId)
+  {
+    typedef Miro::LogColumnPlan Plan;
+    std::vector<char> const offsets = readColumn(_exporter, _typeId, "value", Plan::OFFSETS);
+    std::vector<char> const values = readColumn(_exporter, _typeId, "value[].value", Plan::VALUE);
+    std::vector<char> const dataOffsets = readColumn(_exporter, _typeId, "value[].data", Plan::OFFSETS);
+    std::vector<char> const data = readColumn(_exporter, _typeId, "value[].data[]", Plan::VALUE);
+
+    ACE_UINT64 row = 0;
+    ACE_UINT64 element = 0;
+    ACE_UINT64 datum = 0;
+    for (unsigned int n = 0; n < NUM_EVENTS; ++n) {
+      if ((n / NUM_ENCODINGS) % NUM_PAYLOADS != SAMPLE_SEQ)
+        continue;
+
+      CORBA::ULong const length = 1 + n % 3;
+      if ((row + 1) * sizeof(ACE_UINT64) > offsets.size() ||
+          columnValue<ACE_UINT64>(offsets, row) != element + length ||
+          (element + length) * sizeof(CORBA::Double) > values.size() ||
+          (element + length) * sizeof(ACE_UINT64) > dataOffsets.size()) {
+        fail("exported sample sequence", n);
+        return;
+      }
+
+      for (CORBA::ULong i = 0; i < length; ++i, ++element) {
+        test::Sample const s = produceSample(n + i);
+        ACE_UINT64 const dataEnd = columnValue<ACE_UINT64>(dataOffsets, element);
+        if (columnValue<CORBA::Double>(values, element) != s.value ||
+            dataEnd != datum + s.data.length() ||
+            dataEnd * sizeof(CORBA::Long) > data.size()) {
+          fail("exported sample sequence element", n);
+          return;
+        }
+        for (; datum < dataEnd; ++datum)
+          if (columnValue<CORBA::Long>(data, datum) != s.data[static_cast<CORBA::ULong>(datum + s.data.length() - dataEnd)])
+            fail("exported sample sequence data", n);
+      }
+      ++row;
+    }
+
+    if (row * sizeof(ACE_UINT64) != offsets.size() ||
+        element * sizeof(CORBA::Double) != values.size() ||
+        datum * sizeof(CORBA::Long) != data.size())
+      fail("rows of the exported sample sequences", row);
+  }
+
+  void
+  exportLog()
+  {
+    Miro::LogColumnExporter exporter(fileName);
+    exporter.select("Sample");
+    exporter.select("SampleSeq");
+
+    ACE_INT32 const sample = exportedType(exporter, test::_tc_Sample);
+    ACE_INT32 const sampleSeq = exportedType(exporter, test::_tc_SampleSeq);
+    if (sample < 0 || sampleSeq < 0) {
+      fail("plan of the sample types", 0);
+      return;
+    }
+
+    // both types in one pass
+    unsigned int const rows = NUM_EVENTS / NUM_PAYLOADS;
+    if (exporter.exportTypes(exportDirectory, 1) != 2 * rows)
+      fail("number of exported samples", 0);
+
+    typedef Miro::LogColumnPlan Plan;
+    std::vector<char> const stamps = readColumn(exporter, sample, "_stamp", Plan::VALUE);
+    std::vector<char> const events = readColumn(exporter, sample, "_event", Plan::VALUE);
+    std::vector<char> const values = readColumn(exporter, sample, "value", Plan::VALUE);
+    std::vector<char> const names = readColumn(exporter, sample, "name", Plan::STRING);
+    std::vector<char> const chars = readColumn(exporter, sample, "name", Plan::CHARS);
+    std::vector<char> const offsets = readColumn(exporter, sample, "data", Plan::OFFSETS);
+    std::vector<char> const data = readColumn(exporter, sample, "data[]", Plan::VALUE);
+
+    if (stamps.size() != rows * sizeof(ACE_INT64) ||
+        events.size() != rows * sizeof(ACE_UINT32) ||
+        values.size() != rows * sizeof(CORBA::Double) ||
+        names.size() != rows * sizeof(ACE_UINT64) ||
+        offsets.size() != rows * sizeof(ACE_UINT64)) {
+      fail("size of the exported columns", events.size());
+    }
+    else {
+      ACE_UINT64 row = 0;
+      ACE_UINT64 name = 0;
+      ACE_UINT64 element = 0;
+      for (unsigned int n = 0; n < NUM_EVENTS; ++n) {
+        if ((n / NUM_ENCODINGS) % NUM_PAYLOADS != SAMPLE)
+          continue;
+
+        test::Sample const s = produceSample(n);
+        ACE_UINT64 const nameEnd = columnValue<ACE_UINT64>(names, row);
+        ACE_UINT64 const dataEnd = columnValue<ACE_UINT64>(offsets, row);
+        if (columnValue<ACE_INT64>(stamps, row) != stampOf(n).sec() * 1000000 ||
+            columnValue<ACE_UINT32>(events, row) != n ||
+            columnValue<CORBA::Double>(values, row) != s.value)
+          fail("exported sample", n);
+        if (nameEnd > chars.size() ||
+            std::string(&chars[0] + name, &chars[0] + nameEnd) != s.name.in())
+          fail("exported sample name", n);
+        if (dataEnd != element + s.data.length() || dataEnd * sizeof(CORBA::Long) > data.size())
+          fail("exported sample data", n);
+        else {
+          for (CORBA::ULong i = 0; i < s.data.length(); ++i)
+            if (columnValue<CORBA::Long>(data, element + i) != s.data[i])
+              fail("exported sample data element", n);
+        }
+        name = nameEnd;
+        element = dataEnd;
+        ++row;
+      }
+    }
+
+    checkSampleSeqColumns(exporter, sampleSeq);
+
+    // only the selected types are exported
+    for (ACE_INT32 id = 0; id < exporter.types(); ++id) {
+      std::string const directory = exportDirectory + "/" + exporter.typeDirectory(id);
+      if ((ACE_OS::access((directory + "/schema.json").c_str(), F_OK) == 0) !=
+          (id == sample || id == sampleSeq))
+        fail("exported types", id);
+    }
+
+    removeExport(exporter, sample);
+    removeExport(exporter, sampleSeq);
+
+    ACE_OS::rmdir(exportDirectory.c_str());
+  }
+
+  //! The columnar export of a recursive type, interleaved with samples.
+  void
+  exportTree()
+  {
+    {
+      Miro::LogNotifyParameters parameters;
+      Miro::LogWriter writer(treeFileName, parameters);
+      CosNotification::StructuredEvent event;
+
+      for (unsigned int n = 0; n < NUM_TREES; ++n) {
+        Miro::StructuredPushSupplier::initStructuredEvent(event, "Test", "Tree");
+        event.remainder_of_body <<= produceTree(n, 0);
+        if (!writer.logEvent(stampOf(2 * n), event))
+          fail("logging the tree", 2 * n);
+
+        Miro::StructuredPushSupplier::initStructuredEvent(event, "Test", "Sample");
+        event.remainder_of_body <<= produceSample(n);
+        if (!writer.logEvent(stampOf(2 * n + 1), event))
+          fail("logging the sample", 2 * n + 1);
+      }
+    }
+
+    Miro::LogColumnExporter exporter(treeFileName);
+    ACE_INT32 const tree = exportedType(exporter, test::_tc_Tree);
+    ACE_INT32 const sample = exportedType(exporter, test::_tc_Sample);
+    if (tree < 0 || sample < 0) {
+      fail("plan of the tree type", 0);
+      ACE_OS::unlink(treeFileName.c_str());
+      return;
+    }
+
+    // the recursive references are skipped, but still decoded
+    Miro::LogColumnPlan const& plan = *exporter.plan(tree);
+    if (plan.tables().size() != 2 ||
+        plan.skipped().size() != 1 || plan.skipped()[0] != "children[]")
+      fail("flattened levels of the tree", plan.tables().size());
+
+    // a table per recursive member, not per path
+    Miro::LogColumnPlan const node(test::_tc_Node);
+    if (node.tables().size() != 3 || node.skipped().size() != 2)
+      fail("flattened levels of the node", node.tables().size());
+
+    // a worker per type
+    if (exporter.exportTypes(exportDirectory, 2) != 2 * NUM_TREES)
+      fail("number of exported trees", 0);
+
+    typedef Miro::LogColumnPlan Plan;
+    std::vector<char> const events = readColumn(exporter, tree, "_event", Plan::VALUE);
+    std::vector<char> const values = readColumn(exporter, tree, "value", Plan::VALUE);
+    std::vector<char> const offsets = readColumn(exporter, tree, "children", Plan::OFFSETS);
+
+    if (events.size() != NUM_TREES * sizeof(ACE_UINT32) ||
+        values.size() != NUM_TREES * sizeof(CORBA::Long) ||
+        offsets.size() != NUM_TREES * sizeof(ACE_UINT64)) {
+      fail("size of the exported tree columns", events.size());
+    }
+    else {
+      ACE_UINT64 child = 0;
+      for (unsigned int n = 0; n < NUM_TREES; ++n) {
+        test::Tree const t = produceTree(n, 0);
+        child += t.children.length();
+        if (columnValue<ACE_UINT32>(events, n) != 2 * n ||
+            columnValue<CORBA::Long>(values, n) != t.value ||
+            columnValue<ACE_UINT64>(offsets, n) != child)
+          fail("exported tree", n);
+      }
+    }
+
+    removeExport(exporter, tree);
+    removeExport(exporter, sample);
+    ACE_OS::rmdir(exportDirectory.c_str());
+    ACE_OS::unlink(treeFileName.c_str());
+  }
+
+  void
+  extractLog(bool _translate)
+  {
+    unsigned int const first = NUM_EVENTS / 4;
+    unsigned int const last = 3 * NUM_EVENTS / 4;
+    {
+      Miro::LogReader reader(fileName);
+      Miro::LogWriter writer(cutFileName);
+
+      if (_translate) {
+        // takes the first type id of the cut
+        CosNotification::StructuredEvent event;
+        Miro::StructuredPushSupplier::initStructuredEvent(event, "Test", "Other");
+        event.remainder_of_body <<= CORBA::ULong(first);
+        writer.logEvent(stampOf(first), event);
+      }
+
+      Miro::LogExtractor extractor(reader, writer);
+      if (!extractor.raw() || extractor.identity() == _translate)
+        fail("copying the event records", 0);
+      extractor.exclude("Test", payloadName[NO_PAYLOAD]);
+      extractor.extract(stampOf(first), stampOf(last));
+    }
+
+    Miro::LogReader reader(cutFileName);
+    ACE_Time_Value stamp;
+    if (_translate) {
+      CosNotification::StructuredEvent event;
+      CORBA::ULong load;
+      if (!reader.parseTimeStamp(stamp) ||
+          !reader.parseEventHeader(event.header.fixed_header) ||
+          !reader.parseEventBody(event) ||
+          !(event.remainder_of_body >>= load) || load != first)
+        fail("reading the event ahead of the cut", first);
+    }
+
+    unsigned int n = first;
+    for (; n <= last; ++n) {
+      if ((n / NUM_ENCODINGS) % NUM_PAYLOADS == NO_PAYLOAD)
+        continue;
+      if (!reader.parseTimeStamp(stamp) || !readEvent(reader, stamp, n))
+        break;
+    }
+    if (n != last + 1 || reader.parseTimeStamp(stamp))
+      fail("number of events in the cut", n);
+
+    ACE_OS::unlink(cutFileName.c_str());
+  }
+
+  void
+  mergeLog(unsigned int _copies)
+  {
+    Miro::LogMerger::FileVector files(_copies, fileName);
+    Miro::LogNotifyParameters parameters;
+    parameters.indexChunkSize = NUM_EVENTS / 7;
+    Miro::LogMerger merger(files, 2, parameters);
+    if (merger.merge(cutFileName) != _copies * NUM_EVENTS)
+      fail("number of merged events", 0);
+    if (merger.passes() < 2)
+      fail("number of merge passes", merger.passes());
+
+    Miro::LogReader reader(cutFileName);
+    if (!reader.hasIndex() || reader.indexSize() != _copies * NUM_EVENTS)
+      fail("size of the merged event index", reader.indexSize());
+    ACE_Time_Value stamp;
+    unsigned int n = 0;
+    for (; n < _copies * NUM_EVENTS; ++n) {
+      if (!reader.parseTimeStamp(stamp))
+        break;
+      if (reader.hasIndex() && n < reader.indexSize() &&
+          (reader.indexTime(n) != stamp ||
+           reader.indexEvent(n) != reader.rdPtr() - sizeof(TimeBase::TimeT)))
+        fail("merged event index", n);
+      if (!readEvent(reader, stamp, n / _copies))
+        break;
+    }
+    if (n != _copies * NUM_EVENTS || reader.parseTimeStamp(stamp))
+      fail("number of events read back", n);
+
+    ACE_OS::unlink(cutFileName.c_str());
+  }
+
+  //! Collects the time stamps of the events, checks their payload.
+  class ScanReducer : public Miro::LogScanReducer
+  {
+  public:
+    ScanReducer() : bad(0) {}
+
+    virtual Miro::LogScanReducer * clone() const
+    {
+      return new ScanReducer();
+    }
+
+    virtual void event(unsigned int,
+                       ACE_Time_Value const& _stamp, size_t _length,
+                       CosNotification::EventType const& _type,
+                       CosNotification::StructuredEvent const * _event)
+    {
+      unsigned int const n = _stamp.sec() - 1;
+      PayloadID const payload = static_cast<PayloadID>((n / NUM_ENCODINGS) % NUM_PAYLOADS);
+      if (_length == 0 ||
+          ACE_OS::strcmp(_type.type_name.in(), payloadName[payload]) != 0 ||
+          (_event != NULL && !checkPayload(payload, n, _event->remainder_of_body)))
+        ++bad;
+      stamps.push_back(_stamp);
+    }
+
+    virtual void reduce(Miro::LogScanReducer const& _next)
+    {
+      ScanReducer const& next = static_cast<ScanReducer const&>(_next);
+      stamps.insert(stamps.end(), next.stamps.begin(), next.stamps.end());
+      bad += next.bad;
+    }
+
+    std::vector<ACE_Time_Value> stamps;
+    unsigned int bad;
+  };
+
+  void
+  scanLog(bool _bodies)
+  {
+    Miro::LogScanner::FileVector files(1, fileName);
+    Miro::LogScanner scanner(files, _bodies, 64);
+    if (scanner.events() != NUM_EVENTS || scanner.ranges() < 2)
+      fail("partitioning the log file", scanner.ranges());
+
+    ScanReducer reducer;
+    scanner.scan(reducer, 4);
+    if (reducer.bad != 0)
+      fail("events visited by the scan", reducer.bad);
+    if (reducer.stamps.size() != NUM_EVENTS)
+      fail("number of events scanned", reducer.stamps.size());
+    for (unsigned int n = 0; n < reducer.stamps.size(); ++n) {
+      if (reducer.stamps[n] != stampOf(n)) {
+        fail("order of the scanned events", n);
+        break;
+      }
+    }
+  }
+
+  void
+  tailLog()
+  {
+    Miro::LogNotifyParameters parameters;
+    parameters.liveTail = true;
+    // the reader has to follow the growing file
+    parameters.extentSize = 4096;
+
+    Miro::LogWriter * writer = new Miro::LogWriter(fileName, parameters);
+    Miro::LogReader reader(fileName);
+    if (!reader.live() || reader.events() != 0)
+      fail("opening the live log file", reader.events());
+
+    ACE_Time_Value stamp;
+    CosNotification::StructuredEvent event;
+    CORBA::TypeCode_ptr firstType = CORBA::_tc_null;
+    unsigned int n = 0;
+    unsigned int logged = 0;
+    while (logged < NUM_EVENTS) {
+      // the writer runs one round ahead
+      for (unsigned int i = 0; i < NUM_PAYLOADS * NUM_ENCODINGS; ++i, ++logged) {
+        produceEvent(logged, event);
+        if (!writer->logEvent(stampOf(logged), event))
+          fail("logging the event", logged);
+        // the type codes get published one by one
+        if (logged < NUM_PAYLOADS * NUM_ENCODINGS) {
+          reader.update();
+          if (firstType == CORBA::_tc_null)
+            firstType = reader.typeCode(0);
+        }
+      }
+      if (reader.typeCode(0) != firstType)
+        fail("type codes of the live log file", logged);
+
+      if (reader.update() != logged)
+        fail("number of published events", reader.events());
+      for (; n < reader.events() && reader.parseTimeStamp(stamp); ++n) {
+        if (!readEvent(reader, stamp, n))
+          break;
+      }
+      // the reader waits for the writer
+      if (n != logged || reader.parseTimeStamp(stamp) || reader.eof())
+        fail("end of the published events", n);
+    }
+
+    delete writer;
+    reader.update();
+    if (reader.live() || reader.events() != NUM_EVENTS)
+      fail("closing the live log file", reader.events());
+    if (reader.parseTimeStamp(stamp) || !reader.eof())
+      fail("end of the closed log file", n);
+    if (ACE_OS::access(Miro::LogLiveFile::fileName(fileName).c_str(), F_OK) == 0)
+      fail("removing the live file", n);
+  }
+
+  void
+  crashLog()
+  {
+    // the default parameters keep a live file
+    Miro::LogNotifyParameters parameters;
+
+    // never finalized, as by a crashed logger
+    Miro::LogWriter * writer = new Miro::LogWriter(fileName, parameters);
+    CosNotification::StructuredEvent event;
+    for (unsigned int n = 0; n < NUM_EVENTS; ++n) {
+      produceEvent(n, event);
+      if (!writer->logEvent(stampOf(n), event))
+        fail("logging the event", n);
+    }
+
+    Miro::LogReader reader(fileName);
+    if (!reader.live() || reader.events() != NUM_EVENTS)
+      fail("opening the log file of a crashed writer", reader.events());
+
+    ACE_Time_Value stamp;
+    unsigned int n = 0;
+    for (; n < NUM_EVENTS && reader.parseTimeStamp(stamp); ++n) {
+      if (!readEvent(reader, stamp, n))
+        break;
+    }
+    if (n != NUM_EVENTS)
+      fail("events of the crashed writer", n);
+
+    ACE_OS::unlink(Miro::LogLiveFile::fileName(fileName).c_str());
+  }
+
+  void
+  mergeStamps(unsigned int _streams)
+  {
+    // stream i holds the events i, i + _streams, ...
+    std::vector<ACE_Time_Value> keys(_streams, ACE_Time_Value::max_time);
+    for (unsigned int i = 0; i < _streams && i < NUM_EVENTS; ++i)
+      keys[i] = stampOf(i);
+
+    Miro::LogMergeTree<ACE_Time_Value> tree(keys);
+    unsigned int n = 0;
+    for (; tree.topKey() != ACE_Time_Value::max_time; ++n) {
+      unsigned int const stream = tree.top();
+      if (tree.topKey() != stampOf(n) || stream != n % _streams)
+        fail("merge order", n);
+      unsigned int const next = n + _streams;
+      tree.pop((next < NUM_EVENTS)? stampOf(next) : ACE_Time_Value::max_time);
+    }
+    if (n != NUM_EVENTS)
+      fail("number of events merged", n);
+  }
+}
+
+int
+main(int argc, char * argv[])
+{
+  try {
+    Miro::Log::init(argc, argv);
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    for (unsigned int i = 0; i < 2; ++i) {
+      bool const compress = (i == 1);
+      std::cout << "Round trip of the " << ((compress)? "compressed" : "raw")
+                << " log file format" << std::endl;
+
+      writeLog(compress);
+      readLog(compress, 0);
+      legacyLog(compress, Miro::LogHeader::INDEX_VERSION);
+      if (!compress)
+        legacyLog(compress, Miro::LogHeader::INDEX_VERSION - 1);
+      cursorLog();
+      typedLog();
+      fieldIndexLog(compress);
+      exportLog();
+      extractLog(false);
+      extractLog(true);
+      mergeLog(3);
+      scanLog(false);
+      scanLog(true);
+      ACE_OS::unlink(fileName.c_str());
+    }
+
+    std::cout << "Columnar export of a recursive type" << std::endl;
+    exportTree();
+
+    std::cout << "Round trip through a live log file" << std::endl;
+    tailLog();
+    readLog(false, 0);
+    ACE_OS::unlink(fileName.c_str());
+
+    std::cout << "Reading the log file of a crashed writer" << std::endl;
+    crashLog();
+    ACE_OS::unlink(fileName.c_str());
+
+    std::cout << "Round trip through the flight recorder" << std::endl;
+    readLog(false, recordLog());
+    ACE_OS::unlink(fileName.c_str());
+
+    std::cout << "Merging the event time stamps of multiple streams" << std::endl;
+    for (unsigned int streams = 1; streams <= 9; streams += 4)
+      mergeStamps(streams);
+
+    orb->destroy();
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncought CORBA exception:\n" << e << std::endl;
+    return 1;
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Uncought Miro exception:\n" << e << std::endl;
+    return 1;
+  }
+
+  if (failures != 0) {
+    std::cerr << failures << " failures." << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
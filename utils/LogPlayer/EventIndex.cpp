@@ -0,0 +1,206 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "EventIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  ACE_UINT64
+  toUsec(ACE_Time_Value const& _stamp)
+  {
+    return static_cast<ACE_UINT64>(_stamp.sec()) * 1000000 + _stamp.usec();
+  }
+}
+
+EventIndex::EventIndex() :
+  lastMinStamp_(0),
+  lastMaxStamp_(0),
+  size_(0)
+{}
+
+EventIndex::~EventIndex()
+{
+  clear();
+}
+
+void
+EventIndex::reserve(unsigned int _events)
+{
+  blocks_.reserve((_events + BLOCK_SIZE - 1) / BLOCK_SIZE);
+  last_.reserve(BLOCK_SIZE);
+}
+
+void
+EventIndex::push_back(ACE_Time_Value const& _stamp, ACE_UINT64 _offset,
+                      ACE_UINT16 _type)
+{
+  ACE_UINT64 const t = toUsec(_stamp);
+
+  if (last_.empty()) {
+    lastMinStamp_ = t;
+    lastMaxStamp_ = t;
+  }
+  if (t < lastMinStamp_)
+    lastMinStamp_ = t;
+  if (t > lastMaxStamp_)
+    lastMaxStamp_ = t;
+
+  Entry const entry = { t, _offset, _type };
+  last_.push_back(entry);
+  ++size_;
+
+  if (last_.size() == BLOCK_SIZE)
+    pack();
+}
+
+void
+EventIndex::pack()
+{
+  // frame of reference: deltas to the smallest values of the block
+  Block block;
+  block.minStamp = lastMinStamp_;
+  block.maxStamp = lastMaxStamp_;
+  block.offset = last_.front().offset;
+  ACE_UINT64 maxOffset = block.offset;
+  ACE_UINT16 maxType = 0;
+  EntryVector::const_iterator first, last = last_.end();
+  for (first = last_.begin(); first != last; ++first) {
+    block.offset = std::min(block.offset, first->offset);
+    maxOffset = std::max(maxOffset, first->offset);
+    maxType = std::max(maxType, first->type);
+  }
+  block.stampBits = width(block.maxStamp - block.minStamp);
+  block.offsetBits = width(maxOffset - block.offset);
+  block.typeBits = width(maxType);
+
+  unsigned int const recordBits = block.stampBits + block.offsetBits + block.typeBits;
+  unsigned int const words = (recordBits * BLOCK_SIZE + 63) / 64 + 1;
+  block.bits = new ACE_UINT64[words];
+  memset(block.bits, 0, words * sizeof(ACE_UINT64));
+
+  unsigned int index = blocks_.size() * BLOCK_SIZE;
+  unsigned int pos = 0;
+  for (first = last_.begin(); first != last; ++first, ++index) {
+    ACE_UINT64 stampDelta = first->stamp - block.minStamp;
+    if (stampDelta >= ESCAPE) {
+      stampEscapes_.insert(std::make_pair(index, first->stamp));
+      stampDelta = ESCAPE;
+    }
+    ACE_UINT64 offsetDelta = first->offset - block.offset;
+    if (offsetDelta >= ESCAPE) {
+      offsetEscapes_.insert(std::make_pair(index, first->offset));
+      offsetDelta = ESCAPE;
+    }
+    put(block.bits, pos, block.stampBits, stampDelta);
+    put(block.bits, pos + block.stampBits, block.offsetBits, offsetDelta);
+    put(block.bits, pos + block.stampBits + block.offsetBits, block.typeBits, first->type);
+    pos += recordBits;
+  }
+
+  blocks_.push_back(block);
+  last_.clear();
+}
+
+void
+EventIndex::clear()
+{
+  BlockVector::const_iterator first, last = blocks_.end();
+  for (first = blocks_.begin(); first != last; ++first)
+    delete[] first->bits;
+  blocks_.clear();
+  last_.clear();
+  stampEscapes_.clear();
+  offsetEscapes_.clear();
+  size_ = 0;
+}
+
+ACE_UINT64
+EventIndex::minStamp(unsigned int _block) const
+{
+  return (_block < blocks_.size())? blocks_[_block].minStamp : lastMinStamp_;
+}
+
+ACE_UINT64
+EventIndex::maxStamp(unsigned int _block) const
+{
+  return (_block < blocks_.size())? blocks_[_block].maxStamp : lastMaxStamp_;
+}
+
+unsigned int
+EventIndex::lowerBound(ACE_Time_Value const& _stamp) const
+{
+  ACE_UINT64 const t = toUsec(_stamp);
+
+  // first block, that reaches up to the time stamp
+  unsigned int const numBlocks = (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  unsigned int low = 0;
+  unsigned int high = numBlocks;
+  while (low < high) {
+    unsigned int const mid = low + (high - low) / 2;
+    if (maxStamp(mid) < t)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if (low == numBlocks)
+    return size_;
+  if (minStamp(low) >= t)
+    return low * BLOCK_SIZE;
+
+  // first event of the block, that is not earlier
+  unsigned int first = low * BLOCK_SIZE;
+  unsigned int last = std::min(first + BLOCK_SIZE, size_);
+  while (first < last) {
+    unsigned int const mid = first + (last - first) / 2;
+    if (usec(mid) < t)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+  return first;
+}
+
+ACE_UINT8
+EventIndex::width(ACE_UINT64 _value)
+{
+  if (_value >= ESCAPE)
+    return 32;
+
+  ACE_UINT8 bits = 0;
+  for (; _value != 0; _value >>= 1)
+    ++bits;
+  return bits;
+}
+
+void
+EventIndex::put(ACE_UINT64 * _bits, unsigned int _pos, ACE_UINT8 _width, ACE_UINT64 _value)
+{
+  if (_width == 0)
+    return;
+
+  ACE_UINT64 * const word = _bits + _pos / 64;
+  unsigned int const shift = _pos % 64;
+  word[0] |= _value << shift;
+  if (shift + _width > 64)
+    word[1] |= _value >> (64 - shift);
+}
@@ -0,0 +1,259 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef EventIndex_h
+#define EventIndex_h
+
+#include <ace/Basic_Types.h>
+#include <ace/Time_Value.h>
+
+#include <vector>
+#include <map>
+
+//! Compact in memory index of the events of a log file.
+/**
+ * Holds the time stamp, the file offset and the event type of each
+ * event in blocks of BLOCK_SIZE events. Within a block, time stamp
+ * and offset are stored as deltas to the smallest time stamp and
+ * offset of the block, bit packed with the width of the largest
+ * delta of the block. So does the event type. Deltas wider than 32
+ * bits (far apart events, huge payloads) are kept aside.
+ *
+ * An event costs the widths of its block plus a share of the block
+ * header and its allocation (about 56 bytes per block). Events logged
+ * at a steady rate take 4 to 6 bytes, e.g. 5 bytes at 1 kHz with 200
+ * byte events of 16 types. Only the last, incomplete block is kept
+ * unpacked.
+ *
+ * The smallest and the largest time stamp of each block allow a
+ * binary search over the blocks first.
+ *
+ * Events are addressed by their position in the log file, so stepping
+ * forward and backward remains a matter of integer arithmetic.
+ */
+class EventIndex
+{
+public:
+  //----------------------------------------------------------------------------
+  // public constants
+  //----------------------------------------------------------------------------
+
+  //! Number of events per block.
+  static unsigned int const BLOCK_SIZE = 256;
+
+  //----------------------------------------------------------------------------
+  // public methods
+  //----------------------------------------------------------------------------
+  EventIndex();
+  ~EventIndex();
+
+  //! Prepare for the given number of events.
+  void reserve(unsigned int _events);
+  //! Append an event.
+  void push_back(ACE_Time_Value const& _stamp, ACE_UINT64 _offset,
+                 ACE_UINT16 _type);
+  //! Remove all events.
+  void clear();
+
+  //! Number of events.
+  unsigned int size() const;
+  //! Flag indicating no events are indexed.
+  bool empty() const;
+
+  //! Time stamp of an event.
+  ACE_Time_Value stamp(unsigned int _index) const;
+  //! File offset of an event.
+  ACE_UINT64 offset(unsigned int _index) const;
+  //! Event type id of an event.
+  ACE_UINT16 type(unsigned int _index) const;
+  //! Position of the first event not earlier than the time stamp.
+  /** Like std::lower_bound, size() if there is none. */
+  unsigned int lowerBound(ACE_Time_Value const& _stamp) const;
+
+protected:
+  //----------------------------------------------------------------------------
+  // protected types
+  //----------------------------------------------------------------------------
+
+  //! Marks a delta, that does not fit into 32 bits.
+  static ACE_UINT32 const ESCAPE = 0xffffffff;
+
+  //! Packed block of events.
+  struct Block
+  {
+    //! Smallest time stamp within the block in usec.
+    ACE_UINT64 minStamp;
+    //! Largest time stamp within the block in usec.
+    ACE_UINT64 maxStamp;
+    //! Smallest file offset within the block.
+    ACE_UINT64 offset;
+    //! Bit packed records of time stamp delta, offset delta and type.
+    ACE_UINT64 * bits;
+    //! Bit width of the time stamp deltas.
+    ACE_UINT8 stampBits;
+    //! Bit width of the offset deltas.
+    ACE_UINT8 offsetBits;
+    //! Bit width of the event types.
+    ACE_UINT8 typeBits;
+  };
+  typedef std::vector<Block> BlockVector;
+
+  //! Event of the last, incomplete block.
+  struct Entry
+  {
+    ACE_UINT64 stamp;
+    ACE_UINT64 offset;
+    ACE_UINT16 type;
+  };
+  typedef std::vector<Entry> EntryVector;
+  typedef std::map<unsigned int, ACE_UINT64> EscapeMap;
+
+  //----------------------------------------------------------------------------
+  // protected methods
+  //----------------------------------------------------------------------------
+
+  //! Time stamp of an event in usec.
+  ACE_UINT64 usec(unsigned int _index) const;
+  //! Pack the complete last block.
+  void pack();
+  //! Smallest time stamp of a block in usec, including the last one.
+  ACE_UINT64 minStamp(unsigned int _block) const;
+  //! Largest time stamp of a block in usec, including the last one.
+  ACE_UINT64 maxStamp(unsigned int _block) const;
+
+  //! Number of bits of the value, escaped beyond 32.
+  static ACE_UINT8 width(ACE_UINT64 _value);
+  //! Read the @ref _width bits at bit position @ref _pos.
+  static ACE_UINT32 get(ACE_UINT64 const * _bits, unsigned int _pos, ACE_UINT8 _width);
+  //! Write the @ref _width bits at bit position @ref _pos.
+  static void put(ACE_UINT64 * _bits, unsigned int _pos, ACE_UINT8 _width, ACE_UINT64 _value);
+
+  //----------------------------------------------------------------------------
+  // hidden methods
+  //----------------------------------------------------------------------------
+  EventIndex(EventIndex const&);
+  EventIndex& operator= (EventIndex const&);
+
+  //----------------------------------------------------------------------------
+  // protected data
+  //----------------------------------------------------------------------------
+
+  //! The packed blocks of events.
+  BlockVector blocks_;
+  //! The events of the last block, not yet packed.
+  EntryVector last_;
+  //! Smallest time stamp of the last block in usec.
+  ACE_UINT64 lastMinStamp_;
+  //! Largest time stamp of the last block in usec.
+  ACE_UINT64 lastMaxStamp_;
+  //! Number of events.
+  unsigned int size_;
+  //! Time stamps with escaped deltas.
+  EscapeMap stampEscapes_;
+  //! File offsets with escaped deltas.
+  EscapeMap offsetEscapes_;
+};
+
+inline
+unsigned int
+EventIndex::size() const
+{
+  return size_;
+}
+
+inline
+bool
+EventIndex::empty() const
+{
+  return size_ == 0;
+}
+
+inline
+ACE_UINT32
+EventIndex::get(ACE_UINT64 const * _bits, unsigned int _pos, ACE_UINT8 _width)
+{
+  ACE_UINT64 const * const word = _bits + _pos / 64;
+  unsigned int const shift = _pos % 64;
+  ACE_UINT64 value = word[0] >> shift;
+  if (shift + _width > 64)
+    value |= word[1] << (64 - shift);
+  return static_cast<ACE_UINT32>(value & ((ACE_UINT64(1) << _width) - 1));
+}
+
+inline
+ACE_UINT64
+EventIndex::usec(unsigned int _index) const
+{
+  unsigned int const b = _index / BLOCK_SIZE;
+  if (b == blocks_.size())
+    return last_[_index % BLOCK_SIZE].stamp;
+
+  Block const& block = blocks_[b];
+  unsigned int const pos =
+    (_index % BLOCK_SIZE) * (block.stampBits + block.offsetBits + block.typeBits);
+  ACE_UINT32 const delta = get(block.bits, pos, block.stampBits);
+  if (block.stampBits < 32 || delta != ESCAPE)
+    return block.minStamp + delta;
+  return stampEscapes_.find(_index)->second;
+}
+
+inline
+ACE_Time_Value
+EventIndex::stamp(unsigned int _index) const
+{
+  ACE_UINT64 const t = usec(_index);
+  return ACE_Time_Value(static_cast<time_t>(t / 1000000),
+                        static_cast<suseconds_t>(t % 1000000));
+}
+
+inline
+ACE_UINT64
+EventIndex::offset(unsigned int _index) const
+{
+  unsigned int const b = _index / BLOCK_SIZE;
+  if (b == blocks_.size())
+    return last_[_index % BLOCK_SIZE].offset;
+
+  Block const& block = blocks_[b];
+  unsigned int const pos =
+    (_index % BLOCK_SIZE) * (block.stampBits + block.offsetBits + block.typeBits) +
+    block.stampBits;
+  ACE_UINT32 const delta = get(block.bits, pos, block.offsetBits);
+  if (block.offsetBits < 32 || delta != ESCAPE)
+    return block.offset + delta;
+  return offsetEscapes_.find(_index)->second;
+}
+
+inline
+ACE_UINT16
+EventIndex::type(unsigned int _index) const
+{
+  unsigned int const b = _index / BLOCK_SIZE;
+  if (b == blocks_.size())
+    return last_[_index % BLOCK_SIZE].type;
+
+  Block const& block = blocks_[b];
+  unsigned int const pos =
+    (_index % BLOCK_SIZE) * (block.stampBits + block.offsetBits + block.typeBits) +
+    block.stampBits + block.offsetBits;
+  return static_cast<ACE_UINT16>(get(block.bits, pos, block.typeBits));
+}
+
+#endif // EventIndex_h
@@ -0,0 +1,172 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "FileIndexer.h"
+#include "LogFile.h"
+
+#include "miro/Exception.h"
+
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/OS_NS_unistd.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace
+{
+  typedef std::pair<ACE_OFF_T, LogFile *> SizePair;
+
+  struct LargerFirst : public std::binary_function<SizePair const&, SizePair const&, bool> {
+    bool operator() (SizePair const& _lhs, SizePair const& _rhs) const {
+      return _lhs.first > _rhs.first;
+    }
+  };
+}
+
+FileIndexer::FileIndexer(FileVector const& _files) :
+    percent_(_files.size(), 0),
+    errors_(_files.size()),
+    next_(0),
+    progress_(-1),
+    running_(0),
+    canceled_(false)
+{
+  // the largest file determines the total time, so start with it
+  std::vector<SizePair> sizes;
+  sizes.reserve(_files.size());
+  FileVector::const_iterator first, last = _files.end();
+  for (first = _files.begin(); first != last; ++first) {
+    ACE_stat st;
+    ACE_OFF_T const size =
+      (ACE_OS::stat((*first)->name().latin1(), &st) == 0)? st.st_size : 0;
+    sizes.push_back(std::make_pair(size, *first));
+  }
+  std::stable_sort(sizes.begin(), sizes.end(), LargerFirst());
+
+  files_.reserve(sizes.size());
+  std::vector<SizePair>::const_iterator f, l = sizes.end();
+  for (f = sizes.begin(); f != l; ++f) {
+    files_.push_back(f->second);
+  }
+}
+
+void
+FileIndexer::start(int _threads)
+{
+  if (_threads <= 0)
+    _threads = ACE_OS::num_processors_online();
+  if (_threads <= 0)
+    _threads = 1;
+  if (static_cast<size_t>(_threads) > files_.size())
+    _threads = files_.size();
+
+  running_ = _threads;
+  if (_threads == 0 ||
+      activate(THR_NEW_LWP | THR_JOINABLE, _threads) == -1) {
+    running_ = 0;
+    emit finished();
+  }
+}
+
+void
+FileIndexer::cancel()
+{
+  ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+  canceled_ = true;
+}
+
+bool
+FileIndexer::done() const
+{
+  ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+  return running_ == 0;
+}
+
+bool
+FileIndexer::canceled() const
+{
+  ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+  return canceled_;
+}
+
+QString
+FileIndexer::error(LogFile const * _file) const
+{
+  ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+  FileVector::const_iterator where = std::find(files_.begin(), files_.end(), _file);
+  return (where != files_.end())? errors_[where - files_.begin()] : QString();
+}
+
+int
+FileIndexer::svc()
+{
+  while (true) {
+    unsigned int index;
+    {
+      ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+      if (canceled_ || next_ == files_.size())
+        break;
+      index = next_++;
+    }
+
+    try {
+      unsigned int percent;
+      while ((percent = files_[index]->scan()) != 100 && !canceled()) {
+        report(index, percent);
+      }
+      report(index, 100);
+    }
+    catch (Miro::Exception const& e) {
+      {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        errors_[index] = e.what();
+      }
+      report(index, 100);
+    }
+  }
+
+  bool last;
+  {
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    last = (--running_ == 0);
+  }
+  if (last)
+    emit finished();
+  return 0;
+}
+
+void
+FileIndexer::report(unsigned int _index, unsigned int _percent)
+{
+  ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+  percent_[_index] = _percent;
+
+  unsigned int sum = 0;
+  for (unsigned int i = 0; i < percent_.size(); ++i)
+    sum += percent_[i];
+  int const overall = sum / percent_.size();
+
+  // emitted under the lock, so the reports stay in order
+  if (overall != progress_) {
+    progress_ = overall;
+    emit progress(overall);
+  }
+}
@@ -0,0 +1,120 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef FileIndexer_h
+#define FileIndexer_h
+
+#include <ace/Task.h>
+#include <ace/Synch.h>
+
+#include <qobject.h>
+#include <qstring.h>
+
+#include <vector>
+
+// forward declarations
+class LogFile;
+
+//! Worker pool scanning the event index of log files.
+/**
+ * The files are handed out largest first, one at a time, so opening
+ * a set of log files takes about as long as the largest one. The
+ * signals are emitted by the worker threads, so connect them queued.
+ */
+class FileIndexer : public QObject, public ACE_Task_Base
+{
+  Q_OBJECT
+
+  //----------------------------------------------------------------------------
+  // private types
+  //----------------------------------------------------------------------------
+  typedef QObject Super;
+
+public:
+  //----------------------------------------------------------------------------
+  // public types
+  //----------------------------------------------------------------------------
+  typedef std::vector<LogFile *> FileVector;
+
+  //----------------------------------------------------------------------------
+  // public methods
+  //----------------------------------------------------------------------------
+  FileIndexer(FileVector const& _files);
+
+  //! Start scanning with @ref _threads workers, 0 for one per cpu.
+  void start(int _threads = 0);
+  //! Flag indicating that all workers are done.
+  bool done() const;
+  //! Flag indicating that scanning was canceled.
+  bool canceled() const;
+  //! Error message of a log file, that could not be scanned.
+  /** Empty, if there was no error. */
+  QString error(LogFile const * _file) const;
+
+  //! Inherited method: the worker loop.
+  virtual int svc();
+
+  //----------------------------------------------------------------------------
+  // public slots
+  //----------------------------------------------------------------------------
+public slots:
+  //! Stop scanning after the current chunk of events.
+  void cancel();
+
+  //----------------------------------------------------------------------------
+  // signals
+  //----------------------------------------------------------------------------
+signals:
+  //! Overall progress in percent.
+  void progress(int);
+  //! All workers are done.
+  /** Emitted exactly once, also if no worker could be started. */
+  void finished();
+
+protected:
+  //----------------------------------------------------------------------------
+  // protected methods
+  //----------------------------------------------------------------------------
+
+  //! Note the progress of a file, emit the overall progress if changed.
+  void report(unsigned int _index, unsigned int _percent);
+
+  //----------------------------------------------------------------------------
+  // protected data
+  //----------------------------------------------------------------------------
+
+  //! Lock for the shared state.
+  mutable ACE_Thread_Mutex mutex_;
+  //! The log files, largest first.
+  FileVector files_;
+  //! Progress of each file in percent.
+  std::vector<unsigned int> percent_;
+  //! Error messages of each file.
+  std::vector<QString> errors_;
+  //! Next file to scan.
+  unsigned int next_;
+  //! Last overall progress reported.
+  int progress_;
+  //! Number of running workers.
+  int running_;
+  //! Flag indicating that scanning was canceled, guarded by @ref mutex_.
+  bool canceled_;
+};
+#endif
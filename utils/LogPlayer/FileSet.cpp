@@ -24,31 +24,28 @@
 #include "miro/TimeHelper.h"
 #include "miro/Log.h"
 #include "miro/LogWriter.h"
+#include "miro/LogExtractor.h"
+#include "miro/LogMergeTree.h"
 
 #define QT_NO_TEXTSTREAM
 #include <q3tl.h>
 
+#include <algorithm>
+
 namespace
 {
-  struct LFLess : public std::binary_function<LogFile const *, LogFile const *, bool> {
-    bool operator() (LogFile const * _lhs, LogFile const * _rhs) {
-      return _lhs->coursorTime() < _rhs->coursorTime();
-    }
-  };
-
-
-  struct LFMore : public std::binary_function<LogFile const *, LogFile const *, bool> {
-    bool operator() (LogFile const * _lhs, LogFile const * _rhs) {
-      return _lhs->coursorTime() > _rhs->coursorTime();
-    }
-  };
+  void
+  deleteExtractor(Miro::LogExtractor * _extractor)
+  {
+    delete _extractor;
+  }
 }
 
 FileSet::FileSet(ChannelManager * _channelManager) :
     channelManager_(_channelManager),
+    coursor_(0),
     startCut_(ACE_Time_Value::zero),
-    endCut_(ACE_Time_Value::zero),
-    forward_(true)
+    endCut_(ACE_Time_Value::zero)
 {}
 
 FileSet::~FileSet()
@@ -68,6 +65,10 @@ FileSet::addFile(QString const& _name)
       break;
   MIRO_ASSERT(first == file_.end());
 
+  // the merged events note their file in 16 bits
+  if (file_.size() > ACE_UINT16_MAX)
+    throw Miro::Exception("FileSet - Too many log files.");
+
   LogFile * const logFile = new LogFile(_name, channelManager_);
   file_.push_back(logFile);
 
@@ -77,13 +78,17 @@ FileSet::addFile(QString const& _name)
 void
 FileSet::delFile(QString const& _name)
 {
-  // remember coursor time
+  // remember coursor time,
+  // unless files of a pending load are not indexed yet
   ACE_Time_Value t;
-  bool parsed = file_.front()->parsed();
+  bool parsed = true;
+  FileVector::iterator first, last = file_.end();
+  for (first = file_.begin(); first != last; ++first)
+    if ((*first)->name() != _name && !(*first)->parsed())
+      parsed = false;
   if (parsed)
     t = coursorTime();
 
-  FileVector::iterator first, last = file_.end();
   for (first = file_.begin(); first != last; ++first)
     if ((*first)->name() == _name)
       break;
@@ -92,11 +97,13 @@ FileSet::delFile(QString const& _name)
   delete *first;
   file_.erase(first);
 
+  // the file positions of the merged events are stale now
+  order_.clear();
+  coursor_ = 0;
+
   if (parsed && file_.size() != 0) {
     calcStartEndTime();
     coursorTime(t);
-    forward_ = true;
-    std::make_heap(file_.begin(), file_.end(), LFMore());
   }
 }
 
@@ -121,6 +128,7 @@ FileSet::calcStartEndTime()
       (*first)->setTimeOffset(startTime_);
     }
   }
+  mergeFiles();
 
   startCut_ = startTime_;
   endCut_ = endTime_;
@@ -129,26 +137,106 @@ FileSet::calcStartEndTime()
 }
 
 void
-FileSet::coursorTime(ACE_Time_Value const& _time)
+FileSet::mergeFiles()
 {
-  FileVector::const_iterator first, last = file_.end();
-  for (first = file_.begin(); first != last; ++first) {
-    (*first)->coursorTime(_time);
+  order_.clear(file_.size());
+  coursor_ = 0;
+  if (file_.size() == 0)
+    return;
+
+  // k-way merge of the indexed time stamps
+  std::vector<ACE_Time_Value> keys(file_.size(), ACE_Time_Value::max_time);
+  std::vector<unsigned int> next(file_.size(), 0);
+  unsigned int events = 0;
+  for (unsigned int i = 0; i < file_.size(); ++i) {
+    events += file_[i]->events();
+    if (file_[i]->events() != 0)
+      keys[i] = file_[i]->eventTime(0);
   }
+  order_.reserve(events);
 
-  std::make_heap(file_.begin(), file_.end(), LFMore());
-  forward_ = true;
+  Miro::LogMergeTree<ACE_Time_Value> tree(keys);
+  while (tree.topKey() != ACE_Time_Value::max_time) {
+    unsigned int const f = tree.top();
+    order_.push_back(f);
 
-  //  std::cout << "new time heap: " << std::endl;
-  //  for (first = file_.begin(); first != last; ++first) {
-  //    std::cout << (*first)->coursorTime()  - startTime_ << std::endl;
-  //  }
+    ++next[f];
+    tree.pop((next[f] < file_[f]->events())?
+             file_[f]->eventTime(next[f]) : ACE_Time_Value::max_time);
+  }
+  coursor_ = order_.size();
+}
+
+unsigned int
+FileSet::lowerBound(ACE_Time_Value const& _time) const
+{
+  unsigned int first = 0;
+  unsigned int last = order_.size();
+  while (first < last) {
+    unsigned int const mid = first + (last - first) / 2;
+    if (eventTime(mid) < _time)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+  return first;
+}
+
+bool
+FileSet::validEvent(unsigned int _index)
+{
+  return file_[order_.file(_index)]->seekEvent(order_.event(_index));
+}
+
+void
+FileSet::nextValid()
+{
+  while (coursor_ < order_.size() && !validEvent(coursor_))
+    ++coursor_;
+}
+
+bool
+FileSet::prevValid()
+{
+  for (unsigned int i = coursor_; i > 0; --i) {
+    if (validEvent(i - 1)) {
+      coursor_ = i - 1;
+      return true;
+    }
+  }
+  // reload the event at the coursor
+  if (coursor_ < order_.size())
+    validEvent(coursor_);
+  return false;
+}
 
-  file_.front()->getCurrentEvent();
+void
+FileSet::coursorPosition(unsigned int _index)
+{
+  coursor_ = _index;
+  nextValid();
+  if (coursor_ < order_.size())
+    coursorFile()->parseEvent();
 
   emit coursorChange();
 }
 
+void
+FileSet::access(Miro::LogReader::Access _access)
+{
+  FileVector::const_iterator first, last = file_.end();
+  for (first = file_.begin(); first != last; ++first)
+    (*first)->logReader().access(_access);
+}
+
+void
+FileSet::coursorTime(ACE_Time_Value const& _time)
+{
+  // jumping around, readahead would only evict pages in use
+  access(Miro::LogReader::RANDOM);
+  coursorPosition(lowerBound(_time));
+}
+
 void
 FileSet::coursorTimeRel(ACE_Time_Value const& _time)
 {
@@ -164,30 +252,14 @@ FileSet::playEvents(ACE_Time_Value const& _time)
   if (coursorTime() > endCut_)
     return;
 
-  // correct heap if we change direction
-  if (!forward_) {
-    FileVector::const_iterator first, last = file_.end();
-    first = file_.begin();
-    for (++first; first != last; ++first)
-      (*first)->assertAfter(file_.front()->coursorTime());
-    std::make_heap(file_.begin(), file_.end(), LFMore());
-    forward_ = true;
-  }
-
-  while (file_.front()->coursorTime() <= _time) {
-    std::pop_heap(file_.begin(), file_.end(), LFMore());
-    file_.back()->sendEvent();
-    file_.back()->nextEvent();
-    std::push_heap(file_.begin(), file_.end(), LFMore());
-
-    // restore heap attibute
-    //    std::cout << "new time heap: " << std::endl;
-    //    FileVector::const_iterator first, last = file_.end();
-    //    for (first = file_.begin(); first != last; ++first) {
-    //      std::cout << (*first)->coursorTime() - startTime_ << std::endl;
-    //    }
-
-    file_.front()->parseEvent();
+  // the log files are read ahead of the coursor
+  access(Miro::LogReader::SEQUENTIAL);
+  while (coursor_ < order_.size() && eventTime(coursor_) <= _time) {
+    coursorFile()->sendEvent();
+    ++coursor_;
+    nextValid();
+    if (coursor_ < order_.size())
+      coursorFile()->parseEvent();
   }
 
   emit coursorChange();
@@ -200,29 +272,11 @@ FileSet::playBackwards()
   if (coursorTime() <= startCut_)
     return;
 
-  // correct heap if we change direction
-  if (forward_) {
-    FileVector::const_iterator first, last = file_.end();
-    first = file_.begin();
-    for (++first; first != last; ++first)
-      (*first)->assertBefore(file_.front()->coursorTime());
-
-    std::make_heap(file_.begin(), file_.end(), LFLess());
-    forward_ = false;
-  }
-
-  std::pop_heap(file_.begin(), file_.end(), LFLess());
-  file_.back()->sendEvent();
-  file_.back()->prevEvent();
-  std::push_heap(file_.begin(), file_.end(), LFLess());
-
-//   std::cout << "new time heap: " << std::endl;
-//   FileVector::const_iterator first, last = file_.end();
-//   for (first = file_.begin(); first != last; ++first) {
-//     std::cout << (*first)->coursorTime()  - startTime_ << std::endl;
-//   }
-
-  file_.front()->parseEvent();
+  access(Miro::LogReader::RANDOM);
+  if (coursor_ < order_.size())
+    coursorFile()->sendEvent();
+  if (prevValid())
+    coursorFile()->parseEvent();
 
   emit coursorChange();
 }
@@ -231,42 +285,59 @@ void
 FileSet::getEvents(ACE_Time_Value const& _time, unsigned int _num)
 {
   // prepare log file set
-  ACE_Time_Value now = coursorTime();
+  unsigned int const now = coursor_;
 
   // set new time
   coursorTime(_time);
 
-  while (file_.front()->coursorTime() <= endCut_ && --_num > 0) {
-    std::pop_heap(file_.begin(), file_.end(), LFMore());
-    file_.back()->nextEvent();
-    std::push_heap(file_.begin(), file_.end(), LFMore());
-    file_.front()->parseEvent();
+  while (coursor_ < order_.size() && eventTime(coursor_) <= endCut_ &&
+         --_num > 0) {
+    ++coursor_;
+    nextValid();
+    if (coursor_ < order_.size())
+      coursorFile()->parseEvent();
   }
 
-  // restor coursor time
-  coursorTime(now);
+  // restor coursor position
+  coursorPosition(now);
 }
 
 void
 FileSet::saveCut(QString const& _fileName)
 {
-  // create the new log file
-  Miro::LogWriter writer(std::string(_fileName.latin1()));
+  // create the new log file, plain to copy the event records
+  Miro::LogNotifyParameters parameters(*Miro::LogNotifyParameters::instance());
+  parameters.compress = false;
+  Miro::LogWriter writer(std::string(_fileName.latin1()), parameters);
 
   // save the current coursor position
-  ACE_Time_Value now = coursorTime();
+  unsigned int const now = coursor_;
 
-  coursorTime(cutStartTime());
-
-  while (file_.front()->coursorTime() <= endCut_) {
-    writer.logEvent(file_.front()->coursorTime(), file_.front()->currentEvent());
-    std::pop_heap(file_.begin(), file_.end(), LFMore());
-    file_.back()->nextEvent();
-    std::push_heap(file_.begin(), file_.end(), LFMore());
+  // one extractor per file, each reproducing its type codes in the cut
+  std::vector<Miro::LogExtractor *> extractors;
+  try {
+    FileVector::const_iterator first, last = file_.end();
+    for (first = file_.begin(); first != last; ++first)
+      extractors.push_back(new Miro::LogExtractor((*first)->logReader(), writer));
+
+    for (unsigned int i = lowerBound(startCut_);
+         i < order_.size() && eventTime(i) <= endCut_; ++i) {
+      unsigned int const f = order_.file(i);
+      unsigned int const event = order_.event(i);
+      if (!file_[f]->excluded(event) &&
+          !file_[f]->copyEvent(event, *extractors[f]))
+        throw Miro::Exception("FileSet - Log file full: " + std::string(_fileName.latin1()));
+    }
+  }
+  catch (...) {
+    std::for_each(extractors.begin(), extractors.end(), deleteExtractor);
+    coursorPosition(now);
+    throw;
   }
+  std::for_each(extractors.begin(), extractors.end(), deleteExtractor);
 
   // restore coursor position
-  coursorTime(now);
+  coursorPosition(now);
 }
 
 QStringList
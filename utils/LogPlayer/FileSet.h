@@ -22,6 +22,7 @@
 #define FileManager_h
 
 #include "LogFile.h"
+#include "MergeIndex.h"
 #include "miro/Log.h"
 
 #include <qstring.h>
@@ -72,6 +73,11 @@ public:
 
 
   //! Save the current cut to one file.
+  /**
+   * The events are copied as marshalled records, see @ref
+   * Miro::LogExtractor. Throws Miro::Exception, if the cut could not
+   * be written.
+   */
   void saveCut(QString const& _fileName);
 
   //! Play events till specified time
@@ -89,7 +95,7 @@ public:
   }
 
   //! Current coursor event time.
-  ACE_Time_Value const& coursorTime() const;
+  ACE_Time_Value coursorTime() const;
   void coursorTime(ACE_Time_Value const& _t);
   void coursorTimeRel(ACE_Time_Value const& _t);
 
@@ -119,6 +125,25 @@ protected:
   ACE_Time_Value const& startTime() const;
   ACE_Time_Value const& endTime() const;
 
+  //! Merge the events of all log files into one time ordered sequence.
+  void mergeFiles();
+  //! Time stamp of the event at position @ref _index.
+  ACE_Time_Value eventTime(unsigned int _index) const;
+  //! Position of the first merged event not earlier than the time stamp.
+  unsigned int lowerBound(ACE_Time_Value const& _time) const;
+  //! The log file of the event at the coursor.
+  LogFile * coursorFile() const;
+  //! Load the event at position @ref _index, false if it is excluded.
+  bool validEvent(unsigned int _index);
+  //! Move the coursor forward to the next event, that is not excluded.
+  void nextValid();
+  //! Move the coursor back to the previous event, that is not excluded.
+  bool prevValid();
+  //! Set the coursor to the position @ref _index of the merged sequence.
+  void coursorPosition(unsigned int _index);
+  //! Advise the access pattern of all log files.
+  void access(Miro::LogReader::Access _access);
+
   //----------------------------------------------------------------------------
   // private data
   //----------------------------------------------------------------------------
@@ -133,13 +158,15 @@ private:
   //! The ent time of all log files.
   ACE_Time_Value endTime_;
 
+  //! The events of all log files in time order.
+  MergeIndex order_;
+  //! Position of the coursor within the merged events.
+  unsigned int coursor_;
+
   //! The start of the log files after cutting.
   ACE_Time_Value startCut_;
   //! The end of the log files after cutting.
   ACE_Time_Value endCut_;
-
-  //! Flag indicating the direction we play the events.
-  bool forward_;
 };
 
 inline
@@ -186,7 +213,7 @@ void
 FileSet::cutStart()
 {
   MIRO_ASSERT(file_.size() != 0);
-  startCut_ = file_.front()->coursorTime();
+  startCut_ = coursorTime();
   emit intervalChange();
 }
 
@@ -195,7 +222,7 @@ void
 FileSet::cutEnd()
 {
   MIRO_ASSERT(file_.size() != 0);
-  endCut_ = file_.front()->coursorTime();
+  endCut_ = coursorTime();
   emit intervalChange();
 }
 
@@ -209,12 +236,26 @@ FileSet::cutUndo()
 }
 
 inline
-ACE_Time_Value const&
+ACE_Time_Value
+FileSet::eventTime(unsigned int _index) const
+{
+  return file_[order_.file(_index)]->eventTime(order_.event(_index));
+}
+
+inline
+ACE_Time_Value
 FileSet::coursorTime() const
 {
   MIRO_ASSERT(file_.size() != 0);
-  return (file_.front()->coursorTime() != ACE_Time_Value(0, 0))?
-         file_.front()->coursorTime() : endTime_;
+  return (coursor_ < order_.size())? eventTime(coursor_) : endTime_;
+}
+
+inline
+LogFile *
+FileSet::coursorFile() const
+{
+  MIRO_ASSERT(coursor_ < order_.size());
+  return file_[order_.file(coursor_)];
 }
 
 #endif // FileManager_h
@@ -24,6 +24,11 @@
 
 #include "miro/StructuredPushSupplier.h"
 #include "miro/TimeHelper.h"
+#include "miro/LogIndex.h"
+#include "miro/LogIndexFile.h"
+#include "miro/LogExtractor.h"
+
+#include <orbsvcs/Time_Utilities.h>
 
 #include <cstring>
 #include <iostream>
@@ -32,8 +37,8 @@ LogFile::LogFile(QString const& _name,
                  ChannelManager * _channelManager) :
     name_(_name),
     channelManager_(_channelManager),
-    coursor_(timeVector_.end()),
-    currentDomainName_(""),
+    coursor_(0),
+    currentType_(typeIDs_.end()),
     logReader_(name_.latin1()),
     counter_(0),
     parsed_(false)
@@ -65,77 +70,90 @@ LogFile::~LogFile()
 
 unsigned int
 LogFile::parse()
+{
+  unsigned int const rc = scan();
+  if (rc == 100 && suppliers_.empty())
+    connectSuppliers();
+  return rc;
+}
+
+unsigned int
+LogFile::scan()
 {
   unsigned int rc = 0;
   ACE_Time_Value timeStamp;
   CosNotification::FixedEventHeader header;
 
   bool notEof = true;
-  while (( logReader_.version() >= 3 &&
+
+  // version >= 5: the event index spares the scan of the log file
+  if (logReader_.hasIndex()) {
+    CosNotification::EventTypeSeq const& types = logReader_.indexEventTypes();
+    std::vector<ACE_UINT16> ids(types.length());
+    for (unsigned int i = 0; i < types.length(); ++i) {
+      ids[i] = typeID(types[i].domain_name, types[i].type_name);
+    }
+
+    unsigned int const size = logReader_.indexSize();
+    events_.reserve(size);
+    for (unsigned int i = 0; i < size; ++i) {
+      // events of compressed log files are accessed by number
+      char const * event = logReader_.indexEvent(i);
+      ACE_UINT64 const offset = (event != NULL)?
+        logReader_.fileOffset(event) + sizeof(TimeBase::TimeT) : 0;
+      events_.push_back(logReader_.indexTime(i), offset,
+                        ids[logReader_.indexType(i)]);
+    }
+    counter_ = logReader_.events();
+  }
+
+  // log files without index are scanned front to back
+  if (!logReader_.hasIndex())
+    logReader_.access(Miro::LogReader::SEQUENTIAL);
+
+  while (!logReader_.hasIndex() && (( logReader_.version() >= 3 &&
               ++counter_ <= logReader_.events() &&
               ( notEof = logReader_.parseTimeStamp(timeStamp) ) ) ||
               ( logReader_.version() < 3 &&
-                ( notEof = logReader_.parseTimeStamp(timeStamp) ) ) ) {
+                ( notEof = logReader_.parseTimeStamp(timeStamp) ) ) ) ) {
 
-    timeVector_.push_back(std::make_pair(timeStamp, logReader_.rdPtr()));
+    size_t const offset = logReader_.fileOffset(logReader_.rdPtr());
 
     logReader_.parseEventHeader(header);
 
-    // get domain name slot
-    if (strcmp(currentDomainName_,
-                (char const *)header.event_type.domain_name) != 0) {
-      currentDomainEvents_ =
-        eventTypes_.find((char const *)header.event_type.domain_name);
-      if (currentDomainEvents_ == eventTypes_.end()) {
-        currentDomainEvents_ =
-          eventTypes_.insert(std::make_pair((char const *)
-                                            CORBA::string_dup(header.event_type.domain_name),
-                                            CStringSet())).first;
-      }
-      currentDomainName_ = currentDomainEvents_->first;
+    // events of one type tend to come in bursts
+    char const * const domainName = header.event_type.domain_name;
+    char const * const typeName = header.event_type.type_name;
+    if (currentType_ == typeIDs_.end() ||
+        strcmp(currentType_->first.second, typeName) != 0 ||
+        strcmp(currentType_->first.first, domainName) != 0) {
+      typeID(domainName, typeName);
+      currentType_ = typeIDs_.find(TypePair(domainName, typeName));
     }
-    if (currentDomainEvents_->second.find(header.event_type.type_name) ==
-                currentDomainEvents_->second.end())
-
-      currentDomainEvents_->second.insert(CORBA::string_dup(header.event_type.type_name));
+    events_.push_back(timeStamp, offset, currentType_->second);
 
     // skip event
     logReader_.skipEventBody();
+    logReader_.readAhead();
 
 
     // break parsing up to advance status bar
-    if (!(timeVector_.size() % 2048))
+    if (!(events_.size() % 2048))
       break;
   }
 
-  if (timeVector_.size() == 0)
+  if (events_.empty())
     throw Miro::Exception("Logfile contains no data.");
 
   // EOF
-  if (!notEof ||
+  if (logReader_.hasIndex() || !notEof ||
               ( logReader_.version() >= 3 && counter_ >= logReader_.events()) ) {
-    coursor_ = timeVector_.begin();
+    coursor_ = 0;
+    logReader_.access(Miro::LogReader::NORMAL);
 
-    suppliers_.reserve(eventTypes_.size());
-    CStringMap::const_iterator first, last = eventTypes_.end();
-    for (first = eventTypes_.begin(); first != last; ++first) {
-      CosNotifyChannelAdmin::EventChannel_ptr ec =
-        channelManager_->getEventChannel(first->first);
-      Miro::StructuredPushSupplier * supplier =
-        new Miro::StructuredPushSupplier(ec);
-      suppliers_.push_back(std::make_pair(first->first, supplier));
-
-      CosNotification::EventTypeSeq offers;
-      offers.length(first->second.size());
-
-      CStringSet::const_iterator typeName = first->second.begin();
-      for (unsigned int i = 0; i < offers.length(); ++i, ++ typeName) {
-        offers[i].domain_name = CORBA::string_dup(first->first);
-        offers[i].type_name = CORBA::string_dup(*typeName);
-      }
-      supplier->setOffers(offers);
-      supplier->connect();
-    }
+    // save the scan for the next time
+    if (!logReader_.hasIndex())
+      writeSidecar();
 
     rc = 100;
     parsed_ = true;
@@ -146,10 +164,37 @@ LogFile::parse()
   return rc;
 }
 
+void
+LogFile::connectSuppliers()
+{
+  MIRO_ASSERT(parsed_);
+
+  suppliers_.reserve(eventTypes_.size());
+  CStringMap::const_iterator first, last = eventTypes_.end();
+  for (first = eventTypes_.begin(); first != last; ++first) {
+    CosNotifyChannelAdmin::EventChannel_ptr ec =
+      channelManager_->getEventChannel(first->first);
+    Miro::StructuredPushSupplier * supplier =
+      new Miro::StructuredPushSupplier(ec);
+    suppliers_.push_back(std::make_pair(first->first, supplier));
+
+    CosNotification::EventTypeSeq offers;
+    offers.length(first->second.size());
+
+    CStringSet::const_iterator typeName = first->second.begin();
+    for (unsigned int i = 0; i < offers.length(); ++i, ++ typeName) {
+      offers[i].domain_name = CORBA::string_dup(first->first);
+      offers[i].type_name = CORBA::string_dup(*typeName);
+    }
+    supplier->setOffers(offers);
+    supplier->connect();
+  }
+}
+
 void
 LogFile::sendEvent()
 {
-  MIRO_ASSERT(coursor_ != timeVector_.end());
+  MIRO_ASSERT(coursor_ < events_.size());
 
   emit notifyEvent(domainName_ + " - " + typeName_);
 
@@ -167,42 +212,104 @@ LogFile::sendEvent()
   }
 }
 
+ACE_UINT16
+LogFile::typeID(char const * _domainName, char const * _typeName)
+{
+  TypeIDMap::const_iterator id = typeIDs_.find(TypePair(_domainName, _typeName));
+  if (id != typeIDs_.end())
+    return id->second;
+
+  if (typeIDs_.size() > ACE_UINT16_MAX)
+    throw Miro::Exception("Logfile contains too many event types.");
+
+  // the strings are owned by the event type map
+  CStringMap::iterator domain = eventTypes_.find(_domainName);
+  if (domain == eventTypes_.end()) {
+    domain =
+      eventTypes_.insert(std::make_pair((char const *)CORBA::string_dup(_domainName),
+                                        CStringSet())).first;
+  }
+  CStringSet::iterator type = domain->second.find(_typeName);
+  if (type == domain->second.end())
+    type = domain->second.insert(CORBA::string_dup(_typeName)).first;
+
+  ACE_UINT16 const newID = typeIDs_.size();
+  typeIDs_.insert(std::make_pair(TypePair(domain->first, *type), newID));
+  excluded_.push_back(false);
+  return newID;
+}
+
+void
+LogFile::writeSidecar()
+{
+  // event types by id
+  CosNotification::EventTypeSeq types;
+  types.length(typeIDs_.size());
+  TypeIDMap::const_iterator first, last = typeIDs_.end();
+  for (first = typeIDs_.begin(); first != last; ++first) {
+    types[first->second].domain_name = CORBA::string_dup(first->first.first);
+    types[first->second].type_name = CORBA::string_dup(first->first.second);
+  }
+
+  // rebuilt from the event index, spilling to a temporary file in chunks
+  try {
+    Miro::LogIndex index;
+    TimeBase::TimeT t;
+    for (unsigned int i = 0; i < events_.size(); ++i) {
+      ORBSVCS_Time::Absolute_Time_Value_to_TimeT(t, events_.stamp(i));
+      index.add(t, events_.offset(i) - sizeof(TimeBase::TimeT), types[events_.type(i)]);
+    }
+    Miro::LogIndexFile::write(name_.latin1(), logReader_.byteOrder(),
+                              logReader_.events(), index);
+  }
+  catch (Miro::Exception const& e) {
+    MIRO_LOG_OSTR(LL_WARNING, "LogFile - Could not save sidecar index: " << e);
+  }
+}
+
+void
+LogFile::parseCoursorEvent()
+{
+  if (logReader_.compressed())
+    logReader_.seekEvent(coursor_);
+  else
+    logReader_.rdPtr(logReader_.filePointer(events_.offset(coursor_)));
+  logReader_.readAhead();
+  logReader_.parseEventHeader(event_.header.fixed_header);
+  logReader_.parseEventBody(event_);
+}
+
 bool
 LogFile::nextEvent()
 {
-  MIRO_ASSERT (coursor_ != timeVector_.end());
+  MIRO_ASSERT (coursor_ < events_.size());
 
   do {
     ++coursor_;
-    if (coursor_ == timeVector_.end()) {
+    if (coursor_ >= events_.size()) {
       return false;
     }
-
-    logReader_.rdPtr(coursor_->second);
-    logReader_.parseEventHeader(event_.header.fixed_header);
   }
-  while (!validEvent());
+  while (excluded(coursor_));
+
+  parseCoursorEvent();
   return true;
 }
 
 bool
 LogFile::getCurrentEvent()
 {
-  if (coursor_ == timeVector_.end())
+  if (coursor_ >= events_.size())
     return false;
 
-  logReader_.rdPtr(coursor_->second);
-  logReader_.parseEventHeader(event_.header.fixed_header);
-  while (!validEvent()) {
+  while (excluded(coursor_)) {
     ++coursor_;
-    if (coursor_ == timeVector_.end()) {
+    if (coursor_ >= events_.size()) {
       return false;
     }
-
-    logReader_.rdPtr(coursor_->second);
-    logReader_.parseEventHeader(event_.header.fixed_header);
   }
 
+  parseCoursorEvent();
   parseEvent();
 
   return true;
@@ -212,99 +319,74 @@ bool
 LogFile::prevEvent()
 {
   do {
-    if (coursor_ == timeVector_.begin())
+    if (coursor_ == 0)
       return false;
     --coursor_;
-
-    logReader_.rdPtr(coursor_->second);
-    logReader_.parseEventHeader(event_.header.fixed_header);
   }
-  while (!validEvent());
+  while (excluded(coursor_));
 
+  parseCoursorEvent();
   return true;
 }
 
 bool
-LogFile::assertBefore(ACE_Time_Value const& _t)
+LogFile::seekEvent(unsigned int _index)
 {
-  bool valid = true;
-  while (valid && coursor_->first >= _t) {
-    valid = prevEvent();
-  }
-  return valid;
+  MIRO_ASSERT(_index < events_.size());
+
+  coursor_ = _index;
+  if (excluded(coursor_))
+    return false;
+
+  parseCoursorEvent();
+  return true;
 }
 
 bool
-LogFile::assertAfter(ACE_Time_Value const& _t)
+LogFile::copyEvent(unsigned int _index, Miro::LogExtractor& _extractor)
 {
-  bool valid = true;
-  while (valid && coursor_->first <= _t) {
-    valid = nextEvent();
-  }
-  return valid;
+  MIRO_ASSERT(_index < events_.size());
+
+  // the positions of indexed log files match the event index
+  if (logReader_.hasIndex())
+    return _extractor.copyEvent(_index);
+
+  logReader_.rdPtr(logReader_.filePointer(events_.offset(_index)));
+  return _extractor.copyCurrent(events_.stamp(_index));
 }
 
 void
 LogFile::clearExclude()
 {
-  exclude_.clear();
+  std::fill(excluded_.begin(), excluded_.end(), false);
 }
 
 void
 LogFile::addExclude(QString const& _domainName, QString const& _typeName)
 {
-  CStringMap::const_iterator domain = eventTypes_.find(_domainName.latin1());
-  if (domain == eventTypes_.end())
-    return;
-
-  CStringSet::const_iterator type = domain->second.find(_typeName.latin1());
-  if (type == domain->second.end())
-    return;
-
-  CStringMap::iterator eDomain = exclude_.find(domain->first);
-  if (eDomain == exclude_.end()) {
-    eDomain = exclude_.insert(std::make_pair(domain->first, CStringSet())).first;
-  }
-  eDomain->second.insert(*type);
+  QByteArray const domainName = _domainName.toLatin1();
+  QByteArray const typeName = _typeName.toLatin1();
+  TypeIDMap::const_iterator id =
+    typeIDs_.find(TypePair(domainName.constData(), typeName.constData()));
+  if (id != typeIDs_.end())
+    excluded_[id->second] = true;
 }
 
 void
 LogFile::delExclude(QString const& _domainName, QString const& _typeName)
 {
-  CStringMap::iterator domain = exclude_.find(_domainName.latin1());
-  if (domain == exclude_.end())
-    return;
-
-  CStringSet::iterator type = domain->second.find(_typeName.latin1());
-  if (type == domain->second.end())
-    return;
-
-  domain->second.erase(type);
-  if (domain->second.size() == 0)
-    exclude_.erase(domain);
-}
-
-bool
-LogFile::validEvent()
-{
-  // skip excluded events
-  CStringMap::const_iterator eDomain =
-    exclude_.find(event_.header.fixed_header.event_type.domain_name);
-  if (eDomain != exclude_.end()) {
-    if (eDomain->second.find(event_.header.fixed_header.event_type.type_name) !=
-                eDomain->second.end()) {
-      logReader_.skipEventBody();
-      return false;
-    }
-  }
-  logReader_.parseEventBody(event_);
-  return true;
+  QByteArray const domainName = _domainName.toLatin1();
+  QByteArray const typeName = _typeName.toLatin1();
+  TypeIDMap::const_iterator id =
+    typeIDs_.find(TypePair(domainName.constData(), typeName.constData()));
+  if (id != typeIDs_.end())
+    excluded_[id->second] = false;
 }
 
 void
 LogFile::parseEvent()
 {
-  if (coursor_ == timeVector_.end())
+  if (coursor_ >= events_.size())
     return;
 
   // localize debug hack
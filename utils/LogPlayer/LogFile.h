@@ -24,6 +24,8 @@
 #include "miro/Log.h"
 #include "miro/LogReader.h"
 
+#include "EventIndex.h"
+
 #include <orbsvcs/CosNotifyChannelAdminC.h>
 
 #include <ace/Mem_Map.h>
@@ -47,6 +49,7 @@ class ChannelManager;
 namespace Miro
 {
   class StructuredPushSupplier;
+  class LogExtractor;
 };
 
 class LogFile : public QObject
@@ -57,10 +60,10 @@ private:
   typedef QObject Super;
 
 protected:
-  typedef std::pair< ACE_Time_Value, char const * > TimePair;
-  typedef std::vector< TimePair > TimeVector;
   typedef std::vector< QString > QStringVector;
   typedef std::pair< char const *, Miro::StructuredPushSupplier *> SupplierPair;
+  //! Domain and type name of an event type.
+  typedef std::pair< char const *, char const * > TypePair;
 
   struct LtStr : public std::binary_function<char const *, char const *, bool> {
     bool operator()(char const * s1, char const * s2) const {
@@ -68,15 +71,16 @@ protected:
     }
   };
 
-  struct LtStrFirst : public std::binary_function<SupplierPair const&, SupplierPair const&, bool> {
-    bool operator()(SupplierPair const & s1, SupplierPair const & s2) const {
-      return strcmp(s1.first, s2.first) < 0;
+  struct LtType : public std::binary_function<TypePair const&, TypePair const&, bool> {
+    bool operator()(TypePair const & t1, TypePair const & t2) const {
+      int const rc = strcmp(t1.first, t2.first);
+      return rc < 0 || (rc == 0 && strcmp(t1.second, t2.second) < 0);
     }
   };
 
-  struct TVLess : public std::binary_function<TimePair const&, TimePair const &, bool> {
-    bool operator() (TimePair const & _lhs, TimePair const & _rhs) {
-      return _lhs.first < _rhs.first;
+  struct LtStrFirst : public std::binary_function<SupplierPair const&, SupplierPair const&, bool> {
+    bool operator()(SupplierPair const & s1, SupplierPair const & s2) const {
+      return strcmp(s1.first, s2.first) < 0;
     }
   };
 
@@ -84,6 +88,8 @@ public:
   typedef std::set< char const *, LtStr > CStringSet;
   typedef std::map< char const *, CStringSet, LtStr > CStringMap;
   typedef std::vector< SupplierPair > SupplierVector;
+  //! Maps the event types to their ids.
+  typedef std::map< TypePair, ACE_UINT16, LtType > TypeIDMap;
 
 public:
   LogFile(QString const& _name,
@@ -91,18 +97,42 @@ public:
   ~LogFile();
 
   QString const& name() const;
-  ACE_Time_Value const& startTime() const;
-  ACE_Time_Value const& endTime() const;
+  ACE_Time_Value startTime() const;
+  ACE_Time_Value endTime() const;
 
-  ACE_Time_Value const& coursorTime() const;
+  ACE_Time_Value coursorTime() const;
   void coursorTime(ACE_Time_Value const& _t);
 
+  //! Number of events of the parsed log file.
+  unsigned int events() const;
+  //! Time stamp of the event at position @ref _index.
+  ACE_Time_Value eventTime(unsigned int _index) const;
+  //! Set the coursor to the event at position @ref _index.
+  /** Returns false, if the event is excluded. */
+  bool seekEvent(unsigned int _index);
+  //! Flag indicating the event type of the event is excluded.
+  bool excluded(unsigned int _index) const;
+  //! Copy the event at position @ref _index into the log of the extractor.
+  /** Returns false, if the log file is full. */
+  bool copyEvent(unsigned int _index, Miro::LogExtractor& _extractor);
+  //! The reader of the log file.
+  Miro::LogReader& logReader();
+
   void sendEvent();
   bool nextEvent();
   bool prevEvent();
   bool getCurrentEvent();
   CosNotification::StructuredEvent const& currentEvent() const;
 
+  //! Scan the next chunk of events, returns the progress in percent.
+  /**
+   * Does not touch the ORB or Qt, so log files can be scanned by
+   * worker threads. The log file is parsed, once it returns 100.
+   */
+  unsigned int scan();
+  //! Connect the suppliers for the event types of the parsed log file.
+  void connectSuppliers();
+  //! Scan the next chunk and connect the suppliers, once done.
   unsigned int parse();
   bool parsed() const;
   void parseEvent();
@@ -114,8 +144,6 @@ public:
   CStringMap const& eventTypes() const;
 
   void setTimeOffset(ACE_Time_Value const& _offset);
-  bool assertBefore(ACE_Time_Value const& _t);
-  bool assertAfter(ACE_Time_Value const& _t);
 
 
 signals:
@@ -123,7 +151,12 @@ signals:
   void newEvent(QString const&,QString const&,QString const&,QString const&);
 
 protected:
-  bool validEvent();
+  //! Position the log reader at the coursor and parse the event.
+  void parseCoursorEvent();
+  //! Id of the event type, interned on first sight.
+  ACE_UINT16 typeID(char const * _domainName, char const * _typeName);
+  //! Save the scanned event index as sidecar index of the log file.
+  void writeSidecar();
 
   QString name_;
   ChannelManager * const channelManager_;
@@ -135,16 +168,21 @@ protected:
   QString eventName_;
 
   ACE_Time_Value timeOffset_;
-  TimeVector timeVector_;
-  TimeVector::const_iterator coursor_;
+  //! Time stamp and file offset of the events.
+  EventIndex events_;
+  //! Position of the current event.
+  unsigned int coursor_;
 
   CStringMap eventTypes_;
-  char const * currentDomainName_;
-  CStringMap::iterator currentDomainEvents_;
+  //! The ids of the event types of the log file.
+  TypeIDMap typeIDs_;
+  //! The event type of the previously scanned event.
+  TypeIDMap::const_iterator currentType_;
 
   SupplierVector suppliers_;
 
-  CStringMap exclude_;
+  //! Exclusion flags, indexed by event type id.
+  std::vector<bool> excluded_;
 
   Miro::LogReader logReader_;
   unsigned int counter_;
@@ -159,33 +197,62 @@ LogFile::name() const
 }
 
 inline
-ACE_Time_Value const&
+ACE_Time_Value
 LogFile::startTime() const
 {
-  assert(timeVector_.size() != 0);
-  return timeVector_.front().first;
+  assert(!events_.empty());
+  return events_.stamp(0);
 }
 
 inline
-ACE_Time_Value const&
+ACE_Time_Value
 LogFile::endTime() const
 {
-  assert(timeVector_.size() != 0);
-  return timeVector_.back().first;
+  assert(!events_.empty());
+  return events_.stamp(events_.size() - 1);
 }
 
 inline
-ACE_Time_Value const&
+ACE_Time_Value
 LogFile::coursorTime() const
 {
-  return (coursor_ != timeVector_.end())? coursor_->first : ACE_Time_Value::max_time;
+  return (coursor_ < events_.size())? events_.stamp(coursor_) : ACE_Time_Value::max_time;
 }
 
 inline
 void
 LogFile::coursorTime(ACE_Time_Value const& _t)
 {
-  coursor_ = std::lower_bound(timeVector_.begin(), timeVector_.end(), TimePair(_t, (const char*)NULL), TVLess());
+  coursor_ = events_.lowerBound(_t);
+}
+
+inline
+bool
+LogFile::excluded(unsigned int _index) const
+{
+  return excluded_[events_.type(_index)];
+}
+
+inline
+Miro::LogReader&
+LogFile::logReader()
+{
+  return logReader_;
+}
+
+inline
+unsigned int
+LogFile::events() const
+{
+  return events_.size();
+}
+
+inline
+ACE_Time_Value
+LogFile::eventTime(unsigned int _index) const
+{
+  assert(_index < events_.size());
+  return events_.stamp(_index);
 }
 
 inline
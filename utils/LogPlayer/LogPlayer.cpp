@@ -223,11 +223,13 @@ main(int argc, char *argv[])
         channelManager.detach(4);
 
         // parse remaining args
+        QStringList files;
         for (int i = 1; i < argc; ++i) {
           if (verbose)
             std::cout << "using file " << argv[i] << std::endl;
-          mainWindow.loadFile(argv[i]);
+          files.append(argv[i]);
         }
+        mainWindow.loadFiles(files);
         if (verbose)
           std::cout << "files loaded." << std::endl;
 
@@ -29,6 +29,7 @@
 #include "MainForm.h"
 #include "LogFile.h"
 #include "FileSet.h"
+#include "FileIndexer.h"
 #include "EventView.h"
 #include "ChannelManager.h"
 
@@ -42,6 +43,7 @@
 
 #define INCLUDE_MENUITEM_DEF
 #include <qapplication.h>
+#include <qeventloop.h>
 #ifdef LSB_Q3POPUPMENU
 #include <QMenu>
 #else
@@ -518,12 +520,13 @@ MainForm::files()
         fileSet_.delFile(*first);
     }
 
+    QStringList addedFiles;
     last = newFiles.end();
     for (first = newFiles.begin(); first != last; ++first) {
       if (oldFiles.find(*first) == oldFiles.end())
-        loadFile(*first);
+        addedFiles.append(*first);
     }
-    enableButtons(fileSet_.size() != 0);
+    loadFiles(addedFiles);
   }
 }
 
@@ -688,49 +691,105 @@ MainForm::setSpeed(int _speed)
 void
 MainForm::loadFile(QString const & _name )
 {
-  try {
-    LogFile * file = fileSet_.addFile(_name);
+  loadFiles(QStringList(_name));
+}
+
+void
+MainForm::loadFiles(QStringList const & _names)
+{
+  // open the log files
+  FileIndexer::FileVector files;
+  QStringList::const_iterator first, last = _names.end();
+  for (first = _names.begin(); first != last; ++first) {
     try {
-#ifdef LSB_Q3PROGRESSDIALOG
-      const QString labelText("Parsing log file " + _name);
-      const QString cancelButtonText("Cancel");
-      const int minimum = 0;
-      const int maximum = 100;
-      QWidget * const parent = this;
-      QProgressDialog progress(labelText, cancelButtonText, minimum, maximum,
-			       parent);
-      progress.setValue(0);
-#else
-      Q3ProgressDialog progress("Parsing log file " + _name, "Cancel", 100,
-                                this, "progress", TRUE);
-      progress.setProgress(0);
-#endif
-      int percent;
+      files.push_back(fileSet_.addFile(*first));
+    }
+    catch (Miro::CException const& e) {
+      QMessageBox::warning(this, "Error loading file:",
+                           QString("File ") + *first + QString(":\n") +
+                           QString(e.what()));
+    }
+    catch (Miro::Exception const& e) {
+      QMessageBox::warning(this, "Error parsing file:",
+                           QString("File ") + *first + QString(":\n") +
+                           QString(e.what()));
+    }
+  }
 
-      while ((percent = file->parse()) != 100) {
+  if (!files.empty()) {
+    // index them on a worker thread pool
+    FileIndexer indexer(files);
+    QString const labelText = (files.size() == 1)?
+      QString("Parsing log file ") + files.front()->name() :
+      QString("Parsing %1 log files").arg(files.size());
 #ifdef LSB_Q3PROGRESSDIALOG
-	progress.setValue(percent);
+    const QString cancelButtonText("Cancel");
+    const int minimum = 0;
+    const int maximum = 100;
+    QWidget * const parent = this;
+    QProgressDialog progress(labelText, cancelButtonText, minimum, maximum,
+                             parent);
+    progress.setValue(0);
+    connect(&indexer, SIGNAL(progress(int)), &progress, SLOT(setValue(int)),
+            Qt::QueuedConnection);
 #else
-        progress.setProgress(percent);
+    Q3ProgressDialog progress(labelText, "Cancel", 100,
+                              this, "progress", TRUE);
+    progress.setProgress(0);
+    connect(&indexer, SIGNAL(progress(int)), &progress, SLOT(setProgress(int)),
+            Qt::QueuedConnection);
 #endif
-        qApp->processEvents();
+
+    // the workers wake up the local event loop, once all of them are done
+    QEventLoop loop;
+    connect(&indexer, SIGNAL(finished()), &loop, SLOT(quit()),
+            Qt::QueuedConnection);
 #ifdef LSB_Q3PROGRESSDIALOG
-	if (progress.wasCanceled())
+    connect(&progress, SIGNAL(canceled()), &indexer, SLOT(cancel()));
 #else
-        if (progress.wasCancelled())
+    connect(&progress, SIGNAL(cancelled()), &indexer, SLOT(cancel()));
 #endif
-          throw Miro::Exception("canceled");
-      }
+
+    indexer.start();
+    // a quit queued before exec() is delivered once the loop runs,
+    // so the wakeup cannot get lost between the check and exec()
+    if (!indexer.done())
+      loop.exec();
+    indexer.wait();
+    // drop the pending progress reports
+    disconnect(&indexer, 0, &progress, 0);
 #ifdef LSB_Q3PROGRESSDIALOG
-      progress.setValue(100);
+    progress.setValue(100);
 #endif
 
-      if (file->endTime() > ACE_OS::gettimeofday())
-        throw Miro::Exception("Clock screw detected:\nEnd time of file lies in the future.");
+    // drop the files, that failed, before the others get used
+    FileIndexer::FileVector loaded;
+    FileIndexer::FileVector::const_iterator f, l = files.end();
+    for (f = files.begin(); f != l; ++f) {
+      QString const name = (*f)->name();
+      QString error = indexer.error(*f);
+      if (error.isEmpty() && !(*f)->parsed())
+        error = "canceled";
+      if (error.isEmpty() && (*f)->endTime() > ACE_OS::gettimeofday())
+        error = "Clock screw detected:\nEnd time of file lies in the future.";
+
+      if (error.isEmpty()) {
+        loaded.push_back(*f);
+      }
+      else {
+        fileSet_.delFile(name);
+        if (error == "canceled")
+          statusBar()->message("loading file canceled.", 5000);
+        else
+          QMessageBox::warning(this, "Error parsing file:",
+                               QString("File ") + name + QString(":\n") + error);
+      }
+    }
 
-      statusBar()->message(QString("loaded file: ") + _name, 5000);
-      fileSet_.calcStartEndTime();
-      fileSet_.coursorTime(fileSet_.cutStartTime());
+    // the suppliers are set up, once all indices are ready
+    for (f = loaded.begin(), l = loaded.end(); f != l; ++f) {
+      LogFile * const file = *f;
+      file->connectSuppliers();
 
       connect(file, SIGNAL(notifyEvent(const QString&)),
               statusBar(), SLOT(message(const QString&)));
@@ -743,26 +802,16 @@ MainForm::loadFile(QString const & _name )
                 eventView_, SLOT(insertEvent(const QString&,const QString&,const QString&,const QString&)));
       }
     }
-    catch (Miro::Exception const& e) {
-      fileSet_.delFile(_name);
-      if (strcmp("canceled", e.what()) == 0)
-        statusBar()->message("loading file canceled.", 5000);
-      else
-        QMessageBox::warning(this, "Error parsing file:",
-                             QString("File ") + _name + QString(":\n") +
-                             QString(e.what()));
+
+    if (!loaded.empty()) {
+      statusBar()->message((loaded.size() == 1)?
+                           QString("loaded file: ") + loaded.front()->name() :
+                           QString("loaded %1 files").arg(loaded.size()), 5000);
+      fileSet_.calcStartEndTime();
+      fileSet_.coursorTime(fileSet_.cutStartTime());
     }
   }
-  catch (Miro::CException const& e) {
-    QMessageBox::warning(this, "Error loading file:",
-                         QString("File ") + _name + QString(":\n") +
-                         QString(e.what()));
-  }
-  catch (Miro::Exception const& e) {
-    QMessageBox::warning(this, "Error parsing file:",
-                         QString("File ") + _name + QString(":\n") +
-                         QString(e.what()));
-  }
+
   createEventMenu();
   enableButtons(fileSet_.size() != 0);
 }
@@ -926,7 +975,19 @@ MainForm::saveAs()
       file.setFile(filename);
     }
     // save the file
-    fileSet_.saveCut(filename);
+    try {
+      fileSet_.saveCut(filename);
+    }
+    catch (Miro::CException const& e) {
+      QMessageBox::warning(this, "Error saving file:",
+                           QString("File ") + filename + QString(":\n") +
+                           QString(e.what()));
+    }
+    catch (Miro::Exception const& e) {
+      QMessageBox::warning(this, "Error saving file:",
+                           QString("File ") + filename + QString(":\n") +
+                           QString(e.what()));
+    }
   }
 }
 
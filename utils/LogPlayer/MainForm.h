@@ -34,6 +34,7 @@
 #include <q3mainwindow.h>
 #endif
 #include <qstring.h>
+#include <qstringlist.h>
 
 #ifdef LSB_Q3POPUPMENU
 #else
@@ -105,6 +106,8 @@ public:
            QWidget * parent = 0, const char * name = 0 );
 
   void loadFile(QString const & _name);
+  //! Load a set of log files, indexing them in parallel.
+  void loadFiles(QStringList const & _names);
   void calcStartTime();
 
   void addExclude(QString const & _eventName);
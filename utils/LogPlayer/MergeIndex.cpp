@@ -0,0 +1,56 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "MergeIndex.h"
+
+MergeIndex::MergeIndex() :
+  files_(0)
+{}
+
+void
+MergeIndex::clear(unsigned int _files)
+{
+  files_ = _files;
+  std::vector<ACE_UINT16>().swap(file_);
+  std::vector<ACE_UINT16>().swap(position_);
+  std::vector<unsigned int>().swap(checkpoints_);
+  next_.assign(_files, 0);
+}
+
+void
+MergeIndex::reserve(unsigned int _events)
+{
+  file_.reserve(_events);
+  position_.reserve(_events);
+  checkpoints_.reserve((_events / CHECKPOINT_INTERVAL + 1) * files_);
+}
+
+void
+MergeIndex::push_back(ACE_UINT16 _file)
+{
+  unsigned int const checkpoint = file_.size() / CHECKPOINT_INTERVAL;
+  if (file_.size() % CHECKPOINT_INTERVAL == 0)
+    checkpoints_.insert(checkpoints_.end(), next_.begin(), next_.end());
+
+  file_.push_back(_file);
+  position_.push_back(static_cast<ACE_UINT16>(next_[_file] -
+                                              checkpoints_[checkpoint * files_ + _file]));
+  ++next_[_file];
+}
@@ -0,0 +1,106 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#ifndef MergeIndex_h
+#define MergeIndex_h
+
+#include <ace/Basic_Types.h>
+
+#include <vector>
+
+//! Time ordered sequence of the events of multiple log files.
+/**
+ * Holds the 16 bit id of the log file of each event of the merged
+ * sequence and the 16 bit position of the event within its log file,
+ * relative to the last checkpoint. The checkpoints note the positions
+ * of all log files every CHECKPOINT_INTERVAL events. So an event is
+ * 4 bytes, and looking up its position costs the same, whether
+ * stepping forward, backward or probing at random.
+ */
+class MergeIndex
+{
+public:
+  //----------------------------------------------------------------------------
+  // public constants
+  //----------------------------------------------------------------------------
+
+  //! Number of events between checkpoints, bounded by the relative positions.
+  static unsigned int const CHECKPOINT_INTERVAL = 0x10000;
+
+  //----------------------------------------------------------------------------
+  // public methods
+  //----------------------------------------------------------------------------
+  MergeIndex();
+
+  //! Start a new sequence of the events of @ref _files log files.
+  void clear(unsigned int _files = 0);
+  //! Prepare for the given number of events.
+  void reserve(unsigned int _events);
+  //! Append the next event of the log file @ref _file.
+  void push_back(ACE_UINT16 _file);
+
+  //! Number of events.
+  unsigned int size() const;
+  //! Log file of an event.
+  ACE_UINT16 file(unsigned int _index) const;
+  //! Position of an event within its log file.
+  unsigned int event(unsigned int _index) const;
+
+protected:
+  //----------------------------------------------------------------------------
+  // protected data
+  //----------------------------------------------------------------------------
+
+  //! Number of log files.
+  unsigned int files_;
+  //! Log file of each event.
+  std::vector<ACE_UINT16> file_;
+  //! Position of each event within its log file, relative to its checkpoint.
+  std::vector<ACE_UINT16> position_;
+  //! Positions of the log files at each checkpoint, checkpoint by checkpoint.
+  std::vector<unsigned int> checkpoints_;
+  //! Positions of the log files behind the last event.
+  std::vector<unsigned int> next_;
+};
+
+inline
+unsigned int
+MergeIndex::size() const
+{
+  return file_.size();
+}
+
+inline
+ACE_UINT16
+MergeIndex::file(unsigned int _index) const
+{
+  return file_[_index];
+}
+
+inline
+unsigned int
+MergeIndex::event(unsigned int _index) const
+{
+  return
+    checkpoints_[(_index / CHECKPOINT_INTERVAL) * files_ + file_[_index]] +
+    position_[_index];
+}
+
+#endif // MergeIndex_h
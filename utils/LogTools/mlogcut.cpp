@@ -0,0 +1,209 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogExtractor.h"
+#include "miro/LogReader.h"
+#include "miro/LogWriter.h"
+#include "miro/Client.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/High_Res_Timer.h>
+#include <ace/OS_NS_stdlib.h>
+
+#include <iomanip>
+#include <string>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+  typedef std::pair<std::string, std::string> TypeFilter;
+  typedef std::vector<TypeFilter> FilterVector;
+
+  double from = -1.;
+  double to = -1.;
+  bool verbose = false;
+
+  char const fromOpt[] = "-from";
+  char const toOpt[] = "-to";
+  char const includeOpt[] = "-i";
+  char const excludeOpt[] = "-x";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+
+  //! Split domain/type, the type name is optional.
+  TypeFilter
+  typeFilter(std::string const& _arg)
+  {
+    std::string::size_type const pos = _arg.find('/');
+    if (pos == std::string::npos)
+      return std::make_pair(_arg, std::string());
+    return std::make_pair(_arg.substr(0, pos), _arg.substr(pos + 1));
+  }
+
+  //! Time offset in seconds.
+  ACE_Time_Value
+  offset(double _sec)
+  {
+    ACE_Time_Value t;
+    t.set(_sec);
+    return t;
+  }
+
+  //! Time stamp of the first event of the log file.
+  ACE_Time_Value
+  startTime(std::string const& _fileName)
+  {
+    Miro::LogReader reader(_fileName);
+    ACE_Time_Value t = ACE_Time_Value::zero;
+    if (reader.hasIndex()) {
+      if (reader.indexSize() != 0)
+        t = reader.indexTime(0);
+    }
+    else {
+      reader.parseTimeStamp(t);
+    }
+    return t;
+  }
+};
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Client client(argc, argv);
+
+    FilterVector includes;
+    FilterVector excludes;
+    std::vector<std::string> files;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, fromOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          from = ACE_OS::strtod(arg_shifter.get_current(), NULL);
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, toOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          to = ACE_OS::strtod(arg_shifter.get_current(), NULL);
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, includeOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          includes.push_back(typeFilter(arg_shifter.get_current()));
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, excludeOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          excludes.push_back(typeFilter(arg_shifter.get_current()));
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " [-from <sec>] [-to <sec>] [-i <domain>[/<type>]] [-x <domain>[/<type>]] [-v] <in> <out>" << std::endl
+                  << "  Cut a time interval and event types out of a log file." << std::endl
+                  << "  The events are copied as marshalled records." << std::endl
+                  << "  -from <sec>  start of the cut, relative to the first event" << std::endl
+                  << "  -to <sec>    end of the cut, relative to the first event" << std::endl
+                  << "  -i <type>    keep only this event type (repeatable)" << std::endl
+                  << "  -x <type>    leave out this event type (repeatable)" << std::endl
+                  << "  -v           verbose mode" << std::endl
+                  << "  -?           help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        files.push_back(current_arg);
+        arg_shifter.consume_arg();
+      }
+    }
+
+    if (files.size() != 2) {
+      std::cerr << "input and output log file required. use -? for help." << std::endl;
+      return 1;
+    }
+
+    // the cut interval
+    ACE_Time_Value const start = startTime(files[0]);
+    ACE_Time_Value const first = (from >= 0.)? start + offset(from) : ACE_Time_Value::zero;
+    ACE_Time_Value const last = (to >= 0.)? start + offset(to) : ACE_Time_Value::max_time;
+
+    // a plain log file, record copies are not supported for compressed ones
+    Miro::LogNotifyParameters parameters(*Miro::LogNotifyParameters::instance());
+    parameters.compress = false;
+    parameters.maxFileSize = static_cast<unsigned long>(-1);
+
+    Miro::LogReader reader(files[0]);
+    Miro::LogWriter writer(files[1], parameters);
+    Miro::LogExtractor extractor(reader, writer);
+
+    FilterVector::const_iterator f, l = includes.end();
+    for (f = includes.begin(); f != l; ++f)
+      extractor.include(f->first, f->second);
+    for (f = excludes.begin(), l = excludes.end(); f != l; ++f)
+      extractor.exclude(f->first, f->second);
+
+    ACE_High_Res_Timer timer;
+    timer.start();
+    ACE_UINT32 const events = extractor.extract(first, last);
+    timer.stop();
+
+    ACE_Time_Value elapsed;
+    timer.elapsed_time(elapsed);
+
+    std::cout << "copied " << events << " events";
+    if (verbose) {
+      std::cout << " in " << elapsed.sec() << "." << std::setw(6) << std::setfill('0') << elapsed.usec()
+                << " sec"
+                << (extractor.raw()? " as records" : " demarshalled")
+                << (extractor.raw() && !extractor.identity()? ", type ids translated" : "");
+    }
+    std::cout << "." << std::endl;
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}
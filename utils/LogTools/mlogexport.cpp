@@ -0,0 +1,153 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogColumnExporter.h"
+#include "miro/Client.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/High_Res_Timer.h>
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_string.h>
+
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+  typedef std::vector<std::string> StringVector;
+
+  std::string directory = ".";
+  StringVector types;
+  int threads = 0;
+  bool verbose = false;
+
+  char const directoryOpt[] = "-o";
+  char const typeOpt[] = "-type";
+  char const threadsOpt[] = "-j";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+};
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Client client(argc, argv);
+
+    std::string fileName;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, directoryOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          directory = arg_shifter.get_current();
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, typeOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          types.push_back(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, threadsOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          threads = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " [-o <directory>] [-type <name>]... [-j <threads>] [-v] <log file>" << std::endl
+                  << "  Export the event bodies of a log file into column files per type." << std::endl
+                  << "  -o <directory>   output directory (default: .)" << std::endl
+                  << "  -type <name>     export the type of the name or repository id only (default: all)" << std::endl
+                  << "  -j <threads>     number of worker threads (default: number of cpus)" << std::endl
+                  << "  -v               verbose mode" << std::endl
+                  << "  -?               help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        fileName = current_arg;
+        arg_shifter.consume_arg();
+      }
+    }
+
+    if (fileName.empty()) {
+      std::cerr << "no log file given. use -? for help." << std::endl;
+      return 1;
+    }
+
+    ACE_High_Res_Timer timer;
+    timer.start();
+    Miro::LogColumnExporter exporter(fileName);
+    StringVector::const_iterator first, last = types.end();
+    for (first = types.begin(); first != last; ++first)
+      exporter.select(*first);
+    ACE_UINT64 const events = exporter.exportTypes(directory, threads);
+    timer.stop();
+
+    if (verbose) {
+      for (ACE_INT32 id = 0; id < exporter.types(); ++id) {
+        Miro::LogColumnPlan const * const plan = exporter.plan(id);
+        if (plan == NULL) {
+          std::cout << std::setw(4) << id << "  not exportable" << std::endl;
+          continue;
+        }
+        std::cout << std::setw(4) << id << "  " << exporter.typeDirectory(id)
+                  << ": " << plan->columns().size() << " columns, "
+                  << plan->tables().size() << " tables";
+        if (!plan->skipped().empty())
+          std::cout << ", " << plan->skipped().size() << " members skipped";
+        std::cout << std::endl;
+      }
+
+      ACE_Time_Value elapsed;
+      timer.elapsed_time(elapsed);
+      std::cout << "exported " << events << " events in "
+                << elapsed.sec() + elapsed.usec() / 1000000. << " sec." << std::endl;
+    }
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}
@@ -0,0 +1,217 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogIndexFile.h"
+#include "miro/LogFieldIndexFile.h"
+#include "miro/Client.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/Dirent.h>
+#include <ace/Task.h>
+#include <ace/Synch.h>
+#include <ace/OS_NS_unistd.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+  typedef std::vector<std::string> StringVector;
+
+  char const * const LOG_SUFFIX = ".mlog";
+
+  StringVector fields;
+  bool force = false;
+  bool verbose = false;
+  int threads = 0;
+
+  char const fieldOpt[] = "-field";
+  char const forceOpt[] = "-f";
+  char const threadsOpt[] = "-j";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+
+  bool
+  isLogFile(std::string const& _name)
+  {
+    size_t const len = ACE_OS::strlen(LOG_SUFFIX);
+    return _name.length() > len &&
+      _name.compare(_name.length() - len, len, LOG_SUFFIX) == 0;
+  }
+
+  //! Worker pool building the sidecar indices.
+  class IndexBuilder : public ACE_Task_Base
+  {
+  public:
+    IndexBuilder(StringVector const& _files) :
+        files_(_files),
+        next_(0),
+        built_(0),
+        failed_(0)
+    {}
+
+    virtual int svc()
+    {
+      while (true) {
+        std::string file;
+        {
+          ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+          if (next_ == files_.size())
+            break;
+          file = files_[next_++];
+        }
+
+        try {
+          if (force) {
+            ACE_OS::unlink(Miro::LogIndexFile::fileName(file).c_str());
+            ACE_OS::unlink(Miro::LogFieldIndexFile::fileName(file).c_str());
+          }
+          bool built = Miro::LogIndexFile::build(file);
+          if (!fields.empty() &&
+              Miro::LogFieldIndexFile::build(file, fields))
+            built = true;
+
+          ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+          if (built)
+            ++built_;
+          if (verbose)
+            std::cout << file << (built? ": indexed" : ": up to date") << std::endl;
+        }
+        catch (Miro::Exception const& e) {
+          ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+          ++failed_;
+          std::cerr << file << ": " << e << std::endl;
+        }
+      }
+      return 0;
+    }
+
+    unsigned int built() const { return built_; }
+    unsigned int failed() const { return failed_; }
+
+  protected:
+    ACE_Thread_Mutex mutex_;
+    StringVector const& files_;
+    size_t next_;
+    unsigned int built_;
+    unsigned int failed_;
+  };
+}
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Client client(argc, argv);
+
+    StringVector files;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, fieldOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          fields.push_back(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, forceOpt) == 0) {
+        arg_shifter.consume_arg();
+        force = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, threadsOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          threads = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " [-f] [-field <name>]... [-j <threads>] [-v] <directory|file>..." << std::endl
+                  << "  Prebuild the sidecar indices (.mlog.idx) of log files." << std::endl
+                  << "  -f  rebuild existing sidecar indices" << std::endl
+                  << "  -field  also index the filterable data field (.mlog.fdx)" << std::endl
+                  << "  -j  number of worker threads (default: number of cpus)" << std::endl
+                  << "  -v  verbose mode" << std::endl
+                  << "  -?  help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        std::string const path = current_arg;
+        arg_shifter.consume_arg();
+
+        ACE_Dirent dir;
+        if (dir.open(path.c_str()) == 0) {
+          ACE_DIRENT * entry;
+          while ((entry = dir.read()) != NULL) {
+            std::string const name = entry->d_name;
+            if (isLogFile(name))
+              files.push_back(path + "/" + name);
+          }
+        }
+        else {
+          files.push_back(path);
+        }
+      }
+    }
+
+    if (files.empty()) {
+      std::cerr << "no log files given. use -? for help." << std::endl;
+      return 1;
+    }
+
+    if (threads <= 0)
+      threads = ACE_OS::num_processors_online();
+    if (threads <= 0)
+      threads = 1;
+    if (static_cast<size_t>(threads) > files.size())
+      threads = files.size();
+
+    IndexBuilder builder(files);
+    builder.activate(THR_NEW_LWP | THR_JOINABLE, threads);
+    builder.wait();
+
+    std::cout << "indexed " << builder.built() << " of " << files.size()
+              << " log files, " << builder.failed() << " failed." << std::endl;
+    rc = (builder.failed() == 0)? 0 : 1;
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}
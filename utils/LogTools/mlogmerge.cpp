@@ -0,0 +1,161 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogMerger.h"
+#include "miro/Client.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/Dirent.h>
+#include <ace/High_Res_Timer.h>
+#include <ace/OS_NS_stdlib.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+  char const * const LOG_SUFFIX = ".mlog";
+
+  std::string output;
+  int fanIn = 256;
+  bool verbose = false;
+
+  char const outputOpt[] = "-o";
+  char const fanInOpt[] = "-fanin";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+
+  bool
+  isLogFile(std::string const& _name)
+  {
+    size_t const len = ACE_OS::strlen(LOG_SUFFIX);
+    return _name.length() > len &&
+      _name.compare(_name.length() - len, len, LOG_SUFFIX) == 0;
+  }
+};
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Client client(argc, argv);
+
+    Miro::LogMerger::FileVector files;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, outputOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          output = arg_shifter.get_current();
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, fanInOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          fanIn = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " -o <out> [-fanin <n>] [-v] <directory|file>..." << std::endl
+                  << "  Merge log files into one, ordered by time stamp." << std::endl
+                  << "  The events are copied as marshalled records." << std::endl
+                  << "  -o <out>     the merged log file" << std::endl
+                  << "  -fanin <n>   maximum number of files merged at once (default 256)" << std::endl
+                  << "  -v           verbose mode" << std::endl
+                  << "  -?           help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        std::string const path = current_arg;
+        arg_shifter.consume_arg();
+
+        ACE_Dirent dir;
+        if (dir.open(path.c_str()) == 0) {
+          Miro::LogMerger::FileVector dirFiles;
+          ACE_DIRENT * entry;
+          while ((entry = dir.read()) != NULL) {
+            std::string const name = entry->d_name;
+            if (isLogFile(name))
+              dirFiles.push_back(path + "/" + name);
+          }
+          // segments in order of their numbers
+          std::sort(dirFiles.begin(), dirFiles.end());
+          files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+        }
+        else {
+          files.push_back(path);
+        }
+      }
+    }
+
+    if (output.empty() || files.empty()) {
+      std::cerr << "output and input log files required. use -? for help." << std::endl;
+      return 1;
+    }
+    if (fanIn < 2) {
+      std::cerr << "invalid fan in. use -? for help." << std::endl;
+      return 1;
+    }
+
+    Miro::LogMerger merger(files, fanIn);
+
+    ACE_High_Res_Timer timer;
+    timer.start();
+    ACE_UINT32 const events = merger.merge(output);
+    timer.stop();
+
+    ACE_Time_Value elapsed;
+    timer.elapsed_time(elapsed);
+
+    std::cout << "merged " << events << " events of " << files.size() << " log files";
+    if (verbose) {
+      std::cout << " in " << elapsed.sec() << "." << std::setw(6) << std::setfill('0') << elapsed.usec()
+                << " sec, " << merger.passes() << " passes";
+    }
+    std::cout << "." << std::endl;
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}
@@ -0,0 +1,163 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogReplay.h"
+#include "miro/Server.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+#include "miro/TimeHelper.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+  double speed = 1.;
+  unsigned int prefetch = 1024;
+  std::string channelName = "EventChannel";
+  bool dryRun = false;
+  bool verbose = false;
+
+  char const speedOpt[] = "-speed";
+  char const afapOpt[] = "-afap";
+  char const prefetchOpt[] = "-prefetch";
+  char const channelOpt[] = "-channel";
+  char const dryRunOpt[] = "-n";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+};
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Server server(argc, argv);
+
+    std::vector<std::string> files;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, speedOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_parameter_next()) {
+          speed = ACE_OS::strtod(arg_shifter.get_current(), NULL);
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, afapOpt) == 0) {
+        arg_shifter.consume_arg();
+        speed = 0.;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, prefetchOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_parameter_next()) {
+          prefetch = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, channelOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_parameter_next()) {
+          channelName = arg_shifter.get_current();
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, dryRunOpt) == 0) {
+        arg_shifter.consume_arg();
+        dryRun = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " [-speed <factor>] [-afap] [-prefetch <n>] [-channel <name>] [-n] [-v] <file> ..." << std::endl
+                  << "  Replay log files into the event channels, without GUI." << std::endl
+                  << "  -speed <factor>  replay speed factor (default 1)" << std::endl
+                  << "  -afap  replay as fast as possible" << std::endl
+                  << "  -prefetch <n>  number of events decoded ahead (default 1024)" << std::endl
+                  << "  -channel <name>  name of the event channels (default EventChannel)" << std::endl
+                  << "  -n  dry run: schedule the events, but do not send them" << std::endl
+                  << "  -v  verbose mode" << std::endl
+                  << "  -?  help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        files.push_back(current_arg);
+        arg_shifter.consume_arg();
+      }
+    }
+
+    if (files.empty()) {
+      std::cerr << "no log files given. use -? for help." << std::endl;
+      return 1;
+    }
+    if (speed < 0. || prefetch == 0) {
+      std::cerr << "invalid speed or prefetch depth. use -? for help." << std::endl;
+      return 1;
+    }
+
+    // the suppliers need the orb running
+    server.detach(1);
+    {
+      Miro::LogReplay replay(files, (dryRun)? NULL : &server,
+                             channelName, speed, prefetch);
+      if (verbose) {
+        std::cerr << "replaying " << replay.events() << " events of "
+                  << files.size() << " log files" << std::endl;
+      }
+
+      ACE_Time_Value const start = ACE_OS::gettimeofday();
+      replay.start();
+      replay.wait();
+      ACE_Time_Value const duration = ACE_OS::gettimeofday() - start;
+
+      std::cout << replay.sent() << " events replayed in " << duration << "s" << std::endl;
+      if (speed > 0.) {
+        Miro::TimeStats const stats = replay.lateness();
+        std::cout << "lateness - " << stats
+                  << replay.late() << " events later than "
+                  << Miro::LogReplay::LATE << "s" << std::endl;
+      }
+    }
+    server.shutdown();
+    server.wait();
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}
@@ -0,0 +1,388 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogScanner.h"
+#include "miro/Client.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/Dirent.h>
+#include <ace/High_Res_Timer.h>
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_string.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+  typedef std::vector<std::string> StringVector;
+
+  char const * const LOG_SUFFIX = ".mlog";
+
+  int threads = 0;
+  int rangeSize = 65536;
+  int binSize = 1;
+  bool histogram = false;
+  bool bodies = false;
+  bool verbose = false;
+  Miro::LogReader::Access access = Miro::LogReader::SEQUENTIAL;
+
+  char const threadsOpt[] = "-j";
+  char const rangeOpt[] = "-range";
+  char const binOpt[] = "-bin";
+  char const histogramOpt[] = "-hist";
+  char const bodiesOpt[] = "-bodies";
+  char const accessOpt[] = "-access";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+
+  bool
+  isLogFile(std::string const& _name)
+  {
+    size_t const len = ACE_OS::strlen(LOG_SUFFIX);
+    return _name.length() > len &&
+      _name.compare(_name.length() - len, len, LOG_SUFFIX) == 0;
+  }
+
+  double
+  msec(ACE_Time_Value const& _t)
+  {
+    return _t.sec() * 1000. + _t.usec() / 1000.;
+  }
+
+  //! Statistics of an event type.
+  struct TypeStats
+  {
+    std::string domainName;
+    std::string typeName;
+    ACE_UINT64 events;
+    ACE_UINT64 bytes;
+    //! Time stamps of the first and last event.
+    ACE_Time_Value first;
+    ACE_Time_Value last;
+    //! Log files of the first and last event, gaps are measured within a file.
+    unsigned int firstFile;
+    unsigned int lastFile;
+    //! Inter-arrival gaps.
+    ACE_UINT64 gaps;
+    ACE_Time_Value sumGap;
+    ACE_Time_Value minGap;
+    ACE_Time_Value maxGap;
+
+    TypeStats(char const * _domainName, char const * _typeName) :
+        domainName(_domainName),
+        typeName(_typeName),
+        events(0),
+        bytes(0),
+        firstFile(0),
+        lastFile(0),
+        gaps(0),
+        minGap(ACE_Time_Value::max_time)
+    {}
+
+    void gap(ACE_Time_Value const& _gap)
+    {
+      ++gaps;
+      sumGap += _gap;
+      minGap = std::min(minGap, _gap);
+      maxGap = std::max(maxGap, _gap);
+    }
+  };
+
+  //! Event counts, sizes, rates and gaps per event type.
+  class StatReducer : public Miro::LogScanReducer
+  {
+  public:
+    typedef std::vector<TypeStats> TypeVector;
+    //! Number of events per time bin.
+    typedef std::map<ACE_INT64, ACE_UINT64> Histogram;
+
+    StatReducer() : hit_(0) {}
+
+    virtual Miro::LogScanReducer * clone() const
+    {
+      return new StatReducer();
+    }
+
+    virtual void event(unsigned int _file,
+                       ACE_Time_Value const& _stamp, size_t _length,
+                       CosNotification::EventType const& _type,
+                       CosNotification::StructuredEvent const *)
+    {
+      TypeStats& stats = find(_type.domain_name, _type.type_name);
+      if (stats.events == 0) {
+        stats.first = _stamp;
+        stats.firstFile = _file;
+      }
+      else if (stats.lastFile == _file) {
+        stats.gap(_stamp - stats.last);
+      }
+      stats.last = _stamp;
+      stats.lastFile = _file;
+      ++stats.events;
+      stats.bytes += _length;
+
+      ++histogram_[_stamp.sec() / binSize];
+    }
+
+    virtual void reduce(Miro::LogScanReducer const& _next)
+    {
+      StatReducer const& next = static_cast<StatReducer const&>(_next);
+
+      TypeVector::const_iterator first, last = next.types_.end();
+      for (first = next.types_.begin(); first != last; ++first) {
+        TypeStats& stats = find(first->domainName.c_str(), first->typeName.c_str());
+        if (stats.events == 0) {
+          stats.first = first->first;
+          stats.firstFile = first->firstFile;
+        }
+        // the gap across the range boundary
+        else if (stats.lastFile == first->firstFile) {
+          stats.gap(first->first - stats.last);
+        }
+        stats.last = first->last;
+        stats.lastFile = first->lastFile;
+        stats.events += first->events;
+        stats.bytes += first->bytes;
+        if (first->gaps != 0) {
+          stats.gaps += first->gaps;
+          stats.sumGap += first->sumGap;
+          stats.minGap = std::min(stats.minGap, first->minGap);
+          stats.maxGap = std::max(stats.maxGap, first->maxGap);
+        }
+      }
+
+      Histogram::const_iterator f, l = next.histogram_.end();
+      for (f = next.histogram_.begin(); f != l; ++f)
+        histogram_[f->first] += f->second;
+    }
+
+    TypeVector const& types() const { return types_; }
+    Histogram const& histogram() const { return histogram_; }
+
+  protected:
+    //! Statistics of the event type, the previous one is looked up first.
+    TypeStats& find(char const * _domainName, char const * _typeName)
+    {
+      if (hit_ < types_.size() &&
+          types_[hit_].typeName == _typeName && types_[hit_].domainName == _domainName)
+        return types_[hit_];
+
+      for (hit_ = 0; hit_ < types_.size(); ++hit_) {
+        if (types_[hit_].typeName == _typeName && types_[hit_].domainName == _domainName)
+          return types_[hit_];
+      }
+      types_.push_back(TypeStats(_domainName, _typeName));
+      return types_.back();
+    }
+
+    TypeVector types_;
+    Histogram histogram_;
+    //! Position of the previously visited event type.
+    TypeVector::size_type hit_;
+  };
+};
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Client client(argc, argv);
+
+    StringVector files;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, threadsOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          threads = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, rangeOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          rangeSize = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, binOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          binSize = ACE_OS::atoi(arg_shifter.get_current());
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, histogramOpt) == 0) {
+        arg_shifter.consume_arg();
+        histogram = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, bodiesOpt) == 0) {
+        arg_shifter.consume_arg();
+        bodies = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, accessOpt) == 0) {
+        arg_shifter.consume_arg();
+        if (arg_shifter.is_anything_left()) {
+          char const * const pattern = arg_shifter.get_current();
+          if (ACE_OS::strcasecmp(pattern, "normal") == 0)
+            access = Miro::LogReader::NORMAL;
+          else if (ACE_OS::strcasecmp(pattern, "random") == 0)
+            access = Miro::LogReader::RANDOM;
+          else
+            access = Miro::LogReader::SEQUENTIAL;
+          arg_shifter.consume_arg();
+        }
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " [-j <threads>] [-range <events>] [-bin <sec>] [-hist] [-bodies] [-access <pattern>] [-v] <directory|file>..." << std::endl
+                  << "  Report event counts, sizes, rates and gaps per event type of log files." << std::endl
+                  << "  -j <threads>     number of worker threads (default: number of cpus)" << std::endl
+                  << "  -range <events>  number of events scanned at once (default 65536)" << std::endl
+                  << "  -bin <sec>       time bin of the rate histogram (default 1)" << std::endl
+                  << "  -hist            print the rate histogram" << std::endl
+                  << "  -bodies          demarshal the events" << std::endl
+                  << "  -access <pattern> access pattern advised for the log files:" << std::endl
+                  << "                   normal, sequential (default) or random" << std::endl
+                  << "  -v               verbose mode" << std::endl
+                  << "  -?               help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        std::string const path = current_arg;
+        arg_shifter.consume_arg();
+
+        ACE_Dirent dir;
+        if (dir.open(path.c_str()) == 0) {
+          StringVector dirFiles;
+          ACE_DIRENT * entry;
+          while ((entry = dir.read()) != NULL) {
+            std::string const name = entry->d_name;
+            if (isLogFile(name))
+              dirFiles.push_back(path + "/" + name);
+          }
+          std::sort(dirFiles.begin(), dirFiles.end());
+          files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+        }
+        else {
+          files.push_back(path);
+        }
+      }
+    }
+
+    if (files.empty()) {
+      std::cerr << "no log files given. use -? for help." << std::endl;
+      return 1;
+    }
+    if (rangeSize <= 0 || binSize <= 0) {
+      std::cerr << "invalid range or bin size. use -? for help." << std::endl;
+      return 1;
+    }
+
+    ACE_High_Res_Timer timer;
+    timer.start();
+    Miro::LogScanner scanner(files, bodies, rangeSize, access);
+    StatReducer stats;
+    scanner.scan(stats, threads);
+    timer.stop();
+
+    ACE_Time_Value elapsed;
+    timer.elapsed_time(elapsed);
+
+    // per event type
+    ACE_UINT64 bytes = 0;
+    std::cout << std::setw(40) << std::left << "event type" << std::right
+              << std::setw(12) << "events"
+              << std::setw(14) << "bytes"
+              << std::setw(10) << "avg"
+              << std::setw(12) << "rate[1/s]"
+              << std::setw(12) << "gap[ms] min"
+              << std::setw(10) << "mean"
+              << std::setw(10) << "max" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    StatReducer::TypeVector::const_iterator first, last = stats.types().end();
+    for (first = stats.types().begin(); first != last; ++first) {
+      bytes += first->bytes;
+      double const span = msec(first->last - first->first) / 1000.;
+
+      std::cout << std::setw(40) << std::left << (first->domainName + "/" + first->typeName) << std::right
+                << std::setw(12) << first->events
+                << std::setw(14) << first->bytes
+                << std::setw(10) << double(first->bytes) / first->events
+                << std::setw(12) << ((span > 0.)? (first->events - 1) / span : 0.);
+      if (first->gaps != 0) {
+        std::cout << std::setw(12) << msec(first->minGap)
+                  << std::setw(10) << msec(first->sumGap) / first->gaps
+                  << std::setw(10) << msec(first->maxGap);
+      }
+      std::cout << std::endl;
+    }
+
+    // events per time bin
+    if (histogram && !stats.histogram().empty()) {
+      std::cout << std::endl
+                << std::setw(12) << "t[s]" << std::setw(12) << "rate[1/s]" << std::endl;
+      ACE_INT64 const start = stats.histogram().begin()->first;
+      StatReducer::Histogram::const_iterator f, l = stats.histogram().end();
+      for (f = stats.histogram().begin(); f != l; ++f) {
+        std::cout << std::setw(12) << (f->first - start) * binSize
+                  << std::setw(12) << double(f->second) / binSize << std::endl;
+      }
+    }
+
+    std::cout << std::endl
+              << scanner.events() << " events, " << bytes << " bytes in "
+              << files.size() << " log files." << std::endl;
+    if (verbose) {
+      double const sec = msec(elapsed) / 1000.;
+      std::cout << "scanned " << scanner.ranges() << " ranges in " << sec << " sec";
+      if (sec > 0.)
+        std::cout << ", " << bytes / sec / (1024. * 1024.) << " MB/s";
+      std::cout << "." << std::endl;
+    }
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}
@@ -0,0 +1,129 @@
+// -*- c++ -*- ///////////////////////////////////////////////////////////////
+//
+// This file is part of Miro (The Middleware for Robots)
+// Copyright (C) 1999-2013
+// Department of Neural Information Processing, University of Ulm
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation; either version 2, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+#include "miro/LogReader.h"
+#include "miro/Client.h"
+#include "miro/Log.h"
+#include "miro/Exception.h"
+#include "miro/TimeHelper.h"
+
+#include <ace/Arg_Shifter.h>
+#include <ace/OS_NS_unistd.h>
+
+#include <string>
+#include <iostream>
+
+namespace
+{
+  bool follow = false;
+  bool verbose = false;
+
+  char const followOpt[] = "-f";
+  char const verboseOpt[] = "-v";
+  char const helpOpt[] = "-?";
+
+  //! Interval to wait for new events, before checking the writer again.
+  ACE_Time_Value const WAIT_INTERVAL(1, 0);
+};
+
+int
+main(int argc, char *argv[])
+{
+  int rc = 0;
+  try {
+    Miro::Log::init(argc, argv);
+    Miro::Client client(argc, argv);
+
+    std::string file;
+
+    ACE_Arg_Shifter arg_shifter(argc, argv);
+    arg_shifter.ignore_arg(); // program name
+    while (arg_shifter.is_anything_left()) {
+      char const * current_arg = arg_shifter.get_current();
+
+      if (ACE_OS::strcasecmp(current_arg, followOpt) == 0) {
+        arg_shifter.consume_arg();
+        follow = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, verboseOpt) == 0) {
+        arg_shifter.consume_arg();
+        verbose = true;
+      }
+      else if (ACE_OS::strcasecmp(current_arg, helpOpt) == 0) {
+        arg_shifter.consume_arg();
+        std::cout << "usage: " << argv[0] << " [-f] [-v] <file>" << std::endl
+                  << "  List the events of a log file, which may still be written." << std::endl
+                  << "  -f  follow the log file, until the writer closes it" << std::endl
+                  << "  -v  verbose mode" << std::endl
+                  << "  -?  help: emit this text and stop" << std::endl;
+        return 0;
+      }
+      else {
+        file = current_arg;
+        arg_shifter.consume_arg();
+      }
+    }
+
+    if (file.empty()) {
+      std::cerr << "no log file given. use -? for help." << std::endl;
+      return 1;
+    }
+
+    Miro::LogReader reader(file);
+    if (verbose) {
+      std::cerr << file << ": " << reader.events() << " events"
+                << (reader.live()? ", still being written" : "") << std::endl;
+    }
+
+    ACE_UINT32 counter = 0;
+    ACE_Time_Value stamp;
+    CosNotification::FixedEventHeader header;
+
+    while (true) {
+      while (counter < reader.events() &&
+             reader.parseTimeStamp(stamp) &&
+             reader.parseEventHeader(header) &&
+             reader.skipEventBody()) {
+        ++counter;
+        std::cout << stamp << " "
+                  << header.event_type.domain_name.in() << "/"
+                  << header.event_type.type_name.in() << "\n";
+      }
+      std::cout << std::flush;
+
+      if (!follow || !reader.live() || reader.eof())
+        break;
+      reader.wait(WAIT_INTERVAL);
+    }
+
+    if (verbose) {
+      std::cerr << file << ": " << counter << " events listed." << std::endl;
+    }
+  }
+  catch (Miro::Exception const& e) {
+    std::cerr << "Miro exception: " << e << std::endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception const& e) {
+    std::cerr << "Uncaught CORBA exception: " << e << std::endl;
+    rc = 1;
+  }
+  return rc;
+}